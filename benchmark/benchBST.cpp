@@ -0,0 +1,229 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST
+ * Summary:
+ *    Measure custom::BST against std::set for insert (sorted and random
+ *    keys), find (hit and miss), erase, and in-order iteration.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+#include <set>
+#include <string_view>
+
+/**********************************************
+ * ADAPTERS
+ * custom::BST and std::set spell a few things differently.
+ * These let one benchmark body drive both.
+ *********************************************/
+template <typename T>
+static bool insertKey(custom::BST<T>& bst, const T& t)
+{
+   return bst.insert(t, true /*keepUnique*/).second;
+}
+
+template <typename T>
+static bool insertKey(std::set<T>& s, const T& t)
+{
+   return s.insert(t).second;
+}
+
+template <typename C, typename T>
+static void fill(C& c, const std::vector<T>& keys)
+{
+   for (const T& key : keys)
+      insertKey(c, key);
+}
+
+/**********************************************
+ * INSERT
+ * Build a container from empty. Keys arrive in sorted
+ * order (the worst case for rebalancing) or shuffled.
+ *********************************************/
+template <typename C, typename T, bool shuffled>
+static void insert(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffled ? shuffledKeys<T>(n) : sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      C c;
+      fill(c, keys);
+      benchmark::DoNotOptimize(c.size());
+
+      state.PauseTiming();
+      c.clear();
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+static void insertSorted(benchmark::State& state) { insert<C, T, false>(state); }
+
+template <typename C, typename T>
+static void insertRandom(benchmark::State& state) { insert<C, T, true>(state); }
+
+/**********************************************
+ * FIND HIT
+ * Look up every key in the container in random order
+ *********************************************/
+template <typename C, typename T>
+static void findHit(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   C c;
+   fill(c, keys);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const T& key : keys)
+         found += (c.find(key) != c.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * FIND MISS
+ * Look up n keys that fall between the ones in the container
+ *********************************************/
+template <typename C, typename T>
+static void findMiss(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> misses = missingKeys<T>(n);
+   C c;
+   fill(c, shuffledKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const T& key : misses)
+         found += (c.find(key) != c.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * ERASE
+ * Find and erase every key in random order until
+ * the container is empty
+ *********************************************/
+template <typename C, typename T>
+static void erase(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   std::vector<T> order = shuffledKeys<T>(n, 1 /*seed*/);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      C c;
+      fill(c, keys);
+      state.ResumeTiming();
+
+      for (const T& key : order)
+      {
+         auto it = c.find(key);
+         c.erase(it);
+      }
+      benchmark::DoNotOptimize(c.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * ITERATE
+ * Walk the whole container in order
+ *********************************************/
+template <typename C, typename T>
+static void iterate(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   C c;
+   fill(c, shuffledKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      size_t count = 0;
+      for (auto it = c.begin(); it != c.end(); ++it)
+      {
+         benchmark::DoNotOptimize(*it);
+         count++;
+      }
+      benchmark::DoNotOptimize(count);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * FIND VIEW
+ * Look up every key given only a string_view, as a
+ * parser or network buffer would hand it over. Without
+ * a transparent comparator each lookup builds a string
+ *********************************************/
+template <typename C>
+static bool contains(C& c, std::string_view key)
+{
+   return c.find(std::string(key)) != c.end();
+}
+
+static bool contains(custom::BST<std::string, std::less<> >& c, std::string_view key)
+{
+   return c.find(key) != c.end();
+}
+
+static bool contains(std::set<std::string, std::less<> >& c, std::string_view key)
+{
+   return c.find(key) != c.end();
+}
+
+template <typename C>
+static void findView(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<std::string> keys = shuffledKeys<std::string>(n);
+   C c;
+   for (const std::string& key : keys)
+      c.insert(key);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const std::string& key : keys)
+         found += contains(c, std::string_view(key));
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(findView, custom::BST<std::string>)->Name("custom::BST<std::string>/findView")->Apply(sizeSweep);
+BENCHMARK_TEMPLATE(findView, custom::BST<std::string, std::less<> >)->Name("custom::BST<std::string,less<>>/findView")->Apply(sizeSweep);
+BENCHMARK_TEMPLATE(findView, std::set<std::string>)->Name("std::set<std::string>/findView")->Apply(sizeSweep);
+BENCHMARK_TEMPLATE(findView, std::set<std::string, std::less<> >)->Name("std::set<std::string,less<>>/findView")->Apply(sizeSweep);
+
+#define BST_BENCHMARK(function, T)                                               \
+   BENCHMARK_TEMPLATE(function, custom::BST<T>, T)->Name("custom::BST<" #T ">/" #function)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(function, std::set<T>,    T)->Name("std::set<"    #T ">/" #function)->Apply(sizeSweep)
+
+BST_BENCHMARK(insertSorted, int);
+BST_BENCHMARK(insertSorted, std::string);
+BST_BENCHMARK(insertRandom, int);
+BST_BENCHMARK(insertRandom, std::string);
+BST_BENCHMARK(findHit,      int);
+BST_BENCHMARK(findHit,      std::string);
+BST_BENCHMARK(findMiss,     int);
+BST_BENCHMARK(findMiss,     std::string);
+BST_BENCHMARK(erase,        int);
+BST_BENCHMARK(erase,        std::string);
+BST_BENCHMARK(iterate,      int);
+BST_BENCHMARK(iterate,      std::string);
@@ -0,0 +1,140 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST COMPACT
+ * Summary:
+ *    Measure what compact() buys a tree that has aged: one built in
+ *    random order and then churned by erasing and putting back half
+ *    its keys, so its nodes are scattered over the heap. Every key is
+ *    looked up, and the tree is scanned, before and after compact().
+ *    compact() itself, and compact_step() in slices, are timed too.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+/**********************************************
+ * AGED TREE
+ * Random insertion order already puts neighbors
+ * far apart; the churn mixes in the holes left by
+ * erased nodes
+ *********************************************/
+template <typename T>
+static void age(custom::BST<T>& bst, const std::vector<T>& keys)
+{
+   for (const T& key : keys)
+      bst.insert(key, true /*keepUnique*/);
+   std::vector<T> churn = shuffledKeys<T>(keys.size(), 1 /*seed*/);
+   churn.resize(keys.size() / 2);
+   for (const T& key : churn)
+   {
+      auto it = bst.find(key);
+      bst.erase(it);
+   }
+   for (const T& key : churn)
+      bst.insert(key, true /*keepUnique*/);
+}
+
+/**********************************************
+ * FIND and SCAN
+ * On an aged tree, then on the same tree compacted
+ *********************************************/
+template <typename T, bool compacted>
+static void find(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   std::vector<T> lookups = shuffledKeys<T>(n, 2 /*seed*/);
+   custom::BST<T> bst;
+   age(bst, keys);
+   if (compacted)
+      bst.compact();
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const T& key : lookups)
+         found += (bst.find(key) != bst.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T, bool compacted>
+static void scan(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   custom::BST<T> bst;
+   age(bst, keys);
+   if (compacted)
+      bst.compact();
+
+   for (auto _ : state)
+   {
+      size_t count = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+         count++;
+      benchmark::DoNotOptimize(count);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T> static void findAged(benchmark::State& state)     { find<T, false>(state); }
+template <typename T> static void findCompacted(benchmark::State& state) { find<T, true >(state); }
+template <typename T> static void scanAged(benchmark::State& state)     { scan<T, false>(state); }
+template <typename T> static void scanCompacted(benchmark::State& state) { scan<T, true >(state); }
+
+/**********************************************
+ * COMPACT and COMPACT STEP
+ * What the relayout costs, all at once and in
+ * slices of 1024 nodes
+ *********************************************/
+template <typename T>
+static void compact(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   custom::BST<T> bst;
+   age(bst, keys);
+
+   for (auto _ : state)
+   {
+      bst.compact();
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void compactStep(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   custom::BST<T> bst;
+   age(bst, keys);
+
+   for (auto _ : state)
+   {
+      size_t slices = 1;
+      while (!bst.compact_step(1024))
+         slices++;
+      benchmark::DoNotOptimize(slices);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define COMPACT_BENCHMARK(function, T) \
+   BENCHMARK_TEMPLATE(function, T)->Name("custom::BST<" #T ">/" #function)->Apply(sizeSweep)
+
+COMPACT_BENCHMARK(findAged,      int);
+COMPACT_BENCHMARK(findCompacted, int);
+COMPACT_BENCHMARK(scanAged,      int);
+COMPACT_BENCHMARK(scanCompacted, int);
+COMPACT_BENCHMARK(compact,       int);
+COMPACT_BENCHMARK(compactStep,   int);
+COMPACT_BENCHMARK(findAged,      std::string);
+COMPACT_BENCHMARK(findCompacted, std::string);
+COMPACT_BENCHMARK(scanAged,      std::string);
+COMPACT_BENCHMARK(scanCompacted, std::string);
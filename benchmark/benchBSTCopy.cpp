@@ -0,0 +1,113 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST COPY
+ * Summary:
+ *    Measure copying a tree, as taking a snapshot does: the copy
+ *    constructor, assigning over a tree that already has nodes to
+ *    reuse, std::set's copy constructor, and assign_parallel() on a
+ *    growing number of threads. The threaded runs are timed by the
+ *    wall clock, since the work is spread over threads.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+#include <set>
+
+template <typename T>
+static custom::BST<T> makeTree(size_t n)
+{
+   custom::BST<T> bst;
+   for (const T& key : shuffledKeys<T>(n))
+      bst.insert(key, true /*keepUnique*/);
+   return bst;
+}
+
+/**********************************************
+ * COPY CONSTRUCT and ASSIGN OVER
+ *********************************************/
+template <typename T>
+static void copyConstruct(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst = makeTree<T>(n);
+
+   for (auto _ : state)
+   {
+      custom::BST<T> copy(bst);
+      benchmark::DoNotOptimize(copy.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void assignOver(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst = makeTree<T>(n);
+   custom::BST<T> copy(bst);
+
+   for (auto _ : state)
+   {
+      copy = bst;
+      benchmark::DoNotOptimize(copy.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void stdSetCopy(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   std::set<T> set(keys.begin(), keys.end());
+
+   for (auto _ : state)
+   {
+      std::set<T> copy(set);
+      benchmark::DoNotOptimize(copy.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * ASSIGN PARALLEL
+ * Into an empty tree, on 1 to 8 threads
+ *********************************************/
+static void treeAndThreads(benchmark::internal::Benchmark* b)
+{
+   b->ArgNames({ "tree", "threads" });
+   b->ArgsProduct({ { 1 << 16, 1 << 18, 1 << 20 }, { 1, 2, 4, 8 } });
+   b->UseRealTime();
+}
+
+template <typename T>
+static void assignParallel(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   unsigned numThreads = (unsigned)state.range(1);
+   custom::BST<T> bst = makeTree<T>(n);
+
+   for (auto _ : state)
+   {
+      custom::BST<T> copy;
+      copy.assign_parallel(bst, numThreads);
+      benchmark::DoNotOptimize(copy.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define COPY_BENCHMARK(function, T, container) \
+   BENCHMARK_TEMPLATE(function, T)->Name(container "<" #T ">/" #function)->Apply(sizeSweep)
+
+COPY_BENCHMARK(copyConstruct, int,         "custom::BST");
+COPY_BENCHMARK(assignOver,    int,         "custom::BST");
+COPY_BENCHMARK(stdSetCopy,    int,         "std::set");
+COPY_BENCHMARK(copyConstruct, std::string, "custom::BST");
+COPY_BENCHMARK(assignOver,    std::string, "custom::BST");
+COPY_BENCHMARK(stdSetCopy,    std::string, "std::set");
+
+BENCHMARK_TEMPLATE(assignParallel, int        )->Name("custom::BST<int>/assignParallel"        )->Apply(treeAndThreads);
+BENCHMARK_TEMPLATE(assignParallel, std::string)->Name("custom::BST<std::string>/assignParallel")->Apply(treeAndThreads);
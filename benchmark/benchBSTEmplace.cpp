@@ -0,0 +1,142 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST EMPLACE
+ * Summary:
+ *    Measure building a tree of records that are expensive to construct
+ *    (a heap-allocated name and a payload vector) when every key
+ *    arrives twice: insert() of a temporary that is thrown away on a
+ *    duplicate, try_emplace() which only builds the record when it goes
+ *    in, and std::set::emplace(). Then, with every key arriving once,
+ *    emplace() against insert() of a temporary.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+#include <set>
+
+/**********************************************
+ * RECORD
+ * Ordered by name alone. Building one allocates
+ * twice; moving one does not
+ *********************************************/
+struct Record
+{
+   Record(const std::string& name) : name(name), payload(32, 0) {}
+   std::string name;
+   std::vector<int> payload;
+};
+
+struct RecordLess
+{
+   typedef void is_transparent;
+   bool operator () (const Record& lhs, const Record& rhs)           const { return lhs.name < rhs.name; }
+   bool operator () (const Record& lhs, const std::string& rhs)      const { return lhs.name < rhs;      }
+   bool operator () (const std::string& lhs, const Record& rhs)      const { return lhs < rhs.name;      }
+};
+
+typedef custom::BST<Record, RecordLess> RecordTree;
+
+// every key in n/2 keys, twice, in random order
+static std::vector<std::string> keysTwice(size_t n)
+{
+   std::vector<std::string> keys = shuffledKeys<std::string>(n / 2);
+   std::vector<std::string> again = shuffledKeys<std::string>(n / 2, 1 /*seed*/);
+   keys.insert(keys.end(), again.begin(), again.end());
+   std::mt19937 random(232);
+   std::shuffle(keys.begin(), keys.end(), random);
+   return keys;
+}
+
+/**********************************************
+ * INSERT TEMPORARY
+ * What a caller writes without emplace: build the
+ * record, then hand it over
+ *********************************************/
+static void insertTemporary(benchmark::State& state)
+{
+   std::vector<std::string> keys = keysTwice((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      RecordTree tree;
+      for (const std::string& key : keys)
+         tree.insert(Record(key), true /*keepUnique*/);
+      benchmark::DoNotOptimize(tree.size());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/**********************************************
+ * TRY EMPLACE
+ * Descend with the name; build a record only for
+ * the half of the keys that are new
+ *********************************************/
+static void tryEmplace(benchmark::State& state)
+{
+   std::vector<std::string> keys = keysTwice((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      RecordTree tree;
+      for (const std::string& key : keys)
+         tree.try_emplace(key);
+      benchmark::DoNotOptimize(tree.size());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/**********************************************
+ * STD SET EMPLACE
+ * Builds the node first, and frees it again when
+ * the key turns out to be there
+ *********************************************/
+static void stdSetEmplace(benchmark::State& state)
+{
+   std::vector<std::string> keys = keysTwice((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      std::set<Record, RecordLess> tree;
+      for (const std::string& key : keys)
+         tree.emplace(key);
+      benchmark::DoNotOptimize(tree.size());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/**********************************************
+ * UNIQUE KEYS: INSERT TEMPORARY and EMPLACE
+ * Every key is new, so every record is built;
+ * emplace saves only the move into the node
+ *********************************************/
+static void insertTemporaryUnique(benchmark::State& state)
+{
+   std::vector<std::string> keys = shuffledKeys<std::string>((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      RecordTree tree;
+      for (const std::string& key : keys)
+         tree.insert(Record(key));
+      benchmark::DoNotOptimize(tree.size());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void emplaceUnique(benchmark::State& state)
+{
+   std::vector<std::string> keys = shuffledKeys<std::string>((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      RecordTree tree;
+      for (const std::string& key : keys)
+         tree.emplace(key);
+      benchmark::DoNotOptimize(tree.size());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+BENCHMARK(insertTemporary      )->Name("custom::BST<Record>/insertTemporary"      )->Apply(sizeSweep);
+BENCHMARK(tryEmplace           )->Name("custom::BST<Record>/tryEmplace"           )->Apply(sizeSweep);
+BENCHMARK(stdSetEmplace        )->Name("std::set<Record>/emplace"                 )->Apply(sizeSweep);
+BENCHMARK(insertTemporaryUnique)->Name("custom::BST<Record>/insertTemporaryUnique")->Apply(sizeSweep);
+BENCHMARK(emplaceUnique        )->Name("custom::BST<Record>/emplaceUnique"        )->Apply(sizeSweep);
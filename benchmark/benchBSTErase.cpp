@@ -0,0 +1,120 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST ERASE
+ * Summary:
+ *    Measure the expiry sweep of a tree of deadlines: take out every
+ *    entry due before now, as one erase() of the range and as a loop
+ *    of erase(begin()). Then the sweep where the expired entries are
+ *    scattered through the tree (a flag, not the key, says they are
+ *    done), as one erase_if() and as a loop of erase(it).
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+// a tenth of the entries go in each sweep
+static const int expireEvery = 10;
+
+static custom::BST<int> deadlines(const std::vector<int>& keys)
+{
+   custom::BST<int> bst;
+   for (int key : keys)
+      bst.insert(key);
+   return bst;
+}
+
+/**********************************************
+ * SWEEP RANGE and SWEEP LOOP
+ * The oldest tenth of the deadlines are due
+ *********************************************/
+static void sweepRange(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<int> keys = shuffledKeys<int>(n);
+   int now = makeKey<int>(2 * (n / expireEvery));
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      custom::BST<int> bst = deadlines(keys);
+      state.ResumeTiming();
+
+      bst.erase(bst.begin(), bst.lower_bound(now));
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetItemsProcessed(state.iterations() * (n / expireEvery));
+}
+
+static void sweepLoop(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<int> keys = shuffledKeys<int>(n);
+   int now = makeKey<int>(2 * (n / expireEvery));
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      custom::BST<int> bst = deadlines(keys);
+      state.ResumeTiming();
+
+      for (auto it = bst.begin(); it != bst.end() && *it < now; )
+         it = bst.erase(it);
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetItemsProcessed(state.iterations() * (n / expireEvery));
+}
+
+/**********************************************
+ * SWEEP IF and SWEEP IF LOOP
+ * A tenth of the entries, spread over the whole
+ * tree, are due
+ *********************************************/
+static bool isExpired(int key)
+{
+   return key / 2 % expireEvery == 0;
+}
+
+static void sweepIf(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<int> keys = shuffledKeys<int>(n);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      custom::BST<int> bst = deadlines(keys);
+      state.ResumeTiming();
+
+      bst.erase_if(isExpired);
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void sweepIfLoop(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<int> keys = shuffledKeys<int>(n);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      custom::BST<int> bst = deadlines(keys);
+      state.ResumeTiming();
+
+      for (auto it = bst.begin(); it != bst.end(); )
+         if (isExpired(*it))
+            it = bst.erase(it);
+         else
+            ++it;
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(sweepRange )->Name("custom::BST<int>/sweepRange" )->Apply(sizeSweep);
+BENCHMARK(sweepLoop  )->Name("custom::BST<int>/sweepLoop"  )->Apply(sizeSweep);
+BENCHMARK(sweepIf    )->Name("custom::BST<int>/sweepIf"    )->Apply(sizeSweep);
+BENCHMARK(sweepIfLoop)->Name("custom::BST<int>/sweepIfLoop")->Apply(sizeSweep);
@@ -0,0 +1,92 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST FIND MANY
+ * Summary:
+ *    Measure BST::find_many() against a loop of find() calls, looking
+ *    up every key in a tree batch by batch, across tree sizes (from
+ *    fitting in cache to well past it) and batch sizes.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+/**********************************************
+ * BATCH
+ * A window onto the keys, so batches cost no copying
+ *********************************************/
+template <typename T>
+struct Batch
+{
+   const T * p;
+   size_t num;
+   size_t size() const                   { return num;  }
+   const T & operator [] (size_t i) const { return p[i]; }
+};
+
+static void treeAndBatchSizes(benchmark::internal::Benchmark* b)
+{
+   b->ArgNames({ "tree", "batch" });
+   b->ArgsProduct({ { 1 << 12, 1 << 15, 1 << 18, 1 << 20 }, { 1, 4, 16, 64, 256 } });
+}
+
+/**********************************************
+ * FIND LOOP
+ * One find() per key, as a handler does today
+ *********************************************/
+template <typename T>
+static void findLoop(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   size_t batch = (size_t)state.range(1);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   std::vector<T> lookups = shuffledKeys<T>(n, 1 /*seed*/);
+   custom::BST<T> bst;
+   for (const T& key : keys)
+      bst.insert(key, true /*keepUnique*/);
+   std::vector<typename custom::BST<T>::iterator> out;
+   out.reserve(batch);
+
+   for (auto _ : state)
+      for (size_t first = 0; first + batch <= n; first += batch)
+      {
+         out.clear();
+         for (size_t i = first; i < first + batch; i++)
+            out.push_back(bst.find(lookups[i]));
+         benchmark::DoNotOptimize(out.data());
+      }
+   state.SetItemsProcessed(state.iterations() * (n / batch * batch));
+}
+
+/**********************************************
+ * FIND MANY
+ * The same batches, each in one call
+ *********************************************/
+template <typename T>
+static void findMany(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   size_t batch = (size_t)state.range(1);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   std::vector<T> lookups = shuffledKeys<T>(n, 1 /*seed*/);
+   custom::BST<T> bst;
+   for (const T& key : keys)
+      bst.insert(key, true /*keepUnique*/);
+   std::vector<typename custom::BST<T>::iterator> out;
+   out.reserve(batch);
+
+   for (auto _ : state)
+      for (size_t first = 0; first + batch <= n; first += batch)
+      {
+         out.clear();
+         bst.find_many(Batch<T>{ &lookups[first], batch }, out);
+         benchmark::DoNotOptimize(out.data());
+      }
+   state.SetItemsProcessed(state.iterations() * (n / batch * batch));
+}
+
+BENCHMARK_TEMPLATE(findLoop, int        )->Name("custom::BST<int>/findLoop"        )->Apply(treeAndBatchSizes);
+BENCHMARK_TEMPLATE(findMany, int        )->Name("custom::BST<int>/findMany"        )->Apply(treeAndBatchSizes);
+BENCHMARK_TEMPLATE(findLoop, std::string)->Name("custom::BST<std::string>/findLoop")->Apply(treeAndBatchSizes);
+BENCHMARK_TEMPLATE(findMany, std::string)->Name("custom::BST<std::string>/findMany")->Apply(treeAndBatchSizes);
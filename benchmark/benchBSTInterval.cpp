@@ -0,0 +1,117 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST INTERVAL
+ * Summary:
+ *    Measure the interval tree, a BST of intervals: stabbing queries and
+ *    overlap queries against a scan of every interval, from a tree that
+ *    fits in cache up to ten million intervals. Intervals are spread so
+ *    that a query finds a handful whatever the size, so the time is the
+ *    search and not the copying out.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+typedef custom::interval<long> Interval;
+typedef custom::BST<Interval> IntervalTree;
+
+static void intervalSizes(benchmark::internal::Benchmark* b)
+{
+   b->Arg(1 << 16)->Arg(1 << 20)->Arg(10000000)->Unit(benchmark::kMicrosecond);
+}
+
+/**********************************************
+ * RANDOM INTERVALS
+ * Starts spread over 64 points per interval, most
+ * short and one in a hundred a hundred times longer
+ *********************************************/
+static std::vector<Interval> randomIntervals(size_t n)
+{
+   std::mt19937 random(232);
+   std::vector<Interval> intervals;
+   intervals.reserve(n);
+   for (size_t i = 0; i < n; i++)
+   {
+      long lo = (long)(random() % (n * 64));
+      long length = (long)(random() % 512);
+      if (random() % 100 == 0)
+         length *= 100;
+      intervals.push_back(Interval{ lo, lo + length });
+   }
+   return intervals;
+}
+
+static void fill(IntervalTree & tree, std::vector<Interval> intervals)
+{
+   std::sort(intervals.begin(), intervals.end());
+   size_t i = 0;
+   tree.assign_sorted(intervals.size(), [&]() { return intervals[i++]; });
+}
+
+static std::vector<long> randomPoints(size_t n, size_t num)
+{
+   std::mt19937 random(1);
+   std::vector<long> points;
+   for (size_t i = 0; i < num; i++)
+      points.push_back((long)(random() % (n * 64)));
+   return points;
+}
+
+/**********************************************
+ * STAB and OVERLAP
+ * Every interval holding a random point, or
+ * sharing any point with a window 1024 wide
+ *********************************************/
+template <long width>
+static void treeQuery(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   IntervalTree tree;
+   fill(tree, randomIntervals(n));
+   std::vector<long> points = randomPoints(n, 1024);
+   std::vector<IntervalTree::iterator> out;
+   size_t found = 0;
+
+   for (auto _ : state)
+      for (long point : points)
+      {
+         out.clear();
+         tree.find_overlapping(point, point + width, out);
+         found += out.size();
+         benchmark::DoNotOptimize(out.data());
+      }
+   state.SetItemsProcessed(state.iterations() * points.size());
+   state.counters["found"] = (double)found / (state.iterations() * points.size());
+}
+
+/**********************************************
+ * SCAN
+ * What we had before: check every interval, here
+ * in a vector so the scan is as fast as it gets
+ *********************************************/
+template <long width>
+static void scanQuery(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<Interval> intervals = randomIntervals(n);
+   std::vector<long> points = randomPoints(n, 16);
+   std::vector<const Interval *> out;
+
+   for (auto _ : state)
+      for (long point : points)
+      {
+         out.clear();
+         for (const Interval & i : intervals)
+            if (!(i.hi < point) && !(point + width < i.lo))
+               out.push_back(&i);
+         benchmark::DoNotOptimize(out.data());
+      }
+   state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+BENCHMARK_TEMPLATE(treeQuery, 0   )->Name("custom::BST<interval>/stab"   )->Apply(intervalSizes);
+BENCHMARK_TEMPLATE(scanQuery, 0   )->Name("std::vector<interval>/stab"   )->Apply(intervalSizes);
+BENCHMARK_TEMPLATE(treeQuery, 1024)->Name("custom::BST<interval>/overlap")->Apply(intervalSizes);
+BENCHMARK_TEMPLATE(scanQuery, 1024)->Name("std::vector<interval>/overlap")->Apply(intervalSizes);
@@ -0,0 +1,137 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST NODE
+ * Summary:
+ *    Measure what the BNode layout costs: heap bytes per element, and
+ *    the speed of insert, find, and iteration. The layout is chosen when
+ *    bst.h is compiled, so this file is built once per layout
+ *    (BST_COMPACT_NODE, BST_INDEX_NODE, or neither) and each executable
+ *    names its layout in the benchmark names.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+#include <malloc.h>   // for mallinfo2
+
+#if defined(BST_INDEX_NODE)
+#define LAYOUT "index"
+#elif defined(BST_COMPACT_NODE)
+#define LAYOUT "compact"
+#else
+#define LAYOUT "pointer"
+#endif
+
+/**********************************************
+ * HEAP IN USE
+ * Bytes the allocator has handed out, counting
+ * its own per-block overhead
+ *********************************************/
+static size_t heapInUse()
+{
+   struct mallinfo2 info = mallinfo2();
+   return info.uordblks + info.hblkhd;
+}
+
+template <typename T>
+static void fill(custom::BST<T>& bst, const std::vector<T>& keys)
+{
+   for (const T& key : keys)
+      bst.insert(key, true /*keepUnique*/);
+}
+
+/**********************************************
+ * MEMORY
+ * Build a tree of n and report the heap it took per
+ * element, the key's own allocations included. The
+ * index layout's pool outlives the tree, so this has
+ * to be the first tree of its type the program builds:
+ * it runs once, at one size. The pool grows in doubling
+ * chunks, so part of what it reports is slack
+ *********************************************/
+template <typename T>
+static void memory(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   double bytes = 0.0;
+
+   for (auto _ : state)
+   {
+      size_t before = heapInUse();
+      custom::BST<T> bst;
+      fill(bst, keys);
+      bytes = (double)(heapInUse() - before) / n;
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.counters["bytesPerElement"] = bytes;
+   state.counters["sizeofData"] = (double)sizeof(T);
+}
+
+/**********************************************
+ * INSERT, FIND, and ITERATE
+ *********************************************/
+template <typename T>
+static void insertRandom(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      custom::BST<T> bst;
+      fill(bst, keys);
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void findHit(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   custom::BST<T> bst;
+   fill(bst, keys);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const T& key : keys)
+         found += (bst.find(key) != bst.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void iterate(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst;
+   fill(bst, shuffledKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      size_t count = 0;
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+      {
+         benchmark::DoNotOptimize(*it);
+         count++;
+      }
+      benchmark::DoNotOptimize(count);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define NODE_BENCHMARK(function, T) \
+   BENCHMARK_TEMPLATE(function, T)->Name(LAYOUT "/BST<" #T ">/" #function)->Apply(sizeSweep)
+
+BENCHMARK_TEMPLATE(memory, int        )->Name(LAYOUT "/BST<int>/memory"        )->Arg(1 << 18)->Iterations(1);
+BENCHMARK_TEMPLATE(memory, std::string)->Name(LAYOUT "/BST<std::string>/memory")->Arg(1 << 18)->Iterations(1);
+NODE_BENCHMARK(insertRandom, int);
+NODE_BENCHMARK(findHit,      int);
+NODE_BENCHMARK(findHit,      std::string);
+NODE_BENCHMARK(iterate,      int);
@@ -0,0 +1,108 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST SCAN
+ * Summary:
+ *    Measure a full in-order pass over a BST four ways: the iterator,
+ *    which climbs parent pointers; the stack-based scanner; for_each;
+ *    and scanner::collect copying batches into a custom::vector.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "vector.h"
+
+template <typename T>
+static void fill(custom::BST<T>& bst, size_t n)
+{
+   for (const T& key : shuffledKeys<T>(n))
+      bst.insert(key, true /*keepUnique*/);
+}
+
+/**********************************************
+ * ITERATOR
+ *********************************************/
+template <typename T>
+static void scanIterator(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst;
+   fill(bst, n);
+
+   for (auto _ : state)
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+         benchmark::DoNotOptimize(*it);
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * SCANNER
+ *********************************************/
+template <typename T>
+static void scanScanner(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst;
+   fill(bst, n);
+
+   for (auto _ : state)
+      for (typename custom::BST<T>::scanner it(bst); !it.done(); ++it)
+         benchmark::DoNotOptimize(*it);
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * FOR EACH
+ *********************************************/
+template <typename T>
+static void scanForEach(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst;
+   fill(bst, n);
+
+   for (auto _ : state)
+      bst.for_each([](const T& t) { benchmark::DoNotOptimize(t); });
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * COLLECT
+ * Copy the tree out 256 elements at a time, the
+ * way a consumer working in batches would
+ *********************************************/
+template <typename T>
+static void scanCollect(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst;
+   fill(bst, n);
+   custom::vector<T> batch;
+   batch.reserve(256);
+
+   for (auto _ : state)
+   {
+      typename custom::BST<T>::scanner it(bst);
+      do
+      {
+         batch.clear();
+         it.collect(batch, 256);
+         benchmark::DoNotOptimize(&batch[0]);
+      }
+      while (!it.done());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define SCAN_BENCHMARK(function, T) \
+   BENCHMARK_TEMPLATE(function, T)->Name("custom::BST<" #T ">/" #function)->Apply(sizeSweep)
+
+SCAN_BENCHMARK(scanIterator, int);
+SCAN_BENCHMARK(scanScanner,  int);
+SCAN_BENCHMARK(scanForEach,  int);
+SCAN_BENCHMARK(scanCollect,  int);
+SCAN_BENCHMARK(scanIterator, std::string);
+SCAN_BENCHMARK(scanScanner,  std::string);
+SCAN_BENCHMARK(scanForEach,  std::string);
+SCAN_BENCHMARK(scanCollect,  std::string);
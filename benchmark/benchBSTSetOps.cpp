@@ -0,0 +1,131 @@
+/***********************************************************************
+ * Source:
+ *    BENCH BST SET OPS
+ * Summary:
+ *    Measure the join-based union, intersection, and difference on BST
+ *    against doing the same work one element at a time with insert,
+ *    find, and erase, for two trees of the same size and for a small
+ *    tree against a large one, with and without the parallel split.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+
+/**********************************************
+ * OPERANDS
+ * A holds range(0) even keys. B holds range(1) keys,
+ * half of them in A and half of them missing
+ *********************************************/
+template <typename T>
+static void fill(custom::BST<T>& a, custom::BST<T>& b, size_t n, size_t m)
+{
+   std::vector<T> hits = shuffledKeys<T>(n);
+   std::vector<T> misses = missingKeys<T>(n);
+   for (const T& key : hits)
+      a.insert(key, true /*keepUnique*/);
+   for (size_t i = 0; i < m; i++)
+      b.insert(i % 2 ? misses[i / 2] : hits[i / 2], true /*keepUnique*/);
+}
+
+/**********************************************
+ * OPERATIONS
+ * Bulk uses the join-based member functions, which
+ * consume B; OneByOne walks B and changes A one
+ * element at a time
+ *********************************************/
+template <bool parallel>
+struct Bulk
+{
+   template <typename T>
+   static void unite(custom::BST<T>& a, custom::BST<T>& b)     { a.merge(b, parallel);     }
+   template <typename T>
+   static void intersect(custom::BST<T>& a, custom::BST<T>& b) { a.intersect(b, parallel); }
+   template <typename T>
+   static void subtract(custom::BST<T>& a, custom::BST<T>& b)  { a.subtract(b, parallel);  }
+};
+
+struct OneByOne
+{
+   template <typename T>
+   static void unite(custom::BST<T>& a, custom::BST<T>& b)
+   {
+      for (auto it = b.begin(); it != b.end(); ++it)
+         a.insert(*it, true /*keepUnique*/);
+   }
+   template <typename T>
+   static void intersect(custom::BST<T>& a, custom::BST<T>& b)
+   {
+      custom::BST<T> result;
+      for (auto it = b.begin(); it != b.end(); ++it)
+         if (a.find(*it) != a.end())
+            result.insert(*it, true /*keepUnique*/);
+      a = std::move(result);
+   }
+   template <typename T>
+   static void subtract(custom::BST<T>& a, custom::BST<T>& b)
+   {
+      for (auto it = b.begin(); it != b.end(); ++it)
+      {
+         auto itA = a.find(*it);
+         if (itA != a.end())
+            a.erase(itA);
+      }
+   }
+};
+
+/**********************************************
+ * UNITE, INTERSECT, and SUBTRACT
+ * Only the operation is timed; the trees are
+ * rebuilt outside the clock
+ *********************************************/
+#define SET_OP_BENCHMARK_FUNCTION(op)                                          \
+   template <typename Op, typename T>                                          \
+   static void op(benchmark::State& state)                                     \
+   {                                                                           \
+      size_t n = (size_t)state.range(0);                                      \
+      size_t m = (size_t)state.range(1);                                      \
+      for (auto _ : state)                                                     \
+      {                                                                        \
+         state.PauseTiming();                                                  \
+         custom::BST<T> a;                                                     \
+         custom::BST<T> b;                                                     \
+         fill(a, b, n, m);                                                     \
+         state.ResumeTiming();                                                 \
+         Op::op(a, b);                                                         \
+         benchmark::DoNotOptimize(a.size());                                   \
+         state.PauseTiming();                                                  \
+         a.clear();                                                            \
+         b.clear();                                                            \
+         state.ResumeTiming();                                                 \
+      }                                                                        \
+      state.SetItemsProcessed(state.iterations() * (n + m));                   \
+   }
+
+SET_OP_BENCHMARK_FUNCTION(unite)
+SET_OP_BENCHMARK_FUNCTION(intersect)
+SET_OP_BENCHMARK_FUNCTION(subtract)
+
+/**********************************************
+ * SHAPES
+ * Equal sizes, and a small B against a large A
+ * where the bulk operations should pull ahead
+ *********************************************/
+static void shapes(benchmark::internal::Benchmark* b)
+{
+   b->ArgNames({ "n", "m" });
+   for (int n : { 1 << 12, 1 << 15, 1 << 18 })
+      b->Args({ n, n })->Args({ n, n / 256 });
+   b->Unit(benchmark::kMicrosecond);
+}
+
+#define SET_OP_BENCHMARK(function, T)                                            \
+   BENCHMARK_TEMPLATE(function, Bulk<false>, T)->Name("custom::BST<" #T ">/" #function)->Apply(shapes); \
+   BENCHMARK_TEMPLATE(function, Bulk<true>,  T)->Name("custom::BST<" #T ">/" #function "Parallel")->Apply(shapes)->UseRealTime(); \
+   BENCHMARK_TEMPLATE(function, OneByOne,    T)->Name("custom::BST<" #T ">/" #function "OneByOne")->Apply(shapes)
+
+SET_OP_BENCHMARK(unite,     int);
+SET_OP_BENCHMARK(unite,     std::string);
+SET_OP_BENCHMARK(intersect, int);
+SET_OP_BENCHMARK(subtract,  int);
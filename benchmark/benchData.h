@@ -0,0 +1,102 @@
+/***********************************************************************
+ * Header:
+ *    BENCH DATA
+ * Summary:
+ *    Shared helpers for the container benchmarks: the size sweep every
+ *    benchmark runs across and key generators for each element type.
+ *
+ *    This will contain:
+ *        sizeSweep()      : The range of container sizes to measure
+ *        makeKey()        : The i'th key of a given type
+ *        sortedKeys()     : n distinct keys in increasing order
+ *        shuffledKeys()   : n distinct keys in random order
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <algorithm>   // for std::shuffle
+#include <cstdio>      // for snprintf
+#include <random>      // for std::mt19937
+#include <string>
+#include <vector>
+
+/**********************************************
+ * SIZE SWEEP
+ * Every container benchmark runs from a few hundred
+ * elements (fits in L1) up to a quarter million
+ * (well past the last level cache)
+ *********************************************/
+inline void sizeSweep(benchmark::internal::Benchmark* b)
+{
+   b->RangeMultiplier(8)->Range(1 << 8, 1 << 18);
+}
+
+/**********************************************
+ * MAKE KEY
+ * The i'th key in increasing order. Keys made from even
+ * numbers are the ones we insert; odd ones are guaranteed misses.
+ * Strings are long enough to defeat the small string optimization
+ *********************************************/
+template <typename T>
+T makeKey(size_t i);
+
+template <>
+inline int makeKey<int>(size_t i)
+{
+   return (int)i;
+}
+
+template <>
+inline std::string makeKey<std::string>(size_t i)
+{
+   char buffer[48];  // room for "benchmark-key-" and any size_t
+   snprintf(buffer, sizeof(buffer), "benchmark-key-%010zu", i);
+   return std::string(buffer);
+}
+
+/**********************************************
+ * SORTED KEYS
+ * n distinct keys in increasing order (only even numbers)
+ *********************************************/
+template <typename T>
+std::vector<T> sortedKeys(size_t n)
+{
+   std::vector<T> keys;
+   keys.reserve(n);
+   for (size_t i = 0; i < n; i++)
+      keys.push_back(makeKey<T>(2 * i));
+   return keys;
+}
+
+/**********************************************
+ * SHUFFLED KEYS
+ * The same keys as sortedKeys() but in a random order.
+ * The seed is fixed so every run sees the same data
+ *********************************************/
+template <typename T>
+std::vector<T> shuffledKeys(size_t n, unsigned seed = 232)
+{
+   std::vector<T> keys = sortedKeys<T>(n);
+   std::mt19937 random(seed);
+   std::shuffle(keys.begin(), keys.end(), random);
+   return keys;
+}
+
+/**********************************************
+ * MISSING KEYS
+ * n keys that sortedKeys(n) will never contain, shuffled
+ *********************************************/
+template <typename T>
+std::vector<T> missingKeys(size_t n, unsigned seed = 235)
+{
+   std::vector<T> keys;
+   keys.reserve(n);
+   for (size_t i = 0; i < n; i++)
+      keys.push_back(makeKey<T>(2 * i + 1));
+   std::mt19937 random(seed);
+   std::shuffle(keys.begin(), keys.end(), random);
+   return keys;
+}
@@ -0,0 +1,188 @@
+/***********************************************************************
+ * Source:
+ *    BENCH DISK B-TREE
+ * Summary:
+ *    Measure custom::disk_btree in a file in the temporary directory:
+ *    bulk loading, random inserts, random finds and a full scan, each
+ *    with a page cache far smaller than the file and with one that holds
+ *    all of it. Besides the time, every benchmark reports the pages read
+ *    and written per element, which is the I/O the tree asks of the file
+ *    whether or not the operating system's cache then satisfies it. An
+ *    in-memory custom::BST finding the same keys is there for scale.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "diskBTree.h"
+
+#include <cstdio>      // for std::remove
+#include <filesystem>  // for std::filesystem::temp_directory_path
+
+typedef custom::disk_btree<long> DiskTree;
+
+// 256 pages is 1MB of cache; 65536 pages is 256MB, more than any file here
+static void keysAndCache(benchmark::internal::Benchmark* b)
+{
+   b->ArgNames({ "keys", "cache" });
+   b->ArgsProduct({ { 1 << 20, 1 << 23 }, { 256, 65536 } });
+   b->Unit(benchmark::kMillisecond);
+}
+
+/**********************************************
+ * TREE FILE
+ * A fresh file for each benchmark, removed after
+ *********************************************/
+struct TreeFile
+{
+   TreeFile() : path((std::filesystem::temp_directory_path() / "benchDiskBTree.db").string())
+   {
+      std::remove(path.c_str());
+   }
+  ~TreeFile() { std::remove(path.c_str()); }
+   std::string path;
+};
+
+static std::vector<long> shuffledLongs(size_t n, unsigned seed = 232)
+{
+   std::vector<long> keys;
+   keys.reserve(n);
+   for (int key : shuffledKeys<int>(n, seed))
+      keys.push_back((long)key);
+   return keys;
+}
+
+static void load(DiskTree & tree, size_t n)
+{
+   long key = 0;
+   tree.assign_sorted(n, [&key]() { long k = key; key += 2; return k; });
+   tree.flush();
+}
+
+static void reportIO(benchmark::State& state, const DiskTree & tree, size_t numOps)
+{
+   double num = (double)numOps;
+   state.counters["reads/op"]  = (double)tree.stats().reads / num;
+   state.counters["writes/op"] = (double)tree.stats().writes / num;
+   state.SetItemsProcessed((int64_t)numOps);
+}
+
+/**********************************************
+ * BULK LOAD
+ * Sorted keys into an empty file, written out
+ * and synced
+ *********************************************/
+static void bulkLoad(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   TreeFile file;
+   DiskTree tree(file.path, (size_t)state.range(1));
+   tree.resetStats();
+   for (auto _ : state)
+      load(tree, n);
+   reportIO(state, tree, state.iterations() * n);
+}
+
+/**********************************************
+ * INSERT RANDOM
+ * Every key, in random order, into an empty file,
+ * then flushed. Only the first million: a small
+ * cache makes this seconds per million
+ *********************************************/
+static void insertRandom(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<long> keys = shuffledLongs(n);
+   TreeFile file;
+   DiskTree tree(file.path, (size_t)state.range(1));
+   tree.resetStats();
+   for (auto _ : state)
+   {
+      tree.clear();
+      for (long key : keys)
+         tree.insert(key);
+      tree.flush();
+   }
+   reportIO(state, tree, state.iterations() * n);
+   state.counters["height"] = (double)tree.height();
+}
+
+/**********************************************
+ * FIND RANDOM
+ * Every key in random order in a loaded tree
+ *********************************************/
+static void findRandom(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<long> lookups = shuffledLongs(n, 1 /*seed*/);
+   for (long & key : lookups)
+      key *= 2;
+   TreeFile file;
+   DiskTree tree(file.path, (size_t)state.range(1));
+   load(tree, n);
+   tree.resetStats();
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (long key : lookups)
+         found += (tree.find(key) != tree.end());
+      benchmark::DoNotOptimize(found);
+   }
+   reportIO(state, tree, state.iterations() * n);
+}
+
+/**********************************************
+ * SCAN
+ * Every element in order along the leaf chain
+ *********************************************/
+static void scan(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   TreeFile file;
+   DiskTree tree(file.path, (size_t)state.range(1));
+   load(tree, n);
+   tree.resetStats();
+
+   for (auto _ : state)
+   {
+      long sum = 0;
+      for (DiskTree::iterator it = tree.begin(); it != tree.end(); ++it)
+         sum += *it;
+      benchmark::DoNotOptimize(sum);
+   }
+   reportIO(state, tree, state.iterations() * n);
+}
+
+/**********************************************
+ * BST FIND RANDOM
+ * The same lookups in memory
+ *********************************************/
+static void bstFindRandom(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<long> lookups = shuffledLongs(n, 1 /*seed*/);
+   for (long & key : lookups)
+      key *= 2;
+   custom::BST<long> bst;
+   long key = 0;
+   bst.assign_sorted(n, [&key]() { long k = key; key += 2; return k; });
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (long key : lookups)
+         found += (bst.find(key) != bst.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(bulkLoad    )->Name("custom::disk_btree/bulkLoad"  )->Apply(keysAndCache);
+BENCHMARK(insertRandom)->Name("custom::disk_btree/insertRandom")
+   ->ArgNames({ "keys", "cache" })->ArgsProduct({ { 1 << 20 }, { 256, 65536 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(findRandom  )->Name("custom::disk_btree/findRandom")->Apply(keysAndCache);
+BENCHMARK(scan        )->Name("custom::disk_btree/scan"      )->Apply(keysAndCache);
+BENCHMARK(bstFindRandom)->Name("custom::BST<long>/findRandom")
+   ->ArgNames({ "keys" })->Arg(1 << 20)->Arg(1 << 23)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,176 @@
+/***********************************************************************
+ * Source:
+ *    BENCH HASH
+ * Summary:
+ *    Measure custom::unordered_map against std::unordered_map and
+ *    against the keyed container we had before it, a custom::BST of
+ *    pairs ordered by key, for insert (with and without reserve), find
+ *    (hit and miss), and erase.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "hash.h"
+
+#include <unordered_map>
+
+/**********************************************
+ * BST MAP
+ * There is no custom::map, so a BST of pairs with a
+ * transparent comparator on the key stands in for one
+ *********************************************/
+template <typename K>
+struct KeyLess
+{
+   typedef void is_transparent;
+   typedef std::pair<K, int> P;
+   bool operator () (const P& lhs, const P& rhs) const { return lhs.first < rhs.first; }
+   bool operator () (const P& lhs, const K& rhs) const { return lhs.first < rhs;       }
+   bool operator () (const K& lhs, const P& rhs) const { return lhs < rhs.first;       }
+};
+
+template <typename K>
+using BSTMap = custom::BST<std::pair<K, int>, KeyLess<K> >;
+
+/**********************************************
+ * ADAPTERS
+ *********************************************/
+template <typename M, typename K>
+static void insertKey(M& m, const K& key, int value)
+{
+   m.insert(std::make_pair(key, value));
+}
+
+template <typename K>
+static void insertKey(BSTMap<K>& m, const K& key, int value)
+{
+   m.insert(std::make_pair(key, value), true /*keepUnique*/);
+}
+
+template <typename M>
+static void reserve(M& m, size_t n)
+{
+   m.reserve(n);
+}
+
+template <typename K>
+static void reserve(BSTMap<K>&, size_t)
+{
+}
+
+template <typename M, typename K>
+static void fill(M& m, const std::vector<K>& keys)
+{
+   int value = 0;
+   for (const K& key : keys)
+      insertKey(m, key, value++);
+}
+
+/**********************************************
+ * INSERT
+ * Build a map from empty, growing as it goes or
+ * with the room reserved up front
+ *********************************************/
+template <typename M, typename K, bool reserved>
+static void insert(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<K> keys = shuffledKeys<K>(n);
+
+   for (auto _ : state)
+   {
+      M m;
+      if (reserved)
+         reserve(m, n);
+      fill(m, keys);
+      benchmark::DoNotOptimize(m.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename M, typename K>
+static void insertGrow(benchmark::State& state) { insert<M, K, false>(state); }
+
+template <typename M, typename K>
+static void insertReserved(benchmark::State& state) { insert<M, K, true>(state); }
+
+/**********************************************
+ * FIND HIT and FIND MISS
+ *********************************************/
+template <typename M, typename K>
+static void find(benchmark::State& state, const std::vector<K>& keys, const std::vector<K>& lookups)
+{
+   M m;
+   fill(m, keys);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const K& key : lookups)
+         found += (m.find(key) != m.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+template <typename M, typename K>
+static void findHit(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   find<M, K>(state, shuffledKeys<K>(n), shuffledKeys<K>(n, 1 /*seed*/));
+}
+
+template <typename M, typename K>
+static void findMiss(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   find<M, K>(state, shuffledKeys<K>(n), missingKeys<K>(n));
+}
+
+/**********************************************
+ * ERASE
+ * Find and erase every key in random order until
+ * the map is empty
+ *********************************************/
+template <typename M, typename K>
+static void erase(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<K> keys = shuffledKeys<K>(n);
+   std::vector<K> order = shuffledKeys<K>(n, 1 /*seed*/);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      M m;
+      fill(m, keys);
+      state.ResumeTiming();
+
+      for (const K& key : order)
+      {
+         auto it = m.find(key);
+         m.erase(it);
+      }
+      benchmark::DoNotOptimize(m.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define COMMA ,
+#define HASH_BENCHMARK(function, K)                                                                                        \
+   BENCHMARK_TEMPLATE(function, custom::unordered_map<K COMMA int>, K)->Name("custom::unordered_map<" #K ">/" #function)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(function, std::unordered_map<K COMMA int>, K)->Name("std::unordered_map<" #K ">/" #function)->Apply(sizeSweep);       \
+   BENCHMARK_TEMPLATE(function, BSTMap<K>, K)->Name("custom::BST<pair<" #K ">>/" #function)->Apply(sizeSweep)
+
+HASH_BENCHMARK(insertGrow,     int);
+HASH_BENCHMARK(insertGrow,     std::string);
+HASH_BENCHMARK(insertReserved, int);
+HASH_BENCHMARK(insertReserved, std::string);
+HASH_BENCHMARK(findHit,        int);
+HASH_BENCHMARK(findHit,        std::string);
+HASH_BENCHMARK(findMiss,       int);
+HASH_BENCHMARK(findMiss,       std::string);
+HASH_BENCHMARK(erase,          int);
+HASH_BENCHMARK(erase,          std::string);
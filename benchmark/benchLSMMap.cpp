@@ -0,0 +1,129 @@
+/***********************************************************************
+ * Source:
+ *    BENCH LSM MAP
+ * Summary:
+ *    Measure custom::lsm_map against a custom::BST of pairs: sustained
+ *    insert throughput of random keys (counting the merges still under
+ *    way at the end), and then what that costs lookups, hit and miss,
+ *    with and without the runs' Bloom filters.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "lsmMap.h"
+
+/**********************************************
+ * BST MAP
+ * A BST of pairs with a transparent comparator on
+ * the key, as in benchHash
+ *********************************************/
+struct PairLess
+{
+   typedef void is_transparent;
+   typedef std::pair<int, int> P;
+   bool operator () (const P& lhs, const P& rhs) const { return lhs.first < rhs.first; }
+   bool operator () (const P& lhs, int rhs)      const { return lhs.first < rhs;       }
+   bool operator () (int lhs, const P& rhs)      const { return lhs < rhs.first;       }
+};
+typedef custom::BST<std::pair<int, int>, PairLess> BSTMap;
+typedef custom::lsm_map<int, int> LSMMap;
+
+static void lsmSizes(benchmark::internal::Benchmark* b)
+{
+   b->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+}
+
+// ten bits per key, or no filters at all
+static size_t bitsPerKey(bool bloom) { return bloom ? 10 : 0; }
+
+/**********************************************
+ * INSERT
+ * Every key into an empty map, until the map is
+ * done with them: for lsm_map that includes the
+ * last freeze and every merge it set off
+ *********************************************/
+static void bstInsert(benchmark::State& state)
+{
+   std::vector<int> keys = shuffledKeys<int>((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      BSTMap m;
+      for (int key : keys)
+         m.insert(std::make_pair(key, key), true /*keepUnique*/);
+      benchmark::DoNotOptimize(m.size());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void lsmInsert(benchmark::State& state)
+{
+   std::vector<int> keys = shuffledKeys<int>((size_t)state.range(0));
+   for (auto _ : state)
+   {
+      LSMMap m;
+      for (int key : keys)
+         m.insert(key, key);
+      m.flush();
+      m.drain();
+      benchmark::DoNotOptimize(m.numRuns());
+   }
+   state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/**********************************************
+ * FIND HIT and FIND MISS
+ * Look up every key, or as many keys that were
+ * never inserted, in a map built and merged first
+ *********************************************/
+template <bool hit>
+static void bstFind(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   BSTMap m;
+   for (int key : shuffledKeys<int>(n))
+      m.insert(std::make_pair(key, key), true /*keepUnique*/);
+   std::vector<int> lookups = hit ? shuffledKeys<int>(n, 1 /*seed*/) : missingKeys<int>(n);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (int key : lookups)
+         found += (m.find(key) != m.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+template <bool hit, bool bloom>
+static void lsmFind(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   LSMMap m(4096, 4, bitsPerKey(bloom));
+   for (int key : shuffledKeys<int>(n))
+      m.insert(key, key);
+   m.flush();
+   m.drain();
+   std::vector<int> lookups = hit ? shuffledKeys<int>(n, 1 /*seed*/) : missingKeys<int>(n);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      int value;
+      for (int key : lookups)
+         found += m.find(key, value);
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * lookups.size());
+   state.counters["runs"] = (double)m.numRuns();
+}
+
+BENCHMARK(bstInsert)->Name("custom::BST<pair>/insert")->Apply(lsmSizes);
+BENCHMARK(lsmInsert)->Name("custom::lsm_map/insert"  )->Apply(lsmSizes);
+BENCHMARK_TEMPLATE(bstFind, true        )->Name("custom::BST<pair>/findHit"    )->Apply(lsmSizes);
+BENCHMARK_TEMPLATE(lsmFind, true,  true )->Name("custom::lsm_map/findHit"      )->Apply(lsmSizes);
+BENCHMARK_TEMPLATE(lsmFind, true,  false)->Name("custom::lsm_map/findHitNoBloom" )->Apply(lsmSizes);
+BENCHMARK_TEMPLATE(bstFind, false       )->Name("custom::BST<pair>/findMiss"   )->Apply(lsmSizes);
+BENCHMARK_TEMPLATE(lsmFind, false, true )->Name("custom::lsm_map/findMiss"     )->Apply(lsmSizes);
+BENCHMARK_TEMPLATE(lsmFind, false, false)->Name("custom::lsm_map/findMissNoBloom")->Apply(lsmSizes);
@@ -0,0 +1,154 @@
+/***********************************************************************
+ * Source:
+ *    BENCH MPMC QUEUE
+ * Summary:
+ *    Measure the throughput of the lock-free queue in mpmcQueue.h, one
+ *    item at a time and in batches, against a NodeList guarded by a
+ *    mutex, across a range of producer/consumer ratios.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "mpmcQueue.h"
+#include "nodeList.h"
+
+#include <mutex>
+#include <thread>
+
+/**********************************************
+ * LOCKED LIST
+ * The baseline: a NodeList behind a mutex with the
+ * same push/pop surface as mpmc_queue
+ *********************************************/
+template <typename T>
+class LockedList
+{
+public:
+   void push(const T& t)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      list.push_back(t);
+   }
+   template <typename Iterator>
+   void push_bulk(Iterator first, Iterator last)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (; first != last; ++first)
+         list.push_back(*first);
+   }
+   bool pop(T& t)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (list.empty())
+         return false;
+      t = list.front();
+      list.pop_front();
+      return true;
+   }
+   size_t pop_bulk(custom::vector<T>& out, size_t max)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t num = 0;
+      for (; num < max && !list.empty(); num++)
+      {
+         out.push_back(list.front());
+         list.pop_front();
+      }
+      return num;
+   }
+
+private:
+   std::mutex mutex;
+   NodeList<T> list;
+};
+
+/**********************************************
+ * TRANSFER
+ * range(0) producers push numItems between them while
+ * range(1) consumers pop until all have arrived.
+ * Consumers yield when the queue is empty so the
+ * benchmark behaves on machines with few cores.
+ *********************************************/
+template <typename Q, size_t batch>
+static void transfer(benchmark::State& state)
+{
+   const size_t numItems = 1 << 18;
+   size_t numProducers = (size_t)state.range(0);
+   size_t numConsumers = (size_t)state.range(1);
+
+   for (auto _ : state)
+   {
+      Q queue;
+      std::atomic<size_t> numReceived(0);
+      std::vector<std::thread> threads;
+
+      for (size_t p = 0; p < numProducers; p++)
+         threads.emplace_back([&, p]()
+         {
+            size_t begin = numItems * p / numProducers;
+            size_t end   = numItems * (p + 1) / numProducers;
+            if (batch == 1)
+               for (size_t i = begin; i < end; i++)
+                  queue.push(i);
+            else
+            {
+               size_t items[batch];
+               for (size_t i = begin; i < end; )
+               {
+                  size_t num = 0;
+                  for (; num < batch && i < end; num++)
+                     items[num] = i++;
+                  queue.push_bulk(items, items + num);
+               }
+            }
+         });
+
+      for (size_t c = 0; c < numConsumers; c++)
+         threads.emplace_back([&]()
+         {
+            custom::vector<size_t> items;
+            items.reserve(batch);
+            while (numReceived.load(std::memory_order_relaxed) < numItems)
+            {
+               size_t num = 0;
+               if (batch == 1)
+               {
+                  size_t item = 0;
+                  num = queue.pop(item) ? 1 : 0;
+                  benchmark::DoNotOptimize(item);
+               }
+               else
+               {
+                  items.clear();
+                  num = queue.pop_bulk(items, batch);
+               }
+
+               if (num == 0)
+                  std::this_thread::yield();
+               else
+                  numReceived.fetch_add(num, std::memory_order_relaxed);
+            }
+         });
+
+      for (auto& thread : threads)
+         thread.join();
+   }
+   state.SetItemsProcessed(state.iterations() * numItems);
+}
+
+/**********************************************
+ * RATIOS
+ * producers x consumers
+ *********************************************/
+static void ratios(benchmark::internal::Benchmark* b)
+{
+   b->ArgNames({ "producers", "consumers" });
+   b->Args({ 1, 1 })->Args({ 1, 4 })->Args({ 4, 1 })->Args({ 2, 2 })->Args({ 4, 4 })->Args({ 8, 8 });
+   b->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(transfer, custom::mpmc_queue<size_t>, 1)->Name("mpmc_queue/transfer")->Apply(ratios);
+BENCHMARK_TEMPLATE(transfer, custom::mpmc_queue<size_t>, 32)->Name("mpmc_queue/transferBatch32")->Apply(ratios);
+BENCHMARK_TEMPLATE(transfer, LockedList<size_t>, 1)->Name("mutex+NodeList/transfer")->Apply(ratios);
+BENCHMARK_TEMPLATE(transfer, LockedList<size_t>, 32)->Name("mutex+NodeList/transferBatch32")->Apply(ratios);
@@ -0,0 +1,306 @@
+/***********************************************************************
+ * Source:
+ *    BENCH NODE
+ * Summary:
+ *    Measure the Node list primitives in node.h (copy, assign, insert,
+ *    and remove), with and without a NodeCache, against the matching
+ *    std::list operations.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "node.h"
+
+#include <list>
+
+/**********************************************
+ * MAKE LIST
+ * Build a Node list holding keys, in order
+ *********************************************/
+template <typename T>
+static Node<T>* makeList(const std::vector<T>& keys)
+{
+   Node<T>* pHead = nullptr;
+   Node<T>* pTail = nullptr;
+   for (const T& key : keys)
+   {
+      pTail = insert(pTail, key, true /*after*/);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+   return pHead;
+}
+
+template <typename T>
+static Node<T>* makeList(const std::vector<T>& keys, NodeCache<T>& cache)
+{
+   Node<T>* pHead = nullptr;
+   Node<T>* pTail = nullptr;
+   for (const T& key : keys)
+   {
+      pTail = insert(pTail, key, true /*after*/, cache);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+   return pHead;
+}
+
+/**********************************************
+ * COPY
+ * Duplicate a list of n elements
+ *********************************************/
+template <typename T>
+static void nodeCopy(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   Node<T>* pSource = makeList(sortedKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      Node<T>* pCopy = copy(pSource);
+      benchmark::DoNotOptimize(pCopy);
+
+      state.PauseTiming();
+      clear(pCopy);
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+   clear(pSource);
+}
+
+template <typename T>
+static void cacheCopy(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeCache<T> cache;
+   Node<T>* pSource = makeList(sortedKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      Node<T>* pCopy = copy(pSource, cache);
+      benchmark::DoNotOptimize(pCopy);
+      clear(pCopy, cache);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+   clear(pSource);
+}
+
+template <typename T>
+static void listCopy(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   std::list<T> source(keys.begin(), keys.end());
+
+   for (auto _ : state)
+   {
+      std::list<T>* pCopy = new std::list<T>(source);
+      benchmark::DoNotOptimize(pCopy);
+
+      state.PauseTiming();
+      delete pCopy;
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * ASSIGN
+ * Assign alternately from a list of n and a list of n/2
+ * elements so the destination keeps shrinking and growing
+ *********************************************/
+template <typename T>
+static void nodeAssign(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   Node<T>* pLong  = makeList(keys);
+   Node<T>* pShort = makeList(std::vector<T>(keys.begin(), keys.begin() + n / 2));
+   Node<T>* pDestination = nullptr;
+
+   for (auto _ : state)
+   {
+      assign(pDestination, pLong);
+      assign(pDestination, pShort);
+      benchmark::DoNotOptimize(pDestination);
+   }
+   state.SetItemsProcessed(state.iterations() * (n + n / 2));
+   clear(pDestination);
+   clear(pShort);
+   clear(pLong);
+}
+
+template <typename T>
+static void cacheAssign(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   NodeCache<T> cache;
+   Node<T>* pLong  = makeList(keys);
+   Node<T>* pShort = makeList(std::vector<T>(keys.begin(), keys.begin() + n / 2));
+   Node<T>* pDestination = nullptr;
+
+   for (auto _ : state)
+   {
+      assign(pDestination, pLong, cache);
+      assign(pDestination, pShort, cache);
+      benchmark::DoNotOptimize(pDestination);
+   }
+   state.SetItemsProcessed(state.iterations() * (n + n / 2));
+   clear(pDestination, cache);
+   clear(pShort);
+   clear(pLong);
+}
+
+template <typename T>
+static void listAssign(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   std::list<T> longList(keys.begin(), keys.end());
+   std::list<T> shortList(keys.begin(), keys.begin() + n / 2);
+   std::list<T> destination;
+
+   for (auto _ : state)
+   {
+      destination = longList;
+      destination = shortList;
+      benchmark::DoNotOptimize(destination.size());
+   }
+   state.SetItemsProcessed(state.iterations() * (n + n / 2));
+}
+
+/**********************************************
+ * INSERT
+ * Build a list of n elements by inserting after the tail
+ *********************************************/
+template <typename T>
+static void nodeInsert(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      Node<T>* pHead = makeList(keys);
+      benchmark::DoNotOptimize(pHead);
+
+      state.PauseTiming();
+      clear(pHead);
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void cacheInsert(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   NodeCache<T> cache;
+
+   for (auto _ : state)
+   {
+      Node<T>* pHead = makeList(keys, cache);
+      benchmark::DoNotOptimize(pHead);
+      clear(pHead, cache);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void listInsert(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      std::list<T> l;
+      for (const T& key : keys)
+         l.insert(l.end(), key);
+      benchmark::DoNotOptimize(l.size());
+
+      state.PauseTiming();
+      l.clear();
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * REMOVE
+ * Remove every node from the front of a list of n
+ *********************************************/
+template <typename T>
+static void nodeRemove(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      Node<T>* pHead = makeList(keys);
+      state.ResumeTiming();
+
+      while (pHead != nullptr)
+         pHead = remove(pHead);
+      benchmark::DoNotOptimize(pHead);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void cacheRemove(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   NodeCache<T> cache;
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      Node<T>* pHead = makeList(keys, cache);
+      state.ResumeTiming();
+
+      while (pHead != nullptr)
+         pHead = remove(pHead, cache);
+      benchmark::DoNotOptimize(pHead);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void listRemove(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      std::list<T> l(keys.begin(), keys.end());
+      state.ResumeTiming();
+
+      while (!l.empty())
+         l.erase(l.begin());
+      benchmark::DoNotOptimize(l.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define NODE_BENCHMARK(operation, T)                                              \
+   BENCHMARK_TEMPLATE(node##operation, T)->Name("Node<" #T ">/" #operation)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(cache##operation, T)->Name("Node<" #T ">+NodeCache/" #operation)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(list##operation, T)->Name("std::list<" #T ">/" #operation)->Apply(sizeSweep)
+
+NODE_BENCHMARK(Copy,   int);
+NODE_BENCHMARK(Copy,   std::string);
+NODE_BENCHMARK(Assign, int);
+NODE_BENCHMARK(Assign, std::string);
+NODE_BENCHMARK(Insert, int);
+NODE_BENCHMARK(Insert, std::string);
+NODE_BENCHMARK(Remove, int);
+NODE_BENCHMARK(Remove, std::string);
@@ -0,0 +1,257 @@
+/***********************************************************************
+ * Source:
+ *    BENCH NODE LIST
+ * Summary:
+ *    Measure the NodeList header in nodeList.h on queue- and LRU-style
+ *    workloads: O(1) size, moving a node to the front, handing nodes
+ *    from one queue to another, and split/concat. Each is compared with
+ *    the same work done by remove() and insert() on bare Nodes and with
+ *    std::list::splice.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "nodeList.h"
+
+#include <list>
+
+/**********************************************
+ * SIZE
+ * Ask for the size of a list of n
+ *********************************************/
+static void nodeListSize(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeList<int> list;
+   for (size_t i = 0; i < n; i++)
+      list.push_back((int)i);
+
+   for (auto _ : state)
+   {
+      benchmark::DoNotOptimize(&list);
+      benchmark::DoNotOptimize(list.size());
+   }
+}
+
+static void nodeSize(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeList<int> list;
+   for (size_t i = 0; i < n; i++)
+      list.push_back((int)i);
+
+   for (auto _ : state)
+      benchmark::DoNotOptimize(size((const Node<int> *)list.head()));
+}
+
+/**********************************************
+ * MOVE TO FRONT
+ * The heart of an LRU cache: a random node that was
+ * just used moves to the front of a list of n
+ *********************************************/
+template <typename T>
+static void nodeListMoveToFront(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeList<T> list;
+   std::vector<Node<T>*> index;
+   for (const T& key : sortedKeys<T>(n))
+      index.push_back(list.push_back(key));
+   std::mt19937 random(232);
+
+   for (auto _ : state)
+   {
+      Node<T>* pNode = index[random() % n];
+      list.splice(list.head(), list, pNode);
+      benchmark::DoNotOptimize(list.head());
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+static void nodeMoveToFront(benchmark::State& state)
+{
+   // without splice, moving a node means a remove() and an insert(),
+   // which frees the node and allocates and copies a new one
+   size_t n = (size_t)state.range(0);
+   std::vector<Node<T>*> index;
+   Node<T>* pTail = nullptr;
+   for (const T& key : sortedKeys<T>(n))
+      index.push_back(pTail = insert(pTail, key, true /*after*/));
+   Node<T>* pHead = index[0];
+   std::mt19937 random(232);
+
+   for (auto _ : state)
+   {
+      size_t i = random() % n;
+      Node<T>* pNode = index[i];
+      if (pNode != pHead)
+      {
+         T value = pNode->data;
+         remove(pNode);
+         pHead = index[i] = insert(pHead, value);
+      }
+      benchmark::DoNotOptimize(pHead);
+   }
+   state.SetItemsProcessed(state.iterations());
+   clear(pHead);
+}
+
+template <typename T>
+static void listMoveToFront(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::list<T> list;
+   std::vector<typename std::list<T>::iterator> index;
+   for (const T& key : sortedKeys<T>(n))
+      index.push_back(list.insert(list.end(), key));
+   std::mt19937 random(232);
+
+   for (auto _ : state)
+   {
+      list.splice(list.begin(), list, index[random() % n]);
+      benchmark::DoNotOptimize(&list.front());
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+/**********************************************
+ * HAND OFF
+ * A pipeline stage takes the front of one queue and
+ * puts it on the back of the next. All n nodes are
+ * moved from the first queue to the second and back.
+ *********************************************/
+template <typename T>
+static void nodeListHandOff(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeList<T> from;
+   NodeList<T> to;
+   for (const T& key : sortedKeys<T>(n))
+      from.push_back(key);
+
+   for (auto _ : state)
+   {
+      while (!from.empty())
+         to.splice(nullptr, from, from.head());
+      from.swap(to);
+      benchmark::DoNotOptimize(from.head());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void nodeHandOff(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeList<T> from;
+   NodeList<T> to;
+   for (const T& key : sortedKeys<T>(n))
+      from.push_back(key);
+
+   for (auto _ : state)
+   {
+      while (!from.empty())
+      {
+         to.push_back(from.front());
+         from.pop_front();
+      }
+      from.swap(to);
+      benchmark::DoNotOptimize(from.head());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename T>
+static void listHandOff(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   std::list<T> from(keys.begin(), keys.end());
+   std::list<T> to;
+
+   for (auto _ : state)
+   {
+      while (!from.empty())
+         to.splice(to.end(), from, from.begin());
+      from.swap(to);
+      benchmark::DoNotOptimize(&from.front());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * SPLIT CONCAT
+ * Cut a list of n in half and join it back together
+ *********************************************/
+template <typename T>
+static void nodeListSplitConcat(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   NodeList<T> list;
+   for (const T& key : sortedKeys<T>(n))
+      list.push_back(key);
+
+   for (auto _ : state)
+   {
+      NodeList<T> back = list.split_at(n / 2);
+      list.concat(back);
+      benchmark::DoNotOptimize(list.size());
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+static void nodeSplitConcat(benchmark::State& state)
+{
+   // without a list header, the back half is copied out and assigned back
+   size_t n = (size_t)state.range(0);
+   NodeList<T> list;
+   for (const T& key : sortedKeys<T>(n))
+      list.push_back(key);
+   Node<T>* pMiddle = list.head();
+   for (size_t i = 0; i < n / 2; i++)
+      pMiddle = pMiddle->pNext;
+
+   for (auto _ : state)
+   {
+      Node<T>* pBack = copy((const Node<T>*)pMiddle);
+      assign(pMiddle->pNext, (const Node<T>*)pBack->pNext);
+      benchmark::DoNotOptimize(pMiddle->pNext);
+      clear(pBack);
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+static void listSplitConcat(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   std::list<T> list(keys.begin(), keys.end());
+
+   for (auto _ : state)
+   {
+      std::list<T> back;
+      back.splice(back.end(), list, std::next(list.begin(), n / 2), list.end());
+      list.splice(list.end(), back);
+      benchmark::DoNotOptimize(list.size());
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(nodeListSize)->Name("NodeList<int>/size")->Apply(sizeSweep);
+BENCHMARK(nodeSize)->Name("Node<int>/size")->Apply(sizeSweep);
+
+#define NODE_LIST_BENCHMARK(operation, T)                                         \
+   BENCHMARK_TEMPLATE(nodeList##operation, T)->Name("NodeList<" #T ">/" #operation)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(node##operation, T)->Name("Node<" #T ">/" #operation)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(list##operation, T)->Name("std::list<" #T ">/" #operation)->Apply(sizeSweep)
+
+NODE_LIST_BENCHMARK(MoveToFront, int);
+NODE_LIST_BENCHMARK(MoveToFront, std::string);
+NODE_LIST_BENCHMARK(HandOff,     int);
+NODE_LIST_BENCHMARK(HandOff,     std::string);
+NODE_LIST_BENCHMARK(SplitConcat, int);
+NODE_LIST_BENCHMARK(SplitConcat, std::string);
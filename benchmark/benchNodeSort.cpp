@@ -0,0 +1,120 @@
+/***********************************************************************
+ * Source:
+ *    BENCH NODE SORT
+ * Summary:
+ *    Measure the in-place merge sort in node.h against the usual
+ *    alternative: copy the list into a vector, sort the vector, and
+ *    write the values back into the list. Lists run from 1M to 50M
+ *    nodes.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "node.h"
+#include "vector.h"
+
+#include <algorithm>
+
+/**********************************************
+ * SORT SIZES
+ * 1M, 10M, and 50M nodes. 50M ints take about 1.6GB
+ *********************************************/
+static void sortSizes(benchmark::internal::Benchmark* b)
+{
+   b->Arg(1 << 20)->Arg(10 << 20)->Arg(50 << 20)->Unit(benchmark::kMillisecond);
+}
+
+/**********************************************
+ * MAKE SHUFFLED LIST
+ * A list whose nodes were allocated in order
+ * but whose values are shuffled
+ *********************************************/
+template <typename T>
+static Node<T>* makeShuffledList(const std::vector<T>& keys)
+{
+   Node<T>* pHead = nullptr;
+   Node<T>* pTail = nullptr;
+   for (const T& key : keys)
+   {
+      pTail = insert(pTail, key, true /*after*/);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+   return pHead;
+}
+
+/**********************************************
+ * RESHUFFLE
+ * Put the shuffled values back in list order
+ *********************************************/
+template <typename T>
+static void reshuffle(Node<T>* pHead, const std::vector<T>& keys)
+{
+   size_t i = 0;
+   for (Node<T>* p = pHead; p; p = p->pNext)
+      p->data = keys[i++];
+}
+
+/**********************************************
+ * MERGE SORT
+ * Relink the nodes in place
+ *********************************************/
+template <typename T>
+static void nodeMergeSort(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   Node<T>* pHead = makeShuffledList(keys);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      reshuffle(pHead, keys);
+      state.ResumeTiming();
+
+      sort(pHead);
+      benchmark::DoNotOptimize(pHead);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+   clear(pHead);
+}
+
+/**********************************************
+ * VECTOR SORT
+ * Copy the values out, sort them, and copy them back
+ *********************************************/
+template <typename T>
+static void vectorSort(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   Node<T>* pHead = makeShuffledList(keys);
+   custom::vector<T> buffer;
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      reshuffle(pHead, keys);
+      buffer.clear();
+      state.ResumeTiming();
+
+      buffer.reserve(n);
+      for (Node<T>* p = pHead; p; p = p->pNext)
+         buffer.push_back(std::move(p->data));
+      std::sort(&buffer[0], &buffer[0] + n);
+      size_t i = 0;
+      for (Node<T>* p = pHead; p; p = p->pNext)
+         p->data = std::move(buffer[i++]);
+      benchmark::DoNotOptimize(pHead);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+   clear(pHead);
+}
+
+BENCHMARK_TEMPLATE(nodeMergeSort, int)->Name("Node<int>/mergeSort")->Apply(sortSizes);
+BENCHMARK_TEMPLATE(vectorSort,    int)->Name("Node<int>/vectorSort")->Apply(sortSizes);
+BENCHMARK_TEMPLATE(nodeMergeSort, std::string)->Name("Node<std::string>/mergeSort")
+   ->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(vectorSort,    std::string)->Name("Node<std::string>/vectorSort")
+   ->Arg(1 << 20)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,190 @@
+/***********************************************************************
+ * Source:
+ *    BENCH PQUEUE
+ * Summary:
+ *    Measure custom::priority_queue, as a binary and as a 4-ary heap,
+ *    against std::priority_queue on the work a scheduler gives a heap:
+ *    the "hold" loop of an event simulation (take the earliest event,
+ *    schedule its next one a random time later), building a queue of
+ *    pending events all at once, and draining it.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "pqueue.h"
+
+#include <cstdint>
+#include <functional>  // for std::greater
+#include <queue>
+
+/**********************************************
+ * EVENT TIMES
+ * The earliest time is the one to run next, so every
+ * queue here is a min-heap
+ *********************************************/
+typedef uint64_t Time;
+typedef std::priority_queue<Time, std::vector<Time>, std::greater<Time> > StdQueue;
+typedef custom::priority_queue<Time, std::greater<Time>, custom::vector<Time>, 2> BinaryQueue;
+typedef custom::priority_queue<Time, std::greater<Time>, custom::vector<Time>, 4> QuaternaryQueue;
+
+static std::vector<Time> randomTimes(size_t n, unsigned seed = 232)
+{
+   std::mt19937 random(seed);
+   std::vector<Time> times(n);
+   for (Time& t : times)
+      t = random() % 1000000;
+   return times;
+}
+
+/**********************************************
+ * ADAPTERS
+ * std::priority_queue has no replace-the-top, so
+ * there it is a pop() and a push()
+ *********************************************/
+template <typename Q>
+static void reschedule(Q& q, Time t)
+{
+   q.pop_push(t);
+}
+
+static void reschedule(StdQueue& q, Time t)
+{
+   q.pop();
+   q.push(t);
+}
+
+template <typename Q>
+static void pushAll(Q& q, const std::vector<Time>& times)
+{
+   q.push_range(times.begin(), times.end());
+}
+
+static void pushAll(StdQueue& q, const std::vector<Time>& times)
+{
+   for (Time t : times)
+      q.push(t);
+}
+
+/**********************************************
+ * HOLD
+ * Keep n events pending. Each step runs the earliest
+ * and schedules a new one a random delay after it.
+ * This is the steady state of a discrete event
+ * simulation or a timer wheel
+ *********************************************/
+template <typename Q>
+static void hold(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<Time> delays = randomTimes(4096, 1 /*seed*/);
+   std::vector<Time> times = randomTimes(n);
+   Q q(times.begin(), times.end());
+   size_t i = 0;
+
+   for (auto _ : state)
+   {
+      for (size_t step = 0; step < n; step++)
+         reschedule(q, q.top() + delays[i++ & 4095]);
+      benchmark::DoNotOptimize(q.top());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * BUILD
+ * Make a queue of n pending events from a batch.
+ * The range constructor heapifies in O(n); pushing
+ * them one at a time into an empty queue does not
+ *********************************************/
+template <typename Q>
+static void buildRange(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<Time> times = randomTimes(n);
+
+   for (auto _ : state)
+   {
+      Q q(times.begin(), times.end());
+      benchmark::DoNotOptimize(q.top());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Q>
+static void buildPush(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<Time> times = randomTimes(n);
+
+   for (auto _ : state)
+   {
+      Q q;
+      for (Time t : times)
+         q.push(t);
+      benchmark::DoNotOptimize(q.top());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * PUSH BATCH
+ * A queue of n pending events takes in another n
+ * arriving at once, as when a tick releases a batch
+ *********************************************/
+template <typename Q>
+static void pushBatch(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<Time> times = randomTimes(n);
+   std::vector<Time> batch = randomTimes(n, 1 /*seed*/);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      Q q(times.begin(), times.end());
+      state.ResumeTiming();
+
+      pushAll(q, batch);
+      benchmark::DoNotOptimize(q.top());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * DRAIN
+ * Run every pending event in order
+ *********************************************/
+template <typename Q>
+static void drain(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<Time> times = randomTimes(n);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      Q q(times.begin(), times.end());
+      state.ResumeTiming();
+
+      Time sum = 0;
+      while (!q.empty())
+      {
+         sum += q.top();
+         q.pop();
+      }
+      benchmark::DoNotOptimize(sum);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define PQUEUE_BENCHMARK(function)                                                                     \
+   BENCHMARK_TEMPLATE(function, BinaryQueue)->Name("custom::priority_queue<2>/" #function)->Apply(sizeSweep);     \
+   BENCHMARK_TEMPLATE(function, QuaternaryQueue)->Name("custom::priority_queue<4>/" #function)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(function, StdQueue)->Name("std::priority_queue/" #function)->Apply(sizeSweep)
+
+PQUEUE_BENCHMARK(hold);
+PQUEUE_BENCHMARK(buildRange);
+PQUEUE_BENCHMARK(buildPush);
+PQUEUE_BENCHMARK(pushBatch);
+PQUEUE_BENCHMARK(drain);
@@ -0,0 +1,140 @@
+/***********************************************************************
+ * Source:
+ *    BENCH PERSISTENT BST
+ * Summary:
+ *    Measure the copy-on-write tree in persistentBST.h against BST when
+ *    a reader needs its own consistent view: taking the view, changing
+ *    the tree while a view is held, and the plain insert and find costs
+ *    the sharing adds when no view is held.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "persistentBST.h"
+
+/**********************************************
+ * ADAPTERS
+ * A BST view is a deep copy; a PersistentBST
+ * view is a snapshot
+ *********************************************/
+template <typename T>
+static custom::BST<T> view(const custom::BST<T>& bst)
+{
+   custom::BST<T> copy;
+   copy = bst;
+   return copy;
+}
+
+template <typename T>
+static custom::PersistentBST<T> view(const custom::PersistentBST<T>& tree)
+{
+   return tree.snapshot();
+}
+
+template <typename C, typename T>
+static void fill(C& c, const std::vector<T>& keys)
+{
+   for (const T& key : keys)
+      c.insert(key, true /*keepUnique*/);
+}
+
+/**********************************************
+ * VIEW
+ * Take a view of a tree of n
+ *********************************************/
+template <typename C, typename T>
+static void takeView(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   C c;
+   fill(c, shuffledKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      C v = view(c);
+      benchmark::DoNotOptimize(v.size());
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+/**********************************************
+ * UPDATE UNDER VIEW
+ * A writer publishes a fresh view for readers
+ * after every insert and erase
+ *********************************************/
+template <typename C, typename T>
+static void updateUnderView(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> misses = missingKeys<T>(n);
+   C c;
+   fill(c, shuffledKeys<T>(n));
+   C published = view(c);
+
+   size_t i = 0;
+   for (auto _ : state)
+   {
+      const T& key = misses[i++ % n];
+      auto result = c.insert(key, true /*keepUnique*/);
+      published = view(c);
+      c.erase(result.first);
+      published = view(c);
+      benchmark::DoNotOptimize(published.size());
+   }
+   state.SetItemsProcessed(state.iterations() * 2);
+}
+
+/**********************************************
+ * INSERT
+ * Build a tree from empty with no view held, so
+ * every PersistentBST node is reused in place
+ *********************************************/
+template <typename C, typename T>
+static void insertRandom(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      C c;
+      fill(c, keys);
+      benchmark::DoNotOptimize(c.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * FIND HIT
+ * Look up every key in random order
+ *********************************************/
+template <typename C, typename T>
+static void findHit(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = shuffledKeys<T>(n);
+   C c;
+   fill(c, keys);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const T& key : keys)
+         found += (c.find(key) != c.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define PERSISTENT_BENCHMARK(function, T)                                         \
+   BENCHMARK_TEMPLATE(function, custom::PersistentBST<T>, T)->Name("custom::PersistentBST<" #T ">/" #function)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(function, custom::BST<T>,           T)->Name("custom::BST<"           #T ">/" #function)->Apply(sizeSweep)
+
+PERSISTENT_BENCHMARK(takeView,        int);
+PERSISTENT_BENCHMARK(takeView,        std::string);
+PERSISTENT_BENCHMARK(updateUnderView, int);
+PERSISTENT_BENCHMARK(updateUnderView, std::string);
+PERSISTENT_BENCHMARK(insertRandom,    int);
+PERSISTENT_BENCHMARK(findHit,         int);
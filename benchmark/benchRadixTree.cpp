@@ -0,0 +1,118 @@
+/***********************************************************************
+ * Source:
+ *    BENCH RADIX TREE
+ * Summary:
+ *    Measure custom::radix_set against custom::BST, both filled with
+ *    random inserts, for point lookups in random order and for range
+ *    scans (a lower_bound and then the next hundred elements), with int
+ *    keys up to ten million and string keys up to four million. Each
+ *    container is built once per size and kept for every benchmark on
+ *    it, because building ten million elements takes longer than all the
+ *    lookups.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "radixTree.h"
+
+#include <map>
+#include <memory>   // for std::unique_ptr
+
+static void intSizes(benchmark::internal::Benchmark* b)
+{
+   b->Arg(1 << 20)->Arg(10000000)->Unit(benchmark::kMillisecond);
+}
+
+static void stringSizes(benchmark::internal::Benchmark* b)
+{
+   b->Arg(1 << 20)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+}
+
+/**********************************************
+ * ADAPTERS
+ *********************************************/
+template <typename C, typename T>
+static void insertKey(C& c, const T& t) { c.insert(t); }
+
+template <typename T>
+static void insertKey(custom::BST<T>& c, const T& t) { c.insert(t, true /*keepUnique*/); }
+
+/**********************************************
+ * BUILT
+ * The container of n shuffled keys, built the first
+ * time it is asked for and kept to the end
+ *********************************************/
+template <typename C, typename T>
+static const C& built(size_t n)
+{
+   static std::map<size_t, std::unique_ptr<C> > containers;
+   std::unique_ptr<C>& pContainer = containers[n];
+   if (!pContainer)
+   {
+      pContainer.reset(new C);
+      for (const T& key : shuffledKeys<T>(n))
+         insertKey(*pContainer, key);
+   }
+   return *pContainer;
+}
+
+/**********************************************
+ * FIND RANDOM
+ * Every key, in a different random order
+ *********************************************/
+template <typename C, typename T>
+static void findRandom(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   const C& c = built<C, T>(n);
+   std::vector<T> lookups = shuffledKeys<T>(n, 1 /*seed*/);
+
+   for (auto _ : state)
+   {
+      size_t found = 0;
+      for (const T& key : lookups)
+         found += (const_cast<C&>(c).find(key) != c.end());
+      benchmark::DoNotOptimize(found);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * RANGE SCAN
+ * Ten thousand random ranges of a hundred elements,
+ * each found with lower_bound
+ *********************************************/
+template <typename C, typename T>
+static void rangeScan(benchmark::State& state)
+{
+   const size_t numRanges = 10000;
+   const size_t length = 100;
+   size_t n = (size_t)state.range(0);
+   const C& c = built<C, T>(n);
+   std::vector<T> starts = shuffledKeys<T>(n, 1 /*seed*/);
+   starts.resize(numRanges);
+
+   for (auto _ : state)
+   {
+      size_t num = 0;
+      for (const T& start : starts)
+      {
+         auto it = c.lower_bound(start);
+         for (size_t i = 0; i < length && it != c.end(); i++, ++it)
+            num++;
+      }
+      benchmark::DoNotOptimize(num);
+   }
+   state.SetItemsProcessed(state.iterations() * numRanges * length);
+}
+
+BENCHMARK_TEMPLATE(findRandom, custom::radix_set<int>,         int        )->Name("custom::radix_set<int>/findRandom"        )->Apply(intSizes);
+BENCHMARK_TEMPLATE(findRandom, custom::BST<int>,               int        )->Name("custom::BST<int>/findRandom"              )->Apply(intSizes);
+BENCHMARK_TEMPLATE(rangeScan,  custom::radix_set<int>,         int        )->Name("custom::radix_set<int>/rangeScan"         )->Apply(intSizes);
+BENCHMARK_TEMPLATE(rangeScan,  custom::BST<int>,               int        )->Name("custom::BST<int>/rangeScan"               )->Apply(intSizes);
+BENCHMARK_TEMPLATE(findRandom, custom::radix_set<std::string>, std::string)->Name("custom::radix_set<std::string>/findRandom")->Apply(stringSizes);
+BENCHMARK_TEMPLATE(findRandom, custom::BST<std::string>,       std::string)->Name("custom::BST<std::string>/findRandom"      )->Apply(stringSizes);
+BENCHMARK_TEMPLATE(rangeScan,  custom::radix_set<std::string>, std::string)->Name("custom::radix_set<std::string>/rangeScan" )->Apply(stringSizes);
+BENCHMARK_TEMPLATE(rangeScan,  custom::BST<std::string>,       std::string)->Name("custom::BST<std::string>/rangeScan"       )->Apply(stringSizes);
@@ -0,0 +1,140 @@
+/***********************************************************************
+ * Source:
+ *    BENCH RECLAIM
+ * Summary:
+ *    Measure how long the thread that lets go of a big container is
+ *    held up: destroying it right there, against handing it to a
+ *    Reclaimer. Each iteration is one request that drops one container
+ *    of n elements (a BST, a custom::vector of strings, a Node chain);
+ *    the release alone is timed, and the 50th and 99th percentile and
+ *    the worst release are reported in microseconds. The time per
+ *    iteration includes building the container, so only the counters
+ *    compare the two.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "vector.h"
+#include "node.h"
+#include "reclaimer.h"
+
+#include <chrono>
+
+/**********************************************
+ * LATENCIES
+ * Release times of every request, summarized as
+ * percentiles once the run is over
+ *********************************************/
+class Latencies
+{
+public:
+   void add(double seconds) { samples.push_back(seconds * 1e6); }
+   void report(benchmark::State& state)
+   {
+      if (samples.empty())
+         return;
+      std::sort(samples.begin(), samples.end());
+      state.counters["p50_us"] = percentile(0.50);
+      state.counters["p99_us"] = percentile(0.99);
+      state.counters["max_us"] = samples.back();
+   }
+private:
+   double percentile(double p) const { return samples[(size_t)(p * (samples.size() - 1))]; }
+   std::vector<double> samples;
+};
+
+/**********************************************
+ * CONTAINERS
+ * How each one is built and let go of, in place
+ * or through a Reclaimer
+ *********************************************/
+struct TreeWork
+{
+   typedef custom::BST<int> Container;
+   static Container * make(const std::vector<int>& keys)
+   {
+      Container * p = new Container;
+      for (int key : keys)
+         p->insert(key);
+      return p;
+   }
+   static void release(Container * p)                         { delete p;                         }
+   static void retire(Container * p, custom::Reclaimer& r)    { r.retire(std::move(*p)); delete p; }
+};
+
+struct VectorWork
+{
+   typedef custom::vector<std::string> Container;
+   static Container * make(const std::vector<int>& keys)
+   {
+      Container * p = new Container;
+      p->reserve(keys.size());
+      for (int key : keys)
+         p->push_back(makeKey<std::string>(key));
+      return p;
+   }
+   static void release(Container * p)                         { delete p;                         }
+   static void retire(Container * p, custom::Reclaimer& r)    { r.retire(std::move(*p)); delete p; }
+};
+
+struct ListWork
+{
+   typedef Node<int> * Container;
+   static Container * make(const std::vector<int>& keys)
+   {
+      Container * p = new Container(nullptr);
+      for (auto it = keys.rbegin(); it != keys.rend(); ++it)
+         *p = insert(*p, *it);
+      return p;
+   }
+   static void release(Container * p)                         { clear(*p); delete p;    }
+   static void retire(Container * p, custom::Reclaimer& r)    { r.retire(*p); delete p; }
+};
+
+/**********************************************
+ * RELEASE INLINE and RELEASE DEFERRED
+ * Building the next container and, for the
+ * Reclaimer, waiting for it to catch up are
+ * outside the timing: only the release counts
+ *********************************************/
+template <typename Work, bool deferred>
+static void release(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<int> keys = shuffledKeys<int>(n);
+   custom::Reclaimer reclaimer;
+   Latencies latencies;
+
+   for (auto _ : state)
+   {
+      typename Work::Container * p = Work::make(keys);
+      if (deferred)
+         reclaimer.drain();
+
+      auto start = std::chrono::steady_clock::now();
+      if (deferred)
+         Work::retire(p, reclaimer);
+      else
+         Work::release(p);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      latencies.add(elapsed.count());
+   }
+   latencies.report(state);
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Work> static void releaseInline(benchmark::State& state)   { release<Work, false>(state); }
+template <typename Work> static void releaseDeferred(benchmark::State& state) { release<Work, true >(state); }
+
+#define RECLAIM_BENCHMARK(function, Work, name) \
+   BENCHMARK_TEMPLATE(function, Work)->Name(name "/" #function)->Apply(sizeSweep)
+
+RECLAIM_BENCHMARK(releaseInline,   TreeWork,   "custom::BST<int>");
+RECLAIM_BENCHMARK(releaseDeferred, TreeWork,   "custom::BST<int>");
+RECLAIM_BENCHMARK(releaseInline,   VectorWork, "custom::vector<std::string>");
+RECLAIM_BENCHMARK(releaseDeferred, VectorWork, "custom::vector<std::string>");
+RECLAIM_BENCHMARK(releaseInline,   ListWork,   "Node<int>");
+RECLAIM_BENCHMARK(releaseDeferred, ListWork,   "Node<int>");
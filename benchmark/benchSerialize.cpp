@@ -0,0 +1,156 @@
+/***********************************************************************
+ * Source:
+ *    BENCH SERIALIZE
+ * Summary:
+ *    Measure save() and load() for a vector and a BST against what a
+ *    caller would write without them: a loop that writes one element at
+ *    a time, and a load that insert()s every element back into a tree.
+ *    The stream is an in-memory stringstream so the numbers are the
+ *    containers' cost and not the disk's.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "vector.h"
+#include "serialize.h"
+
+#include <sstream>
+
+template <typename T>
+static void fill(custom::BST<T>& bst, size_t n)
+{
+   for (const T& key : shuffledKeys<T>(n))
+      bst.insert(key, true /*keepUnique*/);
+}
+
+template <typename T>
+static void fill(custom::vector<T>& v, size_t n)
+{
+   for (const T& key : shuffledKeys<T>(n))
+      v.push_back(key);
+}
+
+/**********************************************
+ * SAVE
+ * Write the whole container to a cleared stream
+ *********************************************/
+template <typename C>
+static void save(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   C c;
+   fill(c, n);
+   std::stringstream stream;
+
+   for (auto _ : state)
+   {
+      stream.str(std::string());
+      custom::save(stream, c);
+      benchmark::DoNotOptimize(stream.tellp());
+   }
+   state.SetBytesProcessed(state.iterations() * (int64_t)stream.str().size());
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * SAVE ONE BY ONE
+ * The same bytes, one Serializer::write() per element
+ *********************************************/
+template <typename T>
+static void saveOneByOne(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   custom::BST<T> bst;
+   fill(bst, n);
+   std::stringstream stream;
+
+   for (auto _ : state)
+   {
+      stream.str(std::string());
+      custom::serial::writeHeader<T>(stream, custom::serial::TREE, bst.size());
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+         custom::Serializer<T>::write(stream, *it);
+      benchmark::DoNotOptimize(stream.tellp());
+   }
+   state.SetBytesProcessed(state.iterations() * (int64_t)stream.str().size());
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * LOAD
+ * Read a saved container back from the start
+ *********************************************/
+template <typename C>
+static void load(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::string bytes;
+   {
+      C c;
+      fill(c, n);
+      std::stringstream stream;
+      custom::save(stream, c);
+      bytes = stream.str();
+   }
+   std::istringstream stream(bytes);
+   C c;
+
+   for (auto _ : state)
+   {
+      stream.clear();
+      stream.seekg(0);
+      benchmark::DoNotOptimize(custom::load(stream, c));
+   }
+   state.SetBytesProcessed(state.iterations() * (int64_t)bytes.size());
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * LOAD BY INSERT
+ * Read the same bytes but insert() each element,
+ * paying a descent and a rebalance for every one
+ *********************************************/
+template <typename T>
+static void loadByInsert(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::string bytes;
+   {
+      custom::BST<T> bst;
+      fill(bst, n);
+      std::stringstream stream;
+      custom::save(stream, bst);
+      bytes = stream.str();
+   }
+   std::istringstream stream(bytes);
+   custom::BST<T> bst;
+
+   for (auto _ : state)
+   {
+      stream.clear();
+      stream.seekg(0);
+      bst.clear();
+      size_t count = 0;
+      custom::serial::readHeader<T>(stream, custom::serial::TREE, count);
+      T t;
+      for (size_t i = 0; i < count && custom::Serializer<T>::read(stream, t); i++)
+         bst.insert(t);
+      benchmark::DoNotOptimize(bst.size());
+   }
+   state.SetBytesProcessed(state.iterations() * (int64_t)bytes.size());
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(save, custom::vector<int>)->Name("custom::vector<int>/save")->Apply(sizeSweep);
+BENCHMARK_TEMPLATE(load, custom::vector<int>)->Name("custom::vector<int>/load")->Apply(sizeSweep);
+
+#define SERIALIZE_BENCHMARK(T)                                                                   \
+   BENCHMARK_TEMPLATE(save, custom::BST<T>)->Name("custom::BST<" #T ">/save")->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(saveOneByOne, T)->Name("custom::BST<" #T ">/saveOneByOne")->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(load, custom::BST<T>)->Name("custom::BST<" #T ">/load")->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(loadByInsert, T)->Name("custom::BST<" #T ">/loadByInsert")->Apply(sizeSweep)
+
+SERIALIZE_BENCHMARK(int);
+SERIALIZE_BENCHMARK(std::string);
@@ -0,0 +1,178 @@
+/***********************************************************************
+ * Source:
+ *    BENCH SKIP LIST
+ * Summary:
+ *    Measure the concurrent skip list in skipList.h against a BST behind
+ *    a mutex, with several threads writing at once: building the index
+ *    from empty, and a mixed load of finds, inserts, and erases.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "bst.h"
+#include "skipList.h"
+
+#include <mutex>
+#include <thread>
+
+/**********************************************
+ * LOCKED BST
+ * The baseline: every operation on the tree
+ * holds one mutex
+ *********************************************/
+template <typename T>
+class LockedBST
+{
+public:
+   bool insert(const T& t)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return bst.insert(t, true /*keepUnique*/).second;
+   }
+   bool contains(const T& t)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return bst.find(t) != bst.end();
+   }
+   bool erase(const T& t)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = bst.find(t);
+      if (it == bst.end())
+         return false;
+      bst.erase(it);
+      return true;
+   }
+   size_t size() const { return bst.size(); }
+
+private:
+   std::mutex mutex;
+   custom::BST<T> bst;
+};
+
+/**********************************************
+ * SHARED SKIP LIST
+ * The same three operations on a skip_list,
+ * which needs no outside lock
+ *********************************************/
+template <typename T>
+class SharedSkipList
+{
+public:
+   bool insert(const T& t)   { return list.insert(t, true /*keepUnique*/).second; }
+   bool contains(const T& t) { return list.find(t) != list.end(); }
+   bool erase(const T& t)
+   {
+      auto it = list.find(t);
+      if (it == list.end())
+         return false;
+      list.erase(it);
+      return true;
+   }
+   size_t size() const { return list.size(); }
+
+private:
+   custom::skip_list<T> list;
+};
+
+/**********************************************
+ * RUN THREADS
+ * Call work(thread) on range(1) threads and wait
+ *********************************************/
+template <typename Work>
+static void runThreads(size_t numThreads, Work work)
+{
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < numThreads; t++)
+      threads.emplace_back(work, t);
+   for (auto& thread : threads)
+      thread.join();
+}
+
+/**********************************************
+ * BUILD
+ * range(1) threads insert range(0) distinct keys
+ * between them, each taking a slice of the
+ * shuffled keys
+ *********************************************/
+template <typename C, typename T>
+static void build(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   size_t numThreads = (size_t)state.range(1);
+   std::vector<T> keys = shuffledKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      C c;
+      runThreads(numThreads, [&](size_t t)
+      {
+         for (size_t i = n * t / numThreads; i < n * (t + 1) / numThreads; i++)
+            c.insert(keys[i]);
+      });
+      benchmark::DoNotOptimize(c.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * MIXED
+ * Start with half of the keys present. Each thread then
+ * does range(0) / range(1) operations on random keys:
+ * half finds, a quarter inserts, and a quarter erases
+ *********************************************/
+template <typename C, typename T>
+static void mixed(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   size_t numThreads = (size_t)state.range(1);
+   std::vector<T> keys = shuffledKeys<T>(n);
+
+   C c;
+   for (size_t i = 0; i < n; i += 2)
+      c.insert(keys[i]);
+
+   for (auto _ : state)
+   {
+      runThreads(numThreads, [&](size_t t)
+      {
+         std::mt19937 random((unsigned)(232 + t));
+         size_t hits = 0;
+         for (size_t i = 0; i < n / numThreads; i++)
+         {
+            unsigned r = random();
+            const T& key = keys[(r >> 2) % n];
+            switch (r & 3)
+            {
+               case 0:  hits += c.insert(key);   break;
+               case 1:  hits += c.erase(key);    break;
+               default: hits += c.contains(key); break;
+            }
+         }
+         benchmark::DoNotOptimize(hits);
+      });
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * WRITERS
+ * 64K keys across 1 to 8 threads
+ *********************************************/
+static void writers(benchmark::internal::Benchmark* b)
+{
+   b->ArgNames({ "n", "threads" });
+   for (int threads : { 1, 2, 4, 8 })
+      b->Args({ 1 << 16, threads });
+   b->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+#define SKIP_LIST_BENCHMARK(function, T)                                         \
+   BENCHMARK_TEMPLATE(function, SharedSkipList<T>, T)->Name("custom::skip_list<" #T ">/" #function)->Apply(writers); \
+   BENCHMARK_TEMPLATE(function, LockedBST<T>,      T)->Name("mutex+BST<" #T ">/" #function)->Apply(writers)
+
+SKIP_LIST_BENCHMARK(build, int);
+SKIP_LIST_BENCHMARK(build, std::string);
+SKIP_LIST_BENCHMARK(mixed, int);
+SKIP_LIST_BENCHMARK(mixed, std::string);
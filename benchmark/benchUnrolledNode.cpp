@@ -0,0 +1,218 @@
+/***********************************************************************
+ * Source:
+ *    BENCH UNROLLED NODE
+ * Summary:
+ *    Measure the unrolled list in unrolledNode.h against the one
+ *    element per node list in node.h: iteration, copy, assign, append,
+ *    and remove from the front.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "node.h"
+#include "unrolledNode.h"
+
+/**********************************************
+ * MAKE LIST
+ * Build a list holding keys, in order
+ *********************************************/
+template <typename T>
+static Node<T>* makeList(const std::vector<T>& keys, Node<T>*)
+{
+   Node<T>* pHead = nullptr;
+   Node<T>* pTail = nullptr;
+   for (const T& key : keys)
+   {
+      pTail = insert(pTail, key, true /*after*/);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+   return pHead;
+}
+
+template <typename T>
+static UnrolledNode<T>* makeList(const std::vector<T>& keys, UnrolledNode<T>*)
+{
+   UnrolledNode<T>* pHead = nullptr;
+   UnrolledNode<T>* pTail = nullptr;
+   for (const T& key : keys)
+   {
+      pTail = insert(pTail, pTail ? pTail->numElements : 0, key);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+   return pHead;
+}
+
+template <typename L, typename T>
+static L* makeList(const std::vector<T>& keys)
+{
+   return makeList(keys, (L*)nullptr);
+}
+
+/**********************************************
+ * VISIT
+ * Touch every element in order
+ *********************************************/
+template <typename T>
+static size_t visit(const Node<T>* pHead)
+{
+   size_t count = 0;
+   for (auto p = pHead; p; p = p->pNext)
+   {
+      benchmark::DoNotOptimize(p->data);
+      count++;
+   }
+   return count;
+}
+
+template <typename T>
+static size_t visit(const UnrolledNode<T>* pHead)
+{
+   size_t count = 0;
+   for (auto p = pHead; p; p = p->pNext)
+      for (size_t i = 0; i < p->numElements; i++)
+      {
+         benchmark::DoNotOptimize(p->at(i));
+         count++;
+      }
+   return count;
+}
+
+/**********************************************
+ * ITERATE
+ * Walk a list whose nodes were allocated in order
+ *********************************************/
+template <typename L, typename T>
+static void iterate(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   L* pHead = makeList<L>(sortedKeys<T>(n));
+
+   for (auto _ : state)
+      benchmark::DoNotOptimize(visit(pHead));
+
+   state.SetItemsProcessed(state.iterations() * n);
+   clear(pHead);
+}
+
+/**********************************************
+ * COPY
+ * Duplicate a list of n elements
+ *********************************************/
+template <typename L, typename T>
+static void copyList(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   L* pSource = makeList<L>(sortedKeys<T>(n));
+
+   for (auto _ : state)
+   {
+      L* pCopy = copy(pSource);
+      benchmark::DoNotOptimize(pCopy);
+
+      state.PauseTiming();
+      clear(pCopy);
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+   clear(pSource);
+}
+
+/**********************************************
+ * ASSIGN
+ * Assign alternately from a list of n and a list of n/2
+ *********************************************/
+template <typename L, typename T>
+static void assignList(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   L* pLong  = makeList<L>(keys);
+   L* pShort = makeList<L>(std::vector<T>(keys.begin(), keys.begin() + n / 2));
+   L* pDestination = nullptr;
+
+   for (auto _ : state)
+   {
+      assign(pDestination, (const L*)pLong);
+      assign(pDestination, (const L*)pShort);
+      benchmark::DoNotOptimize(pDestination);
+   }
+   state.SetItemsProcessed(state.iterations() * (n + n / 2));
+   clear(pDestination);
+   clear(pShort);
+   clear(pLong);
+}
+
+/**********************************************
+ * APPEND
+ * Build a list of n elements front to back
+ *********************************************/
+template <typename L, typename T>
+static void append(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      L* pHead = makeList<L>(keys);
+      benchmark::DoNotOptimize(pHead);
+
+      state.PauseTiming();
+      clear(pHead);
+      state.ResumeTiming();
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * REMOVE
+ * Remove every element from the front of a list of n
+ *********************************************/
+template <typename T>
+static Node<T>* removeFront(Node<T>* pHead)
+{
+   return remove(pHead);
+}
+
+template <typename T>
+static UnrolledNode<T>* removeFront(UnrolledNode<T>* pHead)
+{
+   return remove(pHead, 0);
+}
+
+template <typename L, typename T>
+static void removeAll(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      state.PauseTiming();
+      L* pHead = makeList<L>(keys);
+      state.ResumeTiming();
+
+      while (pHead != nullptr)
+         pHead = removeFront(pHead);
+      benchmark::DoNotOptimize(pHead);
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define UNROLLED_BENCHMARK(function, T)                                           \
+   BENCHMARK_TEMPLATE(function, UnrolledNode<T>, T)->Name("UnrolledNode<" #T ">/" #function)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(function, Node<T>,         T)->Name("Node<"         #T ">/" #function)->Apply(sizeSweep)
+
+UNROLLED_BENCHMARK(iterate,    int);
+UNROLLED_BENCHMARK(iterate,    std::string);
+UNROLLED_BENCHMARK(copyList,   int);
+UNROLLED_BENCHMARK(copyList,   std::string);
+UNROLLED_BENCHMARK(assignList, int);
+UNROLLED_BENCHMARK(assignList, std::string);
+UNROLLED_BENCHMARK(append,     int);
+UNROLLED_BENCHMARK(append,     std::string);
+UNROLLED_BENCHMARK(removeAll,  int);
+UNROLLED_BENCHMARK(removeAll,  std::string);
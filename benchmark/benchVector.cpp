@@ -0,0 +1,112 @@
+/***********************************************************************
+ * Source:
+ *    BENCH VECTOR
+ * Summary:
+ *    Measure custom::vector against std::vector for push_back (with
+ *    and without reserve), copy, and move.
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#include "benchData.h"
+#include "vector.h"
+
+#include <vector>
+
+/**********************************************
+ * PUSH BACK
+ * Grow a vector one element at a time from empty
+ *********************************************/
+template <typename V, typename T>
+static void pushBack(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      V v;
+      for (size_t i = 0; i < n; i++)
+         v.push_back(keys[i]);
+      benchmark::DoNotOptimize(v.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * PUSH BACK RESERVED
+ * Same as PUSH BACK but the buffer is reserved up front
+ *********************************************/
+template <typename V, typename T>
+static void pushBackReserved(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+
+   for (auto _ : state)
+   {
+      V v;
+      v.reserve(n);
+      for (size_t i = 0; i < n; i++)
+         v.push_back(keys[i]);
+      benchmark::DoNotOptimize(v.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * COPY CONSTRUCT
+ * Copy-construct a full vector
+ *********************************************/
+template <typename V, typename T>
+static void copyConstruct(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   V source;
+   for (size_t i = 0; i < n; i++)
+      source.push_back(keys[i]);
+
+   for (auto _ : state)
+   {
+      V destination(source);
+      benchmark::DoNotOptimize(destination.size());
+   }
+   state.SetItemsProcessed(state.iterations() * n);
+}
+
+/**********************************************
+ * MOVE CONSTRUCT
+ * Move-construct a full vector back and forth. This
+ * should not depend on n at all.
+ *********************************************/
+template <typename V, typename T>
+static void moveConstruct(benchmark::State& state)
+{
+   size_t n = (size_t)state.range(0);
+   std::vector<T> keys = sortedKeys<T>(n);
+   V source;
+   for (size_t i = 0; i < n; i++)
+      source.push_back(keys[i]);
+
+   for (auto _ : state)
+   {
+      V destination(std::move(source));
+      benchmark::DoNotOptimize(destination.size());
+      source = std::move(destination);
+   }
+   state.SetItemsProcessed(state.iterations());
+}
+
+#define VECTOR_BENCHMARK(function, T)                                            \
+   BENCHMARK_TEMPLATE(function, custom::vector<T>, T)->Name("custom::vector<" #T ">/" #function)->Apply(sizeSweep); \
+   BENCHMARK_TEMPLATE(function, std::vector<T>,    T)->Name("std::vector<"    #T ">/" #function)->Apply(sizeSweep)
+
+VECTOR_BENCHMARK(pushBack,         int);
+VECTOR_BENCHMARK(pushBack,         std::string);
+VECTOR_BENCHMARK(pushBackReserved, int);
+VECTOR_BENCHMARK(pushBackReserved, std::string);
+VECTOR_BENCHMARK(copyConstruct,    int);
+VECTOR_BENCHMARK(copyConstruct,    std::string);
+VECTOR_BENCHMARK(moveConstruct,    int);
+VECTOR_BENCHMARK(moveConstruct,    std::string);
@@ -13,6 +13,7 @@
  *    This will contain the class definition of:
  *        BST                 : A class that represents a binary search tree
  *        BST::iterator       : An iterator through BST
+ *        interval            : A closed range; a BST of them is an interval tree
  * Author
  *    Spencer Lamoreaux, Ashlee Hart
  ************************************************************************/
@@ -30,7 +31,14 @@
 #include <utility>
 #include <memory>     // for std::allocator
 #include <functional> // for std::less
+#include <future>     // for std::async
+#include <thread>     // for std::thread::hardware_concurrency
+#include <type_traits> // for std::enable_if
 #include <utility>    // for std::pair
+#include <cstdint>    // for uint32_t and uintptr_t
+#include <atomic>     // for std::atomic
+#include <mutex>      // for std::mutex
+#include <new>        // for std::bad_alloc and std::align_val_t
 
 class TestBST; // forward declaration for unit tests
 class TestSet;
@@ -45,10 +53,239 @@ namespace custom
    class map;
 
 /*****************************************************************
- * BINARY SEARCH TREE
- * Create a Binary Search Tree
+ * NODE POOL
+ * Storage for nodes that are named by 32-bit index rather than by
+ * pointer, shared by every tree with the same node type. Slots live
+ * in chunks that double in size and never move, so an index turns
+ * into an address with a little arithmetic and no lock. Index 0 is
+ * never handed out so it can stand for nullptr. Freed slots are
+ * reused but the chunks are kept until the program ends.
+ *****************************************************************/
+template <typename Node>
+class NodePool
+{
+public:
+   static void * allocate();
+   static void * allocateFresh();
+   static void   deallocate(void * p);
+
+   // index to address
+   static Node * at(uint32_t index)
+   {
+      if (index == 0)
+         return nullptr;
+      int chunk = chunkOf(index);
+      return (Node *)(chunks[chunk] + (index - firstIndex(chunk)) * sizeof(Node));
+   }
+
+   // address to index: the newest chunks are the biggest, so look there first
+   static uint32_t indexOf(const Node * pNode)
+   {
+      if (pNode == nullptr)
+         return 0;
+      const unsigned char * p = (const unsigned char *)pNode;
+      for (int chunk = numChunks.load(std::memory_order_acquire) - 1; chunk >= 0; chunk--)
+         if (p >= chunks[chunk] && p < chunks[chunk] + chunkSize(chunk) * sizeof(Node))
+            return firstIndex(chunk) + (uint32_t)((p - chunks[chunk]) / sizeof(Node));
+      assert(false);
+      return 0;
+   }
+
+private:
+   static const int baseBits = 10;      // the first chunk holds 1024 slots
+   static const int maxChunks = 21;     // room for 2^31 slots
+
+   static uint32_t chunkSize (int chunk)       { return (uint32_t)1 << (baseBits + chunk);              }
+   static uint32_t firstIndex(int chunk)       { return (((uint32_t)1 << chunk) - 1) << baseBits;       }
+   static int      chunkOf   (uint32_t index)  { return 31 - __builtin_clz((index >> baseBits) + 1);   }
+   static void *   takeNext();
+
+   static inline unsigned char * chunks[maxChunks];
+   static inline std::atomic<int> numChunks { 0 };   // readers of indexOf() take no lock
+   static inline uint32_t numSlots  = 1;   // slots handed out so far, counting slot 0
+   static inline uint32_t freeList  = 0;   // a freed slot holds the index of the next
+   static inline std::mutex mutex;
+};
+
+/*****************************************************
+ * NODE POOL :: ALLOCATE
+ * Reuse a freed slot, or take the next one and grow
+ * when the last chunk is full
+ ****************************************************/
+template <typename Node>
+void * NodePool <Node> :: allocate()
+{
+   std::lock_guard<std::mutex> lock(mutex);
+   if (freeList != 0)
+   {
+      Node * pNode = at(freeList);
+      freeList = *(uint32_t *)pNode;
+      return pNode;
+   }
+   return takeNext();
+}
+
+/*****************************************************
+ * NODE POOL :: ALLOCATE FRESH
+ * Take a slot that was never handed out, passing over
+ * the free list, so slots taken one after another sit
+ * side by side
+ ****************************************************/
+template <typename Node>
+void * NodePool <Node> :: allocateFresh()
+{
+   std::lock_guard<std::mutex> lock(mutex);
+   return takeNext();
+}
+
+/*****************************************************
+ * NODE POOL :: TAKE NEXT
+ * The slot after the last one handed out, growing
+ * when the last chunk is full. The caller holds the lock
+ ****************************************************/
+template <typename Node>
+void * NodePool <Node> :: takeNext()
+{
+   int chunk = chunkOf(numSlots);
+   if (chunk == numChunks)
+   {
+      if (numChunks == maxChunks)
+         throw std::bad_alloc();
+      chunks[chunk] = (unsigned char *)::operator new(chunkSize(chunk) * sizeof(Node));
+      numChunks.store(numChunks + 1, std::memory_order_release);
+   }
+   return at(numSlots++);
+}
+
+/*****************************************************
+ * NODE POOL :: DEALLOCATE
+ * Put a slot on the free list
+ ****************************************************/
+template <typename Node>
+void NodePool <Node> :: deallocate(void * p)
+{
+   if (p == nullptr)
+      return;
+   std::lock_guard<std::mutex> lock(mutex);
+   *(uint32_t *)p = freeList;
+   freeList = indexOf((Node *)p);
+}
+
+/*****************************************************************
+ * NODE BLOCK
+ * Room for nodes laid side by side by BST::compact(). A block is
+ * aligned to its own size, so a node finds the block it is in by
+ * masking its address. The block counts the nodes in it still in
+ * use and frees itself when the last one goes; whoever is filling
+ * it holds one more count so it is not freed in the meantime.
+ *****************************************************************/
+template <typename Node>
+class NodeBlock
+{
+public:
+   // a megabyte, or enough for 64 nodes if that is more
+   static constexpr size_t sizeFor(size_t sizeNode)
+   {
+      size_t size = (size_t)1 << 20;
+      while (size < 64 * sizeNode)
+         size <<= 1;
+      return size;
+   }
+   static const size_t size = sizeFor(sizeof(Node));
+
+   static NodeBlock * create()
+   {
+      return new (::operator new(size, std::align_val_t(size))) NodeBlock;
+   }
+
+   static NodeBlock * of(const Node * pNode)
+   {
+      return (NodeBlock *)((uintptr_t)pNode & ~(uintptr_t)(size - 1));
+   }
+
+   Node * begin() { return (Node *)((unsigned char *)this + offset); }
+   Node * end()   { return begin() + capacity;                       }
+
+   void hold()    { numHeld.fetch_add(1, std::memory_order_relaxed); }
+   void release()
+   {
+      if (numHeld.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+         this->~NodeBlock();
+         ::operator delete((void *)this, std::align_val_t(size));
+      }
+   }
+
+private:
+   NodeBlock() : numHeld(1) {}   // the one filling it
+
+   static const size_t offset = (sizeof(std::atomic<size_t>) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+   static const size_t capacity = (size - offset) / sizeof(Node);
+
+   std::atomic<size_t> numHeld;  // nodes in use, plus one while being filled
+};
+
+/*****************************************************************
+ * INTERVAL
+ * A closed range [lo, hi], ordered by lo and then by hi. A BST of
+ * intervals is an interval tree: every node also keeps the highest
+ * hi in its subtree, so find_overlapping() can pass over subtrees
+ * that end too soon
  *****************************************************************/
+template <typename K>
+struct interval
+{
+   K lo;
+   K hi;
+
+   bool operator <  (const interval & rhs) const
+   {
+      return lo < rhs.lo || (!(rhs.lo < lo) && hi < rhs.hi);
+   }
+   bool operator == (const interval & rhs) const
+   {
+      return !(lo < rhs.lo) && !(rhs.lo < lo) && !(hi < rhs.hi) && !(rhs.hi < hi);
+   }
+};
+
+/*****************************************************************
+ * AUGMENT
+ * What a BST node keeps about its whole subtree besides its own
+ * element. Most trees keep nothing, and their nodes are no bigger
+ * for it; a tree of intervals keeps the highest end
+ *****************************************************************/
+template <typename T>
+struct Augment
+{
+   static const bool enabled = false;
+};
+
+template <typename K>
+struct Augment <interval<K> >
+{
+   static const bool enabled = true;
+   typedef K value_type;
+   static const K & of(const interval<K> & t) { return t.hi; }
+};
+
+template <typename T, bool = Augment<T>::enabled>
+struct AugmentField
+{
+};
+
 template <typename T>
+struct AugmentField <T, true>
+{
+   typename Augment<T>::value_type maxEnd;  // the highest end in the subtree
+};
+
+/*****************************************************************
+ * BINARY SEARCH TREE
+ * Create a Binary Search Tree ordered by Compare. When Compare is
+ * transparent (has is_transparent, like std::less<>), lookups take
+ * any key type Compare can order against T
+ *****************************************************************/
+template <typename T, typename Compare = std::less<T> >
 class BST
 {
    friend class ::TestBST; // give unit tests access to the privates
@@ -66,6 +303,7 @@ public:
    //
 
    BST();
+   explicit BST(const Compare & compare);
    BST(const BST &  rhs);
    BST(      BST && rhs);
    BST(const std::initializer_list<T>& il);
@@ -80,6 +318,9 @@ public:
    BST & operator = (      BST && rhs);
    BST & operator = (const std::initializer_list<T>& il);
    void swap(BST & rhs);
+   template <typename Source>
+   void assign_sorted(size_t num, Source next);
+   void assign_parallel(const BST & rhs, unsigned numThreads = 0);
 
    //
    // Iterator
@@ -89,11 +330,32 @@ public:
    iterator   begin() const noexcept;
    iterator   end()   const noexcept { return iterator(nullptr); }
 
+   // forward-only scans that keep their own stack instead of climbing
+   class scanner;
+   template <typename F>
+   void for_each(F f) const;
+
    //
    // Access
    //
 
    iterator find(const T& t);
+   iterator lower_bound(const T & t) const;
+   iterator upper_bound(const T & t) const;
+   template <typename K, typename C = Compare, typename = typename C::is_transparent>
+   iterator find(const K & k);
+   template <typename K, typename C = Compare, typename = typename C::is_transparent>
+   iterator lower_bound(const K & k) const;
+   template <typename K, typename C = Compare, typename = typename C::is_transparent>
+   iterator upper_bound(const K & k) const;
+   template <typename Keys, typename Out>
+   void find_many(const Keys & keys, Out & out) const;
+
+   // interval trees only: every element overlapping [lo, hi], or holding point
+   template <typename K, typename Out>
+   void find_overlapping(const K & lo, const K & hi, Out & out) const;
+   template <typename K, typename Out>
+   void stab(const K & point, Out & out) const { find_overlapping(point, point, out); }
 
    // 
    // Insert
@@ -101,13 +363,34 @@ public:
 
    std::pair<iterator, bool> insert(const T&  t, bool keepUnique = false);
    std::pair<iterator, bool> insert(      T&& t, bool keepUnique = false);
+   template <typename K, typename C = Compare, typename = typename C::is_transparent,
+             typename = typename std::enable_if<std::is_constructible<T, K &&>::value>::type>
+   std::pair<iterator, bool> insert(K && k, bool keepUnique = false);
+   template <typename... Args>
+   iterator emplace(Args&&... args);
+   template <typename K, typename... Args>
+   std::pair<iterator, bool> try_emplace(const K & k, Args&&... args);
 
    //
    // Remove
    // 
 
    iterator erase(iterator& it);
+   iterator erase(iterator first, iterator last);
+   size_t erase_range(const T & lo, const T & hi);
+   template <typename Pred>
+   size_t erase_if(Pred pred);
    void   clear() noexcept;
+
+   //
+   // Join and Split
+   //
+
+   void join(BST & rhs);
+   BST  split(const T & t);
+   void merge    (BST & rhs, bool parallel = false);
+   void intersect(BST & rhs, bool parallel = false);
+   void subtract (BST & rhs, bool parallel = false);
    
 
    // 
@@ -116,14 +399,93 @@ public:
 
    bool   empty() const noexcept { return size() == 0; }
    size_t size()  const noexcept { return numElements;   }
+   Compare key_comp() const       { return compare;       }
+
+   //
+   // Relayout
+   //
+
+   void compact();
+   bool compact_step(size_t maxNodes);
    
 private:
 
    class BNode;
    BNode * root;              // root node of the binary search tree
    size_t numElements;        // number of elements currently in the tree
-   void assign(typename BST<T>::BNode* srcNode, typename BST<T>::BNode*& destNode);
+   Compare compare;           // orders the elements: compare(a, b) means a < b
+
+   // room for nodes side by side in NodeBlocks, filled by one thread
+   struct NodeArena
+   {
+      NodeBlock<BNode> * pBlock = nullptr;
+      BNode * pSlot = nullptr;
+      void * allocate();
+      void   release();
+   };
+
+   // a compact() under way: the next node to move and where it goes
+   struct Compaction
+   {
+      BNode * pNext = nullptr;
+      NodeArena arena;
+      bool underWay = false;
+   } compaction;
+
+   static const size_t arenaMin = 4096;      // smaller trees are copied onto the heap
+
+   static const size_t findManyWidth = 16;   // lookups find_many() walks down together
+
+   // one comparison per level: descend to the bounds of k
+   template <typename K>
+   BNode * findLowerBound(const K & k) const;
+   template <typename K>
+   BNode * findUpperBound(const K & k) const;
+   template <typename K>
+   std::pair<iterator, bool> insertKey(K && k, bool keepUnique);
+   template <typename K>
+   BNode * findInsertPoint(const K & k, bool & goLeft, BNode * & pNotAfter) const;
+   iterator linkNew(BNode * pNew, BNode * pParent, bool goLeft);
+   void assign(typename BST<T, Compare>::BNode* srcNode, typename BST<T, Compare>::BNode*& destNode);
    void   clear(BNode* node) noexcept;
+   static void freeNode(BNode * pNode);
+
+   // keep an interval tree's maxEnd right as links change; nothing otherwise
+   static void pull(BNode * pNode);
+   static void pullUp(BNode * pNode);
+   static void copyAugment(BNode * pDest, const BNode * pSrc);
+   template <typename K, typename Out>
+   static void findOverlapping(const BNode * pNode, const K & lo, const K & hi, Out & out);
+   BNode * relocate(BNode * pNode);
+   static BNode * newCopy(const BNode * pSrc, NodeArena * pArena);
+   static BNode * copyTree(const BNode * pSrc, NodeArena * pArena);
+   static BNode * copyTree(const BNode * pSrc, int bhSrc, int forks, NodeArena * pArena);
+   void stopCompact();
+
+   // join and split work on detached subtrees and their black heights
+   enum SetOperation { UNION, INTERSECTION, DIFFERENCE };
+   static bool    isRed(const BNode * pNode) { return pNode != nullptr && pNode->isRed(); }
+   static int     blackHeight(const BNode * pNode);
+   static BNode * link(BNode * pLeft, BNode * pNode, BNode * pRight, bool isRed);
+   static BNode * rotateLeft (BNode * pNode);
+   static BNode * rotateRight(BNode * pNode);
+   static BNode * joinRight(BNode * pLeft, int bhLeft, BNode * pMiddle, BNode * pRight, int bhRight);
+   static BNode * joinLeft (BNode * pLeft, int bhLeft, BNode * pMiddle, BNode * pRight, int bhRight);
+   static BNode * join (BNode * pLeft, int bhLeft, BNode * pMiddle, BNode * pRight, int bhRight, int & bh);
+   static BNode * join2(BNode * pLeft, int bhLeft, BNode * pRight, int bhRight, int & bh);
+   static BNode * splitLast(BNode * pNode, int bhNode, BNode *& pLast, int & bh);
+   static void    splitBefore(BNode * pNode, BNode *& pLeft, int & bhLeft, BNode *& pRight, int & bhRight);
+   void    split(BNode * pNode, int bhNode, const T & t, bool lowerBound,
+                 BNode *& pLeft, int & bhLeft, BNode *& pFound,
+                 BNode *& pRight, int & bhRight) const;
+   BNode * combine(SetOperation op, BNode * pA, int bhA, BNode * pB, int bhB,
+                   int & bh, size_t & numFreed, int forks) const;
+   static size_t  destroy(BNode * pNode);
+   template <typename Source>
+   void buildSorted(size_t num, Source & nextNode);
+   template <typename Source>
+   static BNode * buildSorted(size_t num, int depth, int redDepth, Source & nextNode);
+   void combine(SetOperation op, BST & rhs, bool parallel);
  
 
 };
@@ -132,9 +494,23 @@ private:
  * BINARY NODE
  * A single node in a binary tree. Note that the node does not know
  * anything about the properties of the tree so no validation can be done.
+ *
+ * The links are reached only through getLeft()/setLeft() and friends so
+ * the layout can be chosen when compiling:
+ *    default           : three pointers and two bools
+ *    BST_COMPACT_NODE  : the color lives in the low bit of the parent
+ *                        pointer, saving the bools and their padding
+ *    BST_INDEX_NODE    : 32-bit indices into a NodePool instead of
+ *                        pointers, color in the low bit of the parent
+ *
+ * A node laid out by compact() is in a NodeBlock rather than on the
+ * heap, and says so with isInBlock(). Under BST_INDEX_NODE every node
+ * is in the pool, so none is ever in a block.
+ *
+ * A node of an interval tree also has maxEnd, from AugmentField
  *****************************************************************/
-template <typename T>
-class BST <T> :: BNode
+template <typename T, typename Compare>
+class BST <T, Compare> :: BNode : public AugmentField<T>
 {
 public:
    // 
@@ -142,20 +518,34 @@ public:
    //
    BNode()
    {
-      pLeft = pRight = pParent = nullptr;
-      isRed = true;
+      clearLinks();
    }
    BNode(const T &  t) : data(t)
    {
-      pLeft = pRight = pParent = nullptr;
-      isRed = true;
+      clearLinks();
    }
    BNode(T && t) :data(std::move(t))
    {
-      pLeft = pRight = pParent = nullptr;
-      isRed = true;
+      clearLinks();
+   }
+   template <typename... Args>
+   BNode(std::in_place_t, Args&&... args) : data(std::forward<Args>(args)...)
+   {
+      clearLinks();
    }
 
+#ifdef BST_INDEX_NODE
+   // every node comes from the pool so it has an index; the pool hands
+   // out slots of exactly one BNode
+   static void * operator new(size_t size)
+   {
+      assert(size == sizeof(BNode));
+      (void)size;
+      return NodePool<BNode>::allocate();
+   }
+   static void   operator delete(void * p)   { NodePool<BNode>::deallocate(p);     }
+#endif // BST_INDEX_NODE
+
    //
    // Insert
    //
@@ -166,14 +556,55 @@ public:
    void addLeft(       T && t);
    void addRight(      T && t);
 
+   //
+   // Links
+   //
+#if defined(BST_INDEX_NODE)
+   BNode * getLeft()   const { return NodePool<BNode>::at(iLeft);            }
+   BNode * getRight()  const { return NodePool<BNode>::at(iRight);           }
+   BNode * getParent() const { return NodePool<BNode>::at(iParentRed >> 1);  }
+   bool    isRed()     const { return iParentRed & 1;                        }
+   void setLeft  (BNode * pNode) { iLeft  = NodePool<BNode>::indexOf(pNode); }
+   void setRight (BNode * pNode) { iRight = NodePool<BNode>::indexOf(pNode); }
+   void setParent(BNode * pNode) { iParentRed = (NodePool<BNode>::indexOf(pNode) << 1) | (iParentRed & 1); }
+   void setRed(bool isRed)       { iParentRed = (iParentRed & ~1u) | (isRed ? 1 : 0); }
+   void clearLinks()             { iLeft = iRight = 0; iParentRed = 1; }
+   bool isInBlock() const        { return false;                         }
+   void setInBlock()             {                                       }
+#elif defined(BST_COMPACT_NODE)
+   BNode * getLeft()   const { return pLeft;                                 }
+   BNode * getRight()  const { return pRight;                                }
+   BNode * getParent() const { return (BNode *)(parentRed & ~(uintptr_t)3);  }
+   bool    isRed()     const { return parentRed & 1;                         }
+   void setLeft  (BNode * pNode) { pLeft  = pNode;                           }
+   void setRight (BNode * pNode) { pRight = pNode;                           }
+   void setParent(BNode * pNode) { parentRed = (uintptr_t)pNode | (parentRed & 3); }
+   void setRed(bool isRed)       { parentRed = (parentRed & ~(uintptr_t)1) | (isRed ? 1 : 0); }
+   void clearLinks()             { pLeft = pRight = nullptr; parentRed = 1;  }
+   bool isInBlock() const        { return parentRed & 2;                     }
+   void setInBlock()             { parentRed |= 2;                           }
+#else
+   BNode * getLeft()   const { return pLeft;                                 }
+   BNode * getRight()  const { return pRight;                                }
+   BNode * getParent() const { return pParent;                               }
+   bool    isRed()     const { return red;                                   }
+   void setLeft  (BNode * pNode) { pLeft   = pNode;                          }
+   void setRight (BNode * pNode) { pRight  = pNode;                          }
+   void setParent(BNode * pNode) { pParent = pNode;                          }
+   void setRed(bool isRed)       { red = isRed;                              }
+   void clearLinks()             { pLeft = pRight = pParent = nullptr; red = true; inBlock = false; }
+   bool isInBlock() const        { return inBlock;                           }
+   void setInBlock()             { inBlock = true;                           }
+#endif
+
    // 
    // Status
    //
-   bool isRightChild() const {return pParent && pParent->pRight == this;}
-   bool isLeftChild() const {return pParent && pParent->pLeft == this;}
+   bool isRightChild() const {return getParent() && getParent()->getRight() == this;}
+   bool isLeftChild() const {return getParent() && getParent()->getLeft() == this;}
 
    // balance the tree
-   void balance(BST<T>* bst);
+   void balance(BST<T, Compare>* bst);
 
 #ifdef DEBUG
    //
@@ -189,19 +620,30 @@ public:
    // Data
    //
    T data;                  // Actual data stored in the BNode
+private:
+#if defined(BST_INDEX_NODE)
+   uint32_t iLeft;          // Left child's index in the pool, 0 for none
+   uint32_t iRight;         // Right child's index
+   uint32_t iParentRed;     // Parent's index shifted up one, red in bit 0
+#elif defined(BST_COMPACT_NODE)
+   BNode* pLeft;            // Left child - smaller
+   BNode* pRight;           // Right child - larger
+   uintptr_t parentRed;     // Parent's address, red in bit 0, in a block in bit 1
+#else
    BNode* pLeft;          // Left child - smaller
    BNode* pRight;         // Right child - larger
    BNode* pParent;        // Parent
-   bool isRed;              // Red-black balancing stuff
-   
+   bool red;                // Red-black balancing stuff
+   bool inBlock;            // Laid out by compact()
+#endif
 };
 
 /**********************************************************
  * BINARY SEARCH TREE ITERATOR
  * Forward and reverse iterator through a BST
  *********************************************************/
-template <typename T>
-class BST <T> :: iterator
+template <typename T, typename Compare>
+class BST <T, Compare> :: iterator
 {
    friend class ::TestBST; // give unit tests access to the privates
    friend class ::TestSet;
@@ -252,7 +694,11 @@ public:
    }
 
    // must give friend status to remove so it can call getNode() from it
-   friend BST <T> :: iterator BST <T> :: erase(iterator & it);
+   friend BST <T, Compare> :: iterator BST <T, Compare> :: erase(iterator & it);
+   friend BST <T, Compare> :: iterator BST <T, Compare> :: erase(iterator first, iterator last);
+   template <typename Pred>
+   friend size_t BST <T, Compare> :: erase_if(Pred pred);
+   friend bool BST <T, Compare> :: compact_step(size_t maxNodes);
 
 private:
    
@@ -261,6 +707,67 @@ private:
 };
 
 
+/**********************************************************
+ * BINARY SEARCH TREE SCANNER
+ * Visit every element in order, front to back, without touching the
+ * parent pointers. The nodes still to be visited are kept on a stack,
+ * and each one's right child is prefetched as it goes on so that it is
+ * in cache by the time the left subtree has been visited
+ *********************************************************/
+template <typename T, typename Compare>
+class BST <T, Compare> :: scanner
+{
+public:
+   explicit scanner(const BST & bst) : stack(inlineStack), depth(0), capacity(inlineCapacity)
+   {
+      pushLeft(bst.root);
+   }
+   ~scanner()
+   {
+      if (stack != inlineStack)
+         delete [] stack;
+   }
+   scanner(const scanner &) = delete;
+   scanner & operator = (const scanner &) = delete;
+
+   // the current element
+   bool done() const           { return depth == 0;               }
+   const T & operator * () const { return stack[depth - 1]->data; }
+
+   // advance by one
+   scanner & operator ++ ()
+   {
+      BNode * pNode = stack[--depth];
+      pushLeft(pNode->getRight());
+      return *this;
+   }
+
+   // copy up to n elements to the back of out, which needs only push_back
+   template <typename Out>
+   size_t collect(Out & out, size_t n);
+
+private:
+   static const int inlineCapacity = 64;   // enough for any red-black tree this side of 2^32
+
+   void pushLeft(BNode * pNode)
+   {
+      for (; pNode; pNode = pNode->getLeft())
+      {
+         if (depth == capacity)
+            grow();
+         if (BNode * pRight = pNode->getRight())
+            __builtin_prefetch(pRight);
+         stack[depth++] = pNode;
+      }
+   }
+   void grow();
+
+   BNode ** stack;            // the nodes still to visit, the next one on top
+   int depth;                 // number on the stack
+   int capacity;              // room on the stack
+   BNode * inlineStack[inlineCapacity];
+};
+
 /*********************************************
  *********************************************
  *********************************************
@@ -273,8 +780,19 @@ private:
  /*********************************************
   * BST :: DEFAULT CONSTRUCTOR
   ********************************************/
-template <typename T>
-BST <T> ::BST()
+template <typename T, typename Compare>
+BST <T, Compare> ::BST()
+{
+   numElements = 0;
+   root = nullptr;
+}
+
+/*********************************************
+ * BST :: COMPARE CONSTRUCTOR
+ * An empty tree ordered by a given comparator
+ ********************************************/
+template <typename T, typename Compare>
+BST <T, Compare> :: BST(const Compare & compare) : compare(compare)
 {
    numElements = 0;
    root = nullptr;
@@ -284,8 +802,8 @@ BST <T> ::BST()
  * BST :: COPY CONSTRUCTOR
  * Copy one tree to another
  ********************************************/
-template <typename T>
-BST <T> :: BST ( const BST<T>& rhs) 
+template <typename T, typename Compare>
+BST <T, Compare> :: BST ( const BST<T, Compare>& rhs) : compare(rhs.compare)
 {
    numElements = 0;
    root = nullptr;
@@ -297,22 +815,23 @@ BST <T> :: BST ( const BST<T>& rhs)
  * BST :: MOVE CONSTRUCTOR
  * Move one tree to another
  ********************************************/
-template <typename T>
-BST <T> :: BST(BST <T> && rhs) 
+template <typename T, typename Compare>
+BST <T, Compare> :: BST(BST <T, Compare> && rhs) : compare(rhs.compare)
 {
    numElements = rhs.numElements;
    root = rhs.root;
    
    rhs.root = nullptr;
    rhs.numElements = 0;
+   std::swap(compaction, rhs.compaction);
 }
 
 /*********************************************
  * BST :: INITIALIZER LIST CONSTRUCTOR
  * Create a BST from an initializer list
  ********************************************/
-template <typename T>
-BST <T> ::BST(const std::initializer_list<T>& il)
+template <typename T, typename Compare>
+BST <T, Compare> ::BST(const std::initializer_list<T>& il)
 {
    numElements = 0;
    root = nullptr;
@@ -323,8 +842,8 @@ BST <T> ::BST(const std::initializer_list<T>& il)
 /*********************************************
  * BST :: DESTRUCTOR
  ********************************************/
-template <typename T>
-BST <T> :: ~BST()
+template <typename T, typename Compare>
+BST <T, Compare> :: ~BST()
 {
    clear();
 }
@@ -334,10 +853,12 @@ BST <T> :: ~BST()
  * BST :: ASSIGNMENT OPERATOR
  * Copy one tree to another
  ********************************************/
-template <typename T>
-BST<T>& BST<T>::operator=(const BST& rhs)
+template <typename T, typename Compare>
+BST<T, Compare>& BST<T, Compare>::operator=(const BST& rhs)
 {
     if (this == &rhs)   return *this;
+    compare = rhs.compare;
+    stopCompact();  // the nodes it would move next may be reused or freed
    
     // Step 1: Clear the destination tree if the source is empty
     if (rhs.root == nullptr)
@@ -346,8 +867,16 @@ BST<T>& BST<T>::operator=(const BST& rhs)
         return *this;  // No need to do further work if rhs is empty
     }
 
-    // Step 2: Reuse the existing nodes in the destination tree by updating their data
-    assign(rhs.root, root);
+    // Step 2: Reuse the existing nodes in the destination tree by updating their data.
+    // With none to reuse, as when copy constructing, copy without recursing
+    if (root == nullptr)
+    {
+       NodeArena arena;
+       root = copyTree(rhs.root, rhs.numElements >= arenaMin ? &arena : nullptr);
+       arena.release();
+    }
+    else
+       assign(rhs.root, root);
 
     // Step 3: Copy the number of elements from rhs
     numElements = rhs.numElements;
@@ -359,45 +888,177 @@ BST<T>& BST<T>::operator=(const BST& rhs)
  * BST :: ASSIGN
  * Reuse nodes or create new ones in the destination tree based on the source
  ********************************************/
-template <typename T>
-void BST<T>::assign(typename BST<T>::BNode* srcNode, typename BST<T>::BNode*& destNode)
+template <typename T, typename Compare>
+void BST<T, Compare>::assign(typename BST<T, Compare>::BNode* srcNode, typename BST<T, Compare>::BNode*& destNode)
 {
    if (srcNode == nullptr)
    {
-      clear(destNode);
-      return;  // If the source node is null, do nothing
+      // a surplus subtree: free it whole, since erasing would pull stale
+      // augments up into the ancestors already assigned
+      destroy(destNode);
+      destNode = nullptr;
+      return;
    }
 
    // If destination node is null, create a new node in the destination tree
    if (destNode == nullptr)
    {
       destNode = new BNode(srcNode->data);
-      destNode->isRed = srcNode->isRed;  // Copy the color (isRed) for Red-Black Tree
+      destNode->setRed(srcNode->isRed());  // Copy the color (isRed) for Red-Black Tree
    }
    // If destination node exists, update its data
    else
    {
       destNode->data = srcNode->data;
-      destNode->isRed = srcNode->isRed;  // Update color to match source node's color
+      destNode->setRed(srcNode->isRed());  // Update color to match source node's color
    }
 
    // Recursively copy the left and right children
-   assign(srcNode->pLeft, destNode->pLeft);
-   assign(srcNode->pRight, destNode->pRight);
+   BNode * pLeft = destNode->getLeft();
+   BNode * pRight = destNode->getRight();
+   assign(srcNode->getLeft(), pLeft);
+   assign(srcNode->getRight(), pRight);
+   destNode->setLeft(pLeft);
+   destNode->setRight(pRight);
 
    // Ensure parent pointers are updated after changing the subtrees
-   if (destNode->pLeft) destNode->pLeft->pParent = destNode;
-   if (destNode->pRight) destNode->pRight->pParent = destNode;
+   if (destNode->getLeft()) destNode->getLeft()->setParent(destNode);
+   if (destNode->getRight()) destNode->getRight()->setParent(destNode);
+
+   pull(destNode);  // from both children, now that they are assigned
+}
+
+
+/*********************************************
+ * BST :: ASSIGN PARALLEL
+ * Copy rhs on up to numThreads threads (all the
+ * cores when 0). Each thread copies whole subtrees
+ * into an arena of its own, so the threads share
+ * neither an allocator lock nor cache lines
+ *   COST   : O(n / numThreads + log n)
+ ********************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: assign_parallel(const BST & rhs, unsigned numThreads)
+{
+   if (this == &rhs)
+      return;
+   clear();
+   compare = rhs.compare;
+
+   // fork until there is a subtree for every thread
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   int forks = 0;
+   for (unsigned num = 1; num < numThreads; num *= 2)
+      forks++;
+
+   NodeArena arena;
+   root = copyTree(rhs.root, blackHeight(rhs.root), forks,
+                   rhs.numElements >= arenaMin ? &arena : nullptr);
+   arena.release();
+   numElements = rhs.numElements;
+}
+
+/*********************************************
+ * BST :: NEW COPY
+ * A node with a copy of pSrc's element and color,
+ * in the arena if there is one
+ ********************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: newCopy(const BNode * pSrc, NodeArena * pArena)
+{
+   BNode * pNew;
+   if (pArena)
+   {
+      pNew = ::new (pArena->allocate()) BNode(pSrc->data);
+      pNew->setInBlock();
+   }
+   else
+      pNew = new BNode(pSrc->data);
+   pNew->setRed(pSrc->isRed());
+   copyAugment(pNew, pSrc);
+   return pNew;
 }
 
+/*********************************************
+ * BST :: COPY TREE
+ * Copy a subtree front to back without recursing,
+ * however deep it is: the source is walked by its
+ * parent pointers, and a copy's left or right is
+ * filled in once that side is done
+ *   OUTPUT : the copy, without a parent
+ ********************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: copyTree(const BNode * pSrc, NodeArena * pArena)
+{
+   if (pSrc == nullptr)
+      return nullptr;
+
+   BNode * pCopy = newCopy(pSrc, pArena);
+   const BNode * pFrom = pSrc;
+   BNode * pTo = pCopy;
+   while (true)
+   {
+      if (pFrom->getLeft() && !pTo->getLeft())
+      {
+         pFrom = pFrom->getLeft();
+         pTo->addLeft(newCopy(pFrom, pArena));
+         pTo = pTo->getLeft();
+      }
+      else if (pFrom->getRight() && !pTo->getRight())
+      {
+         pFrom = pFrom->getRight();
+         pTo->addRight(newCopy(pFrom, pArena));
+         pTo = pTo->getRight();
+      }
+      else if (pFrom == pSrc)
+         return pCopy;
+      else
+      {
+         pFrom = pFrom->getParent();
+         pTo = pTo->getParent();
+      }
+   }
+}
+
+/*********************************************
+ * BST :: COPY TREE (parallel)
+ * Copy the root here, hand the left subtree to
+ * another thread with an arena of its own, and copy
+ * the right one here. Small subtrees are not worth a
+ * thread
+ *   INPUT  : the subtree, its black height, and how
+ *            many more times to fork
+ ********************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: copyTree(const BNode * pSrc, int bhSrc,
+                                                                  int forks, NodeArena * pArena)
+{
+   if (forks <= 0 || bhSrc < 6)
+      return copyTree(pSrc, pArena);
+
+   BNode * pCopy = newCopy(pSrc, pArena);
+   int bhChild = bhSrc - !pSrc->isRed();
+   auto left = std::async(std::launch::async, [&]()
+   {
+      NodeArena arena;
+      BNode * pLeft = copyTree(pSrc->getLeft(), bhChild, forks - 1, pArena ? &arena : nullptr);
+      arena.release();
+      return pLeft;
+   });
+   BNode * pRight = copyTree(pSrc->getRight(), bhChild, forks - 1, pArena);
+   pCopy->addLeft(left.get());
+   pCopy->addRight(pRight);
+   return pCopy;
+}
 
 /*********************************************
  * BST :: ASSIGNMENT OPERATOR with INITIALIZATION LIST
  * Copy nodes onto a BTree
  ********************************************/
 
-template <typename T>
-BST<T>& BST<T>::operator=(const std::initializer_list<T>& il)
+template <typename T, typename Compare>
+BST<T, Compare>& BST<T, Compare>::operator=(const std::initializer_list<T>& il)
 {
    // Clear the current tree
    clear();
@@ -416,8 +1077,8 @@ BST<T>& BST<T>::operator=(const std::initializer_list<T>& il)
  * BST :: ASSIGN-MOVE OPERATOR
  * Move one tree to another
  ********************************************/
-template <typename T>
-BST <T> & BST <T> :: operator = (BST <T> && rhs)
+template <typename T, typename Compare>
+BST <T, Compare> & BST <T, Compare> :: operator = (BST <T, Compare> && rhs)
 {
    if (this == &rhs)  {return *this;}
    clear();
@@ -429,14 +1090,18 @@ BST <T> & BST <T> :: operator = (BST <T> && rhs)
  * BST :: SWAP
  * Swap two trees
  ********************************************/
-template <typename T>
-void BST<T>::swap(BST<T>& rhs)
+template <typename T, typename Compare>
+void BST<T, Compare>::swap(BST<T, Compare>& rhs)
 {
    // Swap the root nodes of the two trees
    std::swap(this->root, rhs.root);
 
    // Swap numElements of the two trees
    std::swap(this->numElements, rhs.numElements);
+
+   // The order goes with the elements, as does a compact() under way
+   std::swap(this->compare, rhs.compare);
+   std::swap(this->compaction, rhs.compaction);
 }
 
 
@@ -444,137 +1109,162 @@ void BST<T>::swap(BST<T>& rhs)
  * BST :: INSERT
  * Insert a node at a given location in the tree
  ****************************************************/
-template <typename T>
-std::pair<typename BST<T>::iterator, bool> BST<T>::insert(const T& t, bool keepUnique)
+template <typename T, typename Compare>
+std::pair<typename BST<T, Compare>::iterator, bool> BST<T, Compare>::insert(const T& t, bool keepUnique)
 {
-   // If the tree is empty, insert the first node
-   if (!root)
-   {
-      root = new BNode(t);
-      root->isRed = false; // The root should always be black
-      numElements++;
-      return { iterator(root), true };
-   }
-
-   BNode* pCurrent = root;
-   
-
-   // Traverse the tree to find the correct insertion point
-   while (pCurrent)
-   {
-  
-      if (keepUnique and t == pCurrent->data)
-      {
-         return { iterator(pCurrent), false };
-      }
-      else
-      {
-         if (t < pCurrent->data)
-         {
-            if (pCurrent->pLeft)
-            {
-               pCurrent = pCurrent->pLeft;
-            }
-            else
-            {
-               // Create new node if there's no left child
-               BNode* newNode = new BNode(t);
-               pCurrent->addLeft(newNode);
-               newNode->balance(this);
-               numElements++;
-               return { iterator(pCurrent->pLeft), true }; // New node inserted
-            }
-         }
-         else
-         {
-            if (pCurrent->pRight)
-            {
-               pCurrent = pCurrent->pRight;
-            }
-            else
-            {
-               // Create new node if there's no right child
-               BNode* newNode = new BNode(t);
-               pCurrent->addRight(newNode);
-               newNode->balance(this);
-               numElements++;
-               return { iterator(pCurrent->pRight), true }; // New node inserted
-               
-            }
-         }
-      }
-   }
+   return insertKey(t, keepUnique);
+}
 
-    // Control should never reach here
-    return { iterator(nullptr), false };
+template <typename T, typename Compare>
+std::pair<typename BST <T, Compare> ::iterator, bool> BST <T, Compare> ::insert(T && t, bool keepUnique)
+{
+   return insertKey(std::move(t), keepUnique);
 }
 
+/*****************************************************
+ * BST :: INSERT with a TRANSPARENT KEY
+ * Only build a T from k when it goes in: a duplicate
+ * under keepUnique costs no construction
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename K, typename C, typename, typename>
+std::pair<typename BST <T, Compare> :: iterator, bool> BST <T, Compare> :: insert(K && k, bool keepUnique)
+{
+   return insertKey(std::forward<K>(k), keepUnique);
+}
 
+/*****************************************************
+ * BST :: INSERT KEY
+ * Find where k goes, and make a node for it only
+ * once we know it is going in
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename K>
+std::pair<typename BST <T, Compare> :: iterator, bool> BST <T, Compare> :: insertKey(K && k, bool keepUnique)
+{
+   bool goLeft;
+   BNode * pNotAfter;
+   BNode * pParent = findInsertPoint(k, goLeft, pNotAfter);
 
+   if (keepUnique && pNotAfter && !compare(pNotAfter->data, k))
+      return { iterator(pNotAfter), false };  // Duplicate found, no insertion
 
+   BNode * pNew;
+   if constexpr (std::is_same<typename std::decay<K>::type, T>::value)
+      pNew = new BNode(std::forward<K>(k));
+   else
+      pNew = new BNode(T(std::forward<K>(k)));
+   return { linkNew(pNew, pParent, goLeft), true };
+}
 
+/*****************************************************
+ * BST :: EMPLACE
+ * Build the element in its node from args, then hang
+ * the node where it goes. Like insert(), this keeps
+ * duplicates, so the node is never built for nothing
+ *   COST   : O(log n), one T constructed, no copies
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename... Args>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: emplace(Args&&... args)
+{
+   BNode * pNew = new BNode(std::in_place, std::forward<Args>(args)...);
+   bool goLeft;
+   BNode * pNotAfter;
+   BNode * pParent = findInsertPoint(pNew->data, goLeft, pNotAfter);
+   return linkNew(pNew, pParent, goLeft);
+}
 
+/*****************************************************
+ * BST :: TRY EMPLACE
+ * Look for k, and only if it is not there build an
+ * element from args (or from k when there are none).
+ * k is compared where it is, never copied, so a
+ * duplicate costs nothing but the descent. The element
+ * args build must be equal to k: it goes where k does
+ *   INPUT  : k, a T or a key the comparator takes
+ *   OUTPUT : the element with key k, and whether it is new
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename K, typename... Args>
+std::pair<typename BST <T, Compare> :: iterator, bool> BST <T, Compare> :: try_emplace(const K & k, Args&&... args)
+{
+   bool goLeft;
+   BNode * pNotAfter;
+   BNode * pParent = findInsertPoint(k, goLeft, pNotAfter);
 
-template <typename T>
-std::pair<typename BST <T> ::iterator, bool> BST <T> ::insert(T && t, bool keepUnique)
+   if (pNotAfter && !compare(pNotAfter->data, k))
+      return { iterator(pNotAfter), false };
 
-{
-   if (!root)
+   BNode * pNew;
+   if constexpr (sizeof...(Args) == 0)
+      pNew = new BNode(std::in_place, k);
+   else
    {
-      root = new BNode(std::move(t));  // Move the value into the node
-      root->isRed = false;  // The root should always be black
-      numElements++;
-      return { iterator(root), true };
+      pNew = new BNode(std::in_place, std::forward<Args>(args)...);
+      assert(!compare(k, pNew->data) && !compare(pNew->data, k));
    }
+   return { linkNew(pNew, pParent, goLeft), true };
+}
 
-   BNode* pCurrent = root;
+/*****************************************************
+ * BST :: FIND INSERT POINT
+ * Walk down with one comparison per level, remembering
+ * the last node we went right at: that is the largest
+ * element not after k, so it alone can be a duplicate
+ *   OUTPUT : the node to hang k from (nullptr for an
+ *            empty tree), the side, and pNotAfter
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename K>
+typename BST <T, Compare> :: BNode *
+BST <T, Compare> :: findInsertPoint(const K & k, bool & goLeft, BNode * & pNotAfter) const
+{
+   BNode * pParent = nullptr;
+   pNotAfter = nullptr;
+   goLeft = false;
 
    // Traverse the tree to find the correct insertion point
-   while (pCurrent)
+   for (BNode * pCurrent = root; pCurrent; )
    {
-      if (keepUnique && t == pCurrent->data)
+      pParent = pCurrent;
+      goLeft = compare(k, pCurrent->data);
+      if (goLeft)
+         pCurrent = pCurrent->getLeft();
+      else
       {
-         return { iterator(pCurrent), false };  // Duplicate found, no insertion
-      }
-      else
-      {
-         if (t < pCurrent->data)
-         {
-            if (pCurrent->pLeft)
-            {
-                  pCurrent = pCurrent->pLeft;
-            }
-            else
-            {
-               // Create new node using move semantics
-               BNode* newNode = new BNode(std::move(t));
-               pCurrent->addLeft(newNode);
-               newNode->balance(this);
-               numElements++;
-               return { iterator(pCurrent->pLeft), true };  // New node inserted
-            }
-         }
-         else
-         {  // t > pCurrent->data
-            if (pCurrent->pRight)
-            {
-               pCurrent = pCurrent->pRight;
-            }
-            else
-            {
-               // Create new node using move semantics
-               BNode* newNode = new BNode(std::move(t));
-               pCurrent->addRight(newNode);
-               newNode->balance(this);
-               numElements++;
-               return { iterator(pCurrent->pRight), true };  // New node inserted
-            }
-         }
+         pNotAfter = pCurrent;
+         pCurrent = pCurrent->getRight();
       }
    }
+   return pParent;
+}
+
+/*****************************************************
+ * BST :: LINK NEW
+ * Hang a new node from pParent and rebalance
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: linkNew(BNode * pNew, BNode * pParent, bool goLeft)
+{
+   numElements++;
+
+   // If the tree is empty, the new node is the root
+   if (pParent == nullptr)
+   {
+      root = pNew;
+      root->setRed(false);  // The root should always be black
+      pull(root);
+      return iterator(root);
+   }
 
-    // Control should never reach here
-    return { iterator(nullptr), false };
+   if (goLeft)
+      pParent->addLeft(pNew);
+   else
+      pParent->addRight(pNew);
+   pullUp(pNew);
+   pNew->balance(this);
+   return iterator(pNew);
 }
 
 
@@ -582,8 +1272,8 @@ std::pair<typename BST <T> ::iterator, bool> BST <T> ::insert(T && t, bool keepU
  * BST :: ERASE
  * Remove a given node as specified by the iterator
  ************************************************/
-template <typename T>
-typename BST<T>::iterator BST<T>::erase(iterator & it)
+template <typename T, typename Compare>
+typename BST<T, Compare>::iterator BST<T, Compare>::erase(iterator & it)
 {
    if (!it.pNode) { return end();} // Return end iterator if the node is null
 
@@ -592,84 +1282,104 @@ typename BST<T>::iterator BST<T>::erase(iterator & it)
 
    --numElements; // Decrement the number of elements before deletion
 
-   // Case 1: Node is the root
-   if (nodeToDelete == root)
+   // a compact() under way moves on to the next node instead
+   if (nodeToDelete == compaction.pNext)
+      compaction.pNext = nextIterator.pNode;
+
+   // the lowest node whose subtree changes, for an interval tree's maxEnd
+   BNode * pChanged = nodeToDelete->getParent();
+   if (nodeToDelete->getLeft() && nodeToDelete->getRight())
+   {
+      BNode * pSuccessor = nextIterator.pNode;
+      pChanged = pSuccessor->getParent() == nodeToDelete ? pSuccessor : pSuccessor->getParent();
+   }
+
+   // Case 1: Node is the root and has no children
+   if (nodeToDelete == root && !root->getLeft() && !root->getRight())
    {
       root = nullptr; // Reset root to null since we deleted it
-      delete nodeToDelete;
+      freeNode(nodeToDelete);
       return end(); // Return end as there's no next node
    }
 
    // Case 2: Node has no children (leaf node)
-   if (!nodeToDelete->pLeft && !nodeToDelete->pRight)
+   if (!nodeToDelete->getLeft() && !nodeToDelete->getRight())
    {
-      if (nodeToDelete->pParent->pLeft == nodeToDelete)
+      if (nodeToDelete->getParent()->getLeft() == nodeToDelete)
       {
-         nodeToDelete->pParent->pLeft = nullptr; // Disconnect from parent
+         nodeToDelete->getParent()->setLeft(nullptr); // Disconnect from parent
       }
       else
       {
-         nodeToDelete->pParent->pRight = nullptr; // Disconnect from parent
+         nodeToDelete->getParent()->setRight(nullptr); // Disconnect from parent
       }
    }
    // Case 3: Node has two children
-   else if (nodeToDelete->pLeft && nodeToDelete->pRight)
+   else if (nodeToDelete->getLeft() && nodeToDelete->getRight())
    {
       BNode* successor = nextIterator.pNode; // Use the successor found by the iterator
 
       // Disconnect the successor from its parent
-      if (successor->pParent)
+      if (successor->getParent())
       {
          if (successor->isLeftChild())
          {
-            successor->pParent->addLeft(successor->pRight); // Link the right child
+            successor->getParent()->addLeft(successor->getRight()); // Link the right child
          }
          else
          {
-            successor->pParent->addRight(successor->pRight); // Link the right child
+            successor->getParent()->addRight(successor->getRight()); // Link the right child
          }
       }
 
       // Replace nodeToDelete with the successor
-      if (nodeToDelete->isLeftChild())
+      if (nodeToDelete == root)
       {
-         nodeToDelete->pParent->addLeft(successor);
+         root = successor;
+         successor->setParent(nullptr);
+      }
+      else if (nodeToDelete->isLeftChild())
+      {
+         nodeToDelete->getParent()->addLeft(successor);
       }
       else
       {
-         nodeToDelete->pParent->addRight(successor);
+         nodeToDelete->getParent()->addRight(successor);
       }
+      successor->setRed(nodeToDelete->isRed());
 
       // Now link the children of nodeToDelete to the successor
-      successor->addLeft(nodeToDelete->pLeft);
-      successor->addRight(nodeToDelete->pRight);
+      successor->addLeft(nodeToDelete->getLeft());
+      successor->addRight(nodeToDelete->getRight());
 
    }
    // Case 4: Node has one child (left or right)
    else
    {
-      BNode* child = nodeToDelete->pLeft ? nodeToDelete->pLeft : nodeToDelete->pRight;
-      child->pParent = nodeToDelete->pParent; // Connect child to parent
+      BNode* child = nodeToDelete->getLeft() ? nodeToDelete->getLeft() : nodeToDelete->getRight();
+      child->setParent(nodeToDelete->getParent()); // Connect child to parent
 
-      if (nodeToDelete->pParent)
+      if (nodeToDelete->getParent())
       {
-         if (nodeToDelete->pParent->pLeft == nodeToDelete)
+         if (nodeToDelete->getParent()->getLeft() == nodeToDelete)
          {
-            nodeToDelete->pParent->pLeft = child; // Link child to parent
+            nodeToDelete->getParent()->setLeft(child); // Link child to parent
          }
          else
          {
-            nodeToDelete->pParent->pRight = child; // Link child to parent
+            nodeToDelete->getParent()->setRight(child); // Link child to parent
          }
       }
       else
       {
          root = child; // Update root if necessary
+         root->setRed(false); // the root is always black
       }
    }
 
    // Delete the node
-   delete nodeToDelete;
+   freeNode(nodeToDelete);
+   pullUp(pChanged);
    
    // Return the iterator to the next node after deletion
    return nextIterator;
@@ -682,9 +1392,12 @@ typename BST<T>::iterator BST<T>::erase(iterator & it)
  * BST :: CLEAR
  * Removes all the BNodes from a tree
  ****************************************************/
-template <typename T>
-void BST<T>::clear() noexcept
+template <typename T, typename Compare>
+void BST<T, Compare>::clear() noexcept
 {
+   // a compact() under way would be left on a freed node
+   stopCompact();
+
    // Start clearing from the root node if it's not already null
    if (root != nullptr)
    {
@@ -693,8 +1406,8 @@ void BST<T>::clear() noexcept
    }
 }
 
-template <typename T>
-void BST<T>::clear(BNode* node) noexcept
+template <typename T, typename Compare>
+void BST<T, Compare>::clear(BNode* node) noexcept
 {
    if (node == nullptr)
    {
@@ -702,13 +1415,13 @@ void BST<T>::clear(BNode* node) noexcept
    }
 
    // Recursively clear the left and right subtrees first
-   if (node->pLeft)
+   if (node->getLeft())
    {
-      clear(node->pLeft);  // Clear left child
+      clear(node->getLeft());  // Clear left child
    }
-   if (node->pRight)
+   if (node->getRight())
    {
-      clear(node->pRight);  // Clear right child
+      clear(node->getRight());  // Clear right child
    }
 
    // After children are cleared, erase the current node
@@ -722,12 +1435,209 @@ void BST<T>::clear(BNode* node) noexcept
 
 
 
+/*****************************************************
+ * BST :: ERASE (range)
+ * Remove [first, last) by cutting the tree just before
+ * each end, freeing the middle, and joining what is
+ * left. The nodes in between are freed without being
+ * unlinked one at a time
+ *   OUTPUT : last, which is still valid
+ *   COST   : O(k + log n) for k elements removed
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: erase(iterator first, iterator last)
+{
+   if (first == last)
+      return last;
+   stopCompact();
+
+   // cut off [last, end), then cut [first, last) off what is before it
+   BNode * pBefore;
+   BNode * pAfter = nullptr;
+   int bhBefore;
+   int bhAfter = 0;
+   if (last.pNode)
+      splitBefore(last.pNode, pBefore, bhBefore, pAfter, bhAfter);
+   else
+   {
+      pBefore = root;
+      bhBefore = blackHeight(root);
+   }
+   root = pBefore;
+
+   BNode * pLeft;
+   BNode * pMiddle;
+   int bhLeft;
+   int bhMiddle;
+   splitBefore(first.pNode, pLeft, bhLeft, pMiddle, bhMiddle);
+   numElements -= destroy(pMiddle);
+
+   int bh;
+   root = join2(pLeft, bhLeft, pAfter, bhAfter, bh);
+   if (root)
+   {
+      root->setParent(nullptr);
+      root->setRed(false);
+   }
+   return last;
+}
+
+/*****************************************************
+ * BST :: ERASE RANGE
+ * Remove every element not before lo and before hi
+ *   OUTPUT : how many were removed
+ *   COST   : O(k + log n)
+ ****************************************************/
+template <typename T, typename Compare>
+size_t BST <T, Compare> :: erase_range(const T & lo, const T & hi)
+{
+   if (!compare(lo, hi))
+      return 0;
+   size_t numBefore = numElements;
+   erase(lower_bound(lo), lower_bound(hi));
+   return numBefore - numElements;
+}
+
+/*****************************************************
+ * BST :: ERASE IF
+ * Remove every element pred picks in one pass. Every
+ * element has to be tested anyway, so rather than
+ * unlink the picked ones one at a time, take all the
+ * nodes off in order, free the picked ones, and build
+ * a balanced tree from the rest
+ *   INPUT  : pred, called once per element in order
+ *   OUTPUT : how many were removed
+ *   COST   : O(n)
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename Pred>
+size_t BST <T, Compare> :: erase_if(Pred pred)
+{
+   if (root == nullptr)
+      return 0;
+   stopCompact();
+
+   // kept nodes fill the front, picked ones the back. Nothing is freed
+   // until the walk is done, since the walk climbs through ancestors
+   BNode ** pNodes = new BNode * [numElements];
+   size_t numKept = 0;
+   size_t numPicked = 0;
+   BNode * pFirst = root;
+   while (pFirst->getLeft())
+      pFirst = pFirst->getLeft();
+   for (iterator it(pFirst); it != end(); )
+   {
+      BNode * pNode = it.pNode;
+      ++it;
+      if (pred(pNode->data))
+         pNodes[numElements - ++numPicked] = pNode;
+      else
+         pNodes[numKept++] = pNode;
+   }
+
+   if (numPicked)
+   {
+      for (size_t i = numKept; i < numElements; i++)
+         freeNode(pNodes[i]);
+      size_t i = 0;
+      auto nextNode = [pNodes, &i]() { return pNodes[i++]; };
+      buildSorted(numKept, nextNode);
+   }
+   delete [] pNodes;
+   return numPicked;
+}
+
+/*****************************************************
+ * BST :: ASSIGN SORTED
+ * Replace the contents with num elements, taken in
+ * order by calling next() num times. The elements
+ * must already be sorted, so nothing is compared and
+ * the tree is built balanced in one pass. If next()
+ * throws, the tree is left empty
+ *   INPUT  : how many, and where to get them from
+ *   COST   : O(n)
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename Source>
+void BST <T, Compare> :: assign_sorted(size_t num, Source next)
+{
+   clear();
+   auto nextNode = [&next]() { return new BNode(next()); };
+   buildSorted(num, nextNode);
+}
+
+/*****************************************************
+ * BST :: BUILD SORTED
+ * Make the tree out of num nodes, taken in order by
+ * calling nextNode(). Whatever links the nodes had
+ * are overwritten
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename Source>
+void BST <T, Compare> :: buildSorted(size_t num, Source & nextNode)
+{
+   // the levels above redDepth are full; the nodes on the partial
+   // level below them are red, which keeps every path's black count equal
+   int redDepth = 0;
+   while ((((size_t)2 << redDepth) - 1) <= num)
+      redDepth++;
+
+   root = buildSorted(num, 0 /*depth*/, redDepth, nextNode);
+   if (root)
+   {
+      root->setParent(nullptr);
+      root->setRed(false);
+   }
+   numElements = num;
+}
+
+/*****************************************************
+ * BST :: BUILD SORTED (subtree)
+ * Build a subtree of num nodes: the first half on
+ * the left, then the middle, then the rest on the right
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename Source>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: buildSorted(size_t num, int depth,
+                                                                     int redDepth, Source & nextNode)
+{
+   if (num == 0)
+      return nullptr;
+   size_t numLeft = (num - 1) / 2;
+   BNode * pLeft = buildSorted(numLeft, depth + 1, redDepth, nextNode);
+
+   // should making an element throw, free what is built so far and pass it on
+   BNode * pNode;
+   try
+   {
+      pNode = nextNode();
+   }
+   catch (...)
+   {
+      destroy(pLeft);
+      throw;
+   }
+   pNode->addLeft(pLeft);
+   try
+   {
+      pNode->addRight(buildSorted(num - 1 - numLeft, depth + 1, redDepth, nextNode));
+   }
+   catch (...)
+   {
+      destroy(pNode);
+      throw;
+   }
+   pNode->setRed(depth == redDepth);
+   pull(pNode);
+   return pNode;
+}
+
 /*****************************************************
  * BST :: BEGIN
  * Return the first node (left-most) in a binary search tree
  ****************************************************/
-template <typename T>
-typename BST<T>::iterator BST<T>::begin() const noexcept {
+template <typename T, typename Compare>
+typename BST<T, Compare>::iterator BST<T, Compare>::begin() const noexcept {
    if (empty())
    {
       return end(); // Return end() if the tree is empty
@@ -735,9 +1645,9 @@ typename BST<T>::iterator BST<T>::begin() const noexcept {
    else
    {
       BNode* p = root; // Start from the root
-      while (p->pLeft)
+      while (p->getLeft())
       { // Traverse to the leftmost node
-         p = p->pLeft;
+         p = p->getLeft();
       }
       return iterator(p); // Return an iterator pointing to the leftmost node
    }
@@ -747,35 +1657,951 @@ typename BST<T>::iterator BST<T>::begin() const noexcept {
 
 /****************************************************
  * BST :: FIND
- * Return the node corresponding to a given value
+ * Return the node corresponding to a given value.
+ * With duplicates, this is the first of them
  ****************************************************/
-template <typename T>
-typename BST <T> :: iterator BST<T> :: find(const T & t)
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator BST<T, Compare> :: find(const T & t)
+{
+   BNode * pNode = findLowerBound(t);
+   if (pNode && !compare(t, pNode->data))
+      return iterator(pNode);
+
+   // Value not found, return end iterator
+   return end();
+}
+
+template <typename T, typename Compare>
+template <typename K, typename C, typename>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: find(const K & k)
+{
+   BNode * pNode = findLowerBound(k);
+   if (pNode && !compare(k, pNode->data))
+      return iterator(pNode);
+   return end();
+}
+
+/****************************************************
+ * BST :: LOWER BOUND and UPPER BOUND
+ * The first element not before t, and the first
+ * element after t
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: lower_bound(const T & t) const
+{
+   return iterator(findLowerBound(t));
+}
+
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: upper_bound(const T & t) const
+{
+   return iterator(findUpperBound(t));
+}
+
+template <typename T, typename Compare>
+template <typename K, typename C, typename>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: lower_bound(const K & k) const
+{
+   return iterator(findLowerBound(k));
+}
+
+template <typename T, typename Compare>
+template <typename K, typename C, typename>
+typename BST <T, Compare> :: iterator BST <T, Compare> :: upper_bound(const K & k) const
+{
+   return iterator(findUpperBound(k));
+}
+
+/****************************************************
+ * BST :: FIND LOWER BOUND
+ * Descend remembering the last node we went left at.
+ * Each level costs one call to compare, where testing
+ * for equality first would cost two
+ *   OUTPUT : the first node not before k, or nullptr
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename K>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: findLowerBound(const K & k) const
+{
+   BNode * pBound = nullptr;
+   for (BNode * pCurrent = root; pCurrent; )
+      if (compare(pCurrent->data, k))
+         pCurrent = pCurrent->getRight();
+      else
+      {
+         pBound = pCurrent;
+         pCurrent = pCurrent->getLeft();
+      }
+   return pBound;
+}
+
+template <typename T, typename Compare>
+template <typename K>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: findUpperBound(const K & k) const
+{
+   BNode * pBound = nullptr;
+   for (BNode * pCurrent = root; pCurrent; )
+      if (compare(k, pCurrent->data))
+      {
+         pBound = pCurrent;
+         pCurrent = pCurrent->getLeft();
+      }
+      else
+         pCurrent = pCurrent->getRight();
+   return pBound;
+}
+
+/****************************************************
+ * BST :: FIND MANY
+ * Look up every key in keys, appending what find()
+ * would return for each to out. A lone find() waits
+ * on one cache miss per level, since it cannot know
+ * the next node until it has this one. Here up to
+ * findManyWidth independent lookups go down together,
+ * one level at a time: each prefetches its next node,
+ * and the misses overlap while the others take their
+ * step
+ *   INPUT  : keys, with size() and [], of T or of a
+ *            type compare takes against T
+ *            out, which needs only push_back(iterator)
+ *   COST   : O(k log n), with the misses overlapped
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename Keys, typename Out>
+void BST <T, Compare> :: find_many(const Keys & keys, Out & out) const
 {
-   BNode* pCurrent = root;
+   BNode * pCurrent[findManyWidth];
+   BNode * pBound[findManyWidth];
+   size_t num = keys.size();
 
-   while (pCurrent)
+   for (size_t first = 0; first < num; first += findManyWidth)
    {
-      if (t == pCurrent->data)
+      size_t width = (num - first < findManyWidth) ? num - first : findManyWidth;
+      for (size_t i = 0; i < width; i++)
       {
-         // Value found, return the iterator to this node
-         return iterator(pCurrent);
-         
+         pCurrent[i] = root;
+         pBound[i] = nullptr;
       }
-      else if (t < pCurrent->data)
+
+      // one level for every lookup still going, until all are at the bottom.
+      // A lone lookup has nothing to overlap with
+      if (width == 1)
+         pBound[0] = findLowerBound(keys[first]);
+      for (bool fMoving = (width > 1 && root != nullptr); fMoving; )
+      {
+         fMoving = false;
+         for (size_t i = 0; i < width; i++)
+         {
+            BNode * pNode = pCurrent[i];
+            if (!pNode)
+               continue;
+            if (compare(pNode->data, keys[first + i]))
+               pNode = pNode->getRight();
+            else
+            {
+               pBound[i] = pNode;
+               pNode = pNode->getLeft();
+            }
+            if (pNode)
+            {
+               __builtin_prefetch(pNode);
+               fMoving = true;
+            }
+            pCurrent[i] = pNode;
+         }
+      }
+
+      for (size_t i = 0; i < width; i++)
+         if (pBound[i] && !compare(keys[first + i], pBound[i]->data))
+            out.push_back(iterator(pBound[i]));
+         else
+            out.push_back(end());
+   }
+}
+
+
+/*****************************************************
+ * BST :: JOIN
+ * Append rhs, every element of which must come after
+ * ours, leaving rhs empty
+ *   COST   : O(log n)
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: join(BST <T, Compare> & rhs)
+{
+   if (this == &rhs)
+      return;
+   int bh;
+   root = join2(root, blackHeight(root), rhs.root, blackHeight(rhs.root), bh);
+   if (root)
+   {
+      root->setParent(nullptr);
+      root->setRed(false);
+   }
+   numElements += rhs.numElements;
+   rhs.root = nullptr;
+   rhs.numElements = 0;
+   rhs.stopCompact();
+}
+
+/*****************************************************
+ * BST :: SPLIT
+ * Move every element not less than t into a new tree.
+ * No node is copied or freed
+ *   OUTPUT : the elements from t on
+ *   COST   : O(log n) to split, plus O(min(k, n - k))
+ *            to count the k elements moved
+ ****************************************************/
+template <typename T, typename Compare>
+BST <T, Compare> BST <T, Compare> :: split(const T & t)
+{
+   BST <T, Compare> rest(compare);  // the same order as ours
+   BNode * pFound = nullptr;
+   stopCompact();
+   int bhLeft;
+   int bhRight;
+   split(root, blackHeight(root), t, true /*lowerBound*/,
+         root, bhLeft, pFound, rest.root, bhRight);
+   for (BNode * p : { root, rest.root })
+      if (p)
+      {
+         p->setParent(nullptr);
+         p->setRed(false);
+      }
+
+   // the nodes do not know their subtree sizes, so count whichever
+   // side is smaller by walking both at once. begin() trusts the
+   // size, so find the first nodes by hand
+   BNode * pFirst = root;
+   BNode * pFirstRest = rest.root;
+   while (pFirst && pFirst->getLeft())
+      pFirst = pFirst->getLeft();
+   while (pFirstRest && pFirstRest->getLeft())
+      pFirstRest = pFirstRest->getLeft();
+
+   size_t num = 0;
+   iterator itLeft(pFirst);
+   iterator itRight(pFirstRest);
+   while (itLeft != end() && itRight != rest.end())
+   {
+      ++itLeft;
+      ++itRight;
+      num++;
+   }
+   if (itLeft == end())
+      rest.numElements = numElements - num;
+   else
+      rest.numElements = num;
+   numElements -= rest.numElements;
+   return rest;
+}
+
+/*****************************************************
+ * BST :: MERGE, INTERSECT, and SUBTRACT
+ * Set union, intersection, and difference with rhs,
+ * which is left empty. The nodes of both trees are
+ * relinked, not copied; an element in both trees
+ * keeps our node. Meant for trees of unique elements.
+ * With parallel set, the two halves of the work run
+ * on separate threads near the top of the recursion
+ *   COST   : O(m log(n/m + 1)) for m <= n
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: merge(BST <T, Compare> & rhs, bool parallel)
+{
+   combine(UNION, rhs, parallel);
+}
+
+template <typename T, typename Compare>
+void BST <T, Compare> :: intersect(BST <T, Compare> & rhs, bool parallel)
+{
+   combine(INTERSECTION, rhs, parallel);
+}
+
+template <typename T, typename Compare>
+void BST <T, Compare> :: subtract(BST <T, Compare> & rhs, bool parallel)
+{
+   combine(DIFFERENCE, rhs, parallel);
+}
+
+template <typename T, typename Compare>
+void BST <T, Compare> :: combine(SetOperation op, BST <T, Compare> & rhs, bool parallel)
+{
+   if (this == &rhs)
+   {
+      if (op == DIFFERENCE)
+         clear();
+      return;
+   }
+
+   // fork until there is about one task per core
+   int forks = 0;
+   if (parallel)
+      for (unsigned num = std::thread::hardware_concurrency(); num > 0; num /= 2)
+         forks++;
+
+   int bh;
+   size_t numFreed = 0;
+   root = combine(op, root, blackHeight(root), rhs.root, blackHeight(rhs.root),
+                  bh, numFreed, forks);
+   if (root)
+   {
+      root->setParent(nullptr);
+      root->setRed(false);
+   }
+   numElements = numElements + rhs.numElements - numFreed;
+   rhs.root = nullptr;
+   rhs.numElements = 0;
+   stopCompact();
+   rhs.stopCompact();
+}
+
+/*****************************************************
+ * BST :: BLACK HEIGHT
+ * The number of black nodes on the way from pNode
+ * down to a leaf, counting pNode
+ *   COST   : O(log n)
+ ****************************************************/
+template <typename T, typename Compare>
+int BST <T, Compare> :: blackHeight(const BNode * pNode)
+{
+   int bh = 0;
+   for (; pNode; pNode = pNode->getLeft())
+      if (!pNode->isRed())
+         bh++;
+   return bh;
+}
+
+/*****************************************************
+ * BST :: LINK
+ * Make pNode, with the given color, the parent of pLeft
+ * and pRight. The result has no parent yet
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: link(BNode * pLeft, BNode * pNode, BNode * pRight, bool isRed)
+{
+   pNode->addLeft(pLeft);
+   pNode->addRight(pRight);
+   pNode->setParent(nullptr);
+   pNode->setRed(isRed);
+   pull(pNode);
+   return pNode;
+}
+
+/*****************************************************
+ * BST :: ROTATE LEFT and ROTATE RIGHT
+ * Lift a child above pNode. The lifted node is
+ * returned without a parent
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: rotateLeft(BNode * pNode)
+{
+   BNode * pChild = pNode->getRight();
+   pNode->addRight(pChild->getLeft());
+   pChild->addLeft(pNode);
+   pChild->setParent(nullptr);
+   pull(pNode);
+   pull(pChild);
+   return pChild;
+}
+
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: rotateRight(BNode * pNode)
+{
+   BNode * pChild = pNode->getLeft();
+   pNode->addLeft(pChild->getRight());
+   pChild->addRight(pNode);
+   pChild->setParent(nullptr);
+   pull(pNode);
+   pull(pChild);
+   return pChild;
+}
+
+/*****************************************************
+ * BST :: JOIN RIGHT
+ * pLeft is the taller tree. Walk down its right spine to
+ * a black node as tall as pRight, hang pMiddle there
+ * with pRight, and fix any red-red pair on the way up.
+ * The result is as tall as pLeft, but its root may be
+ * red with a red right child
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: joinRight(BNode * pLeft, int bhLeft, BNode * pMiddle,
+                                                                   BNode * pRight, int bhRight)
+{
+   if (pLeft == nullptr || (!pLeft->isRed() && bhLeft <= bhRight))
+      return link(pLeft, pMiddle, pRight, true /*isRed*/);
+
+   bool isBlack = !pLeft->isRed();
+   pLeft->addRight(joinRight(pLeft->getRight(), bhLeft - isBlack, pMiddle, pRight, bhRight));
+   pull(pLeft);
+   if (isBlack && isRed(pLeft->getRight()) && isRed(pLeft->getRight()->getRight()))
+   {
+      pLeft->getRight()->getRight()->setRed(false);
+      return rotateLeft(pLeft);
+   }
+   pLeft->setParent(nullptr);
+   return pLeft;
+}
+
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: joinLeft(BNode * pLeft, int bhLeft, BNode * pMiddle,
+                                                                  BNode * pRight, int bhRight)
+{
+   if (pRight == nullptr || (!pRight->isRed() && bhRight <= bhLeft))
+      return link(pLeft, pMiddle, pRight, true /*isRed*/);
+
+   bool isBlack = !pRight->isRed();
+   pRight->addLeft(joinLeft(pLeft, bhLeft, pMiddle, pRight->getLeft(), bhRight - isBlack));
+   pull(pRight);
+   if (isBlack && isRed(pRight->getLeft()) && isRed(pRight->getLeft()->getLeft()))
+   {
+      pRight->getLeft()->getLeft()->setRed(false);
+      return rotateRight(pRight);
+   }
+   pRight->setParent(nullptr);
+   return pRight;
+}
+
+/*****************************************************
+ * BST :: JOIN (subtrees)
+ * Build one red-black tree from pLeft, pMiddle, and
+ * pRight, where every element of pLeft comes before
+ * pMiddle and every element of pRight after it
+ *   INPUT  : the three pieces and the black heights
+ *   OUTPUT : the tree; bh is its black height
+ *   COST   : O(|bhLeft - bhRight| + 1)
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: join(BNode * pLeft, int bhLeft, BNode * pMiddle,
+                                                              BNode * pRight, int bhRight, int & bh)
+{
+   // a black root can only make things easier
+   if (isRed(pLeft))
+   {
+      pLeft->setRed(false);
+      bhLeft++;
+   }
+   if (isRed(pRight))
+   {
+      pRight->setRed(false);
+      bhRight++;
+   }
+
+   BNode * pRoot;
+   if (bhLeft > bhRight)
+   {
+      pRoot = joinRight(pLeft, bhLeft, pMiddle, pRight, bhRight);
+      bh = bhLeft;
+   }
+   else if (bhRight > bhLeft)
+   {
+      pRoot = joinLeft(pLeft, bhLeft, pMiddle, pRight, bhRight);
+      bh = bhRight;
+   }
+   else
+   {
+      bh = bhLeft;
+      return link(pLeft, pMiddle, pRight, true /*isRed*/);
+   }
+
+   if (pRoot->isRed() && (isRed(pRoot->getLeft()) || isRed(pRoot->getRight())))
+   {
+      pRoot->setRed(false);
+      bh++;
+   }
+   return pRoot;
+}
+
+/*****************************************************
+ * BST :: JOIN2
+ * Join two subtrees with no element in between by
+ * taking the largest element of the left as the middle
+ *   COST   : O(log n)
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: join2(BNode * pLeft, int bhLeft, BNode * pRight, int bhRight, int & bh)
+{
+   if (pLeft == nullptr)
+   {
+      bh = bhRight;
+      return pRight;
+   }
+   BNode * pLast;
+   int bhRest;
+   BNode * pRest = splitLast(pLeft, bhLeft, pLast, bhRest);
+   return join(pRest, bhRest, pLast, pRight, bhRight, bh);
+}
+
+/*****************************************************
+ * BST :: SPLIT LAST
+ * Detach the largest node of a subtree
+ *   INPUT  : the subtree and its black height
+ *   OUTPUT : the rest of the subtree; pLast is the
+ *            largest node and bh the rest's black height
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: splitLast(BNode * pNode, int bhNode, BNode *& pLast, int & bh)
+{
+   BNode * pLeft = pNode->getLeft();
+   BNode * pRight = pNode->getRight();
+   int bhChild = bhNode - !pNode->isRed();
+   if (pLeft)
+      pLeft->setParent(nullptr);
+
+   if (pRight == nullptr)
+   {
+      pLast = link(nullptr, pNode, nullptr, true /*isRed*/);
+      bh = bhChild;
+      return pLeft;
+   }
+
+   pRight->setParent(nullptr);
+   int bhRest;
+   BNode * pRest = splitLast(pRight, bhChild, pLast, bhRest);
+   return join(pLeft, bhChild, pNode, pRest, bhRest, bh);
+}
+
+/*****************************************************
+ * BST :: SPLIT BEFORE
+ * Cut the tree pNode is in into the nodes before it
+ * and pNode with everything after it. This works from
+ * pNode up to the root, so it needs no key and keeps
+ * duplicates on the side they were on: each ancestor
+ * joins the side pNode was not on, together with its
+ * other subtree
+ *   OUTPUT : the two trees and their black heights
+ *   COST   : O(log n), the joins telescoping
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: splitBefore(BNode * pNode, BNode *& pLeft, int & bhLeft,
+                                     BNode *& pRight, int & bhRight)
+{
+   int bhNode = blackHeight(pNode);
+   int bhChild = bhNode - !pNode->isRed();
+   BNode * pParent = pNode->getParent();
+   bool wasLeft = pParent && pParent->getLeft() == pNode;
+   pLeft = pNode->getLeft();
+   BNode * pChildRight = pNode->getRight();
+   if (pLeft)
+      pLeft->setParent(nullptr);
+   if (pChildRight)
+      pChildRight->setParent(nullptr);
+   bhLeft = bhChild;
+   pRight = join(nullptr, 0, pNode, pChildRight, bhChild, bhRight);
+
+   // bh is the black height the subtree we came up from had in the tree
+   for (int bh = bhNode; pParent; )
+   {
+      BNode * pAncestor = pParent;
+      pParent = pAncestor->getParent();
+      bool wasLeftNext = pParent && pParent->getLeft() == pAncestor;
+      int bhAncestor = bh + !pAncestor->isRed();
+      if (wasLeft)
       {
-         pCurrent = pCurrent->pLeft; // Go left
+         BNode * pSibling = pAncestor->getRight();
+         if (pSibling)
+            pSibling->setParent(nullptr);
+         pRight = join(pRight, bhRight, pAncestor, pSibling, bh, bhRight);
       }
       else
       {
-         pCurrent = pCurrent->pRight; // Go right
+         BNode * pSibling = pAncestor->getLeft();
+         if (pSibling)
+            pSibling->setParent(nullptr);
+         pLeft = join(pSibling, bh, pAncestor, pLeft, bhLeft, bhLeft);
       }
+      bh = bhAncestor;
+      wasLeft = wasLeftNext;
    }
+   if (pLeft)
+      pLeft->setParent(nullptr);
+   if (pRight)
+      pRight->setParent(nullptr);
+}
 
-   // Value not found, return end iterator
-   return end();
+/*****************************************************
+ * BST :: SPLIT (subtree)
+ * Cut a subtree into the elements before t and the
+ * elements after it. With lowerBound set, elements
+ * equal to t go right; otherwise one node equal to t
+ * is detached and returned as pFound
+ *   COST   : O(log n)
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: split(BNode * pNode, int bhNode, const T & t, bool lowerBound,
+                               BNode *& pLeft, int & bhLeft, BNode *& pFound,
+                               BNode *& pRight, int & bhRight) const
+{
+   if (pNode == nullptr)
+   {
+      pLeft = pRight = nullptr;
+      bhLeft = bhRight = 0;
+      return;
+   }
+
+   BNode * pChildLeft = pNode->getLeft();
+   BNode * pChildRight = pNode->getRight();
+   int bhChild = bhNode - !pNode->isRed();
+   if (pChildLeft)
+      pChildLeft->setParent(nullptr);
+   if (pChildRight)
+      pChildRight->setParent(nullptr);
+
+   bool goLeft = lowerBound ? !compare(pNode->data, t) : compare(t, pNode->data);
+   if (goLeft)
+   {
+      BNode * pMiddle;
+      int bhMiddle;
+      split(pChildLeft, bhChild, t, lowerBound, pLeft, bhLeft, pFound, pMiddle, bhMiddle);
+      pRight = join(pMiddle, bhMiddle, pNode, pChildRight, bhChild, bhRight);
+   }
+   else if (lowerBound || compare(pNode->data, t))
+   {
+      BNode * pMiddle;
+      int bhMiddle;
+      split(pChildRight, bhChild, t, lowerBound, pMiddle, bhMiddle, pFound, pRight, bhRight);
+      pLeft = join(pChildLeft, bhChild, pNode, pMiddle, bhMiddle, bhLeft);
+   }
+   else
+   {
+      pLeft = pChildLeft;
+      pRight = pChildRight;
+      bhLeft = bhRight = bhChild;
+      pFound = link(nullptr, pNode, nullptr, true /*isRed*/);
+   }
+}
+
+/*****************************************************
+ * BST :: COMBINE (subtrees)
+ * Union, intersection, or difference of two subtrees by
+ * divide and conquer: split A around the root of B, work
+ * on the two halves, and join the results. Every node
+ * either ends up in the result or is freed
+ *   OUTPUT : the result; bh is its black height and
+ *            numFreed grows by the nodes freed
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: combine(SetOperation op, BNode * pA, int bhA,
+                                                                 BNode * pB, int bhB,
+                                                                 int & bh, size_t & numFreed, int forks) const
+{
+   if (pA == nullptr || pB == nullptr)
+   {
+      if (op == UNION || (op == DIFFERENCE && pA != nullptr))
+      {
+         bh = pA ? bhA : bhB;
+         return pA ? pA : pB;
+      }
+      numFreed += destroy(pA) + destroy(pB);
+      bh = 0;
+      return nullptr;
+   }
+
+   // take B apart at its root and split A around it
+   BNode * pKey = pB;
+   BNode * pLeftB = pB->getLeft();
+   BNode * pRightB = pB->getRight();
+   int bhChildB = bhB - !pB->isRed();
+   if (pLeftB)
+      pLeftB->setParent(nullptr);
+   if (pRightB)
+      pRightB->setParent(nullptr);
+
+   BNode * pLeftA;
+   BNode * pRightA;
+   BNode * pFound = nullptr;
+   int bhLeftA;
+   int bhRightA;
+   split(pA, bhA, pKey->data, false /*lowerBound*/, pLeftA, bhLeftA, pFound, pRightA, bhRightA);
+
+   // the two halves are independent, so they may run at once. Small
+   // subtrees are not worth a thread
+   BNode * pLeft;
+   BNode * pRight;
+   int bhLeft;
+   int bhRight;
+   if (forks > 0 && bhChildB >= 6)
+   {
+      size_t numFreedLeft = 0;
+      auto left = std::async(std::launch::async, [&]()
+      {
+         return combine(op, pLeftA, bhLeftA, pLeftB, bhChildB, bhLeft, numFreedLeft, forks - 1);
+      });
+      pRight = combine(op, pRightA, bhRightA, pRightB, bhChildB, bhRight, numFreed, forks - 1);
+      pLeft = left.get();
+      numFreed += numFreedLeft;
+   }
+   else
+   {
+      pLeft  = combine(op, pLeftA,  bhLeftA,  pLeftB,  bhChildB, bhLeft,  numFreed, 0);
+      pRight = combine(op, pRightA, bhRightA, pRightB, bhChildB, bhRight, numFreed, 0);
+   }
+
+   // an element in both trees keeps the node from A
+   BNode * pMiddle = nullptr;
+   if (pFound != nullptr && op != DIFFERENCE)
+   {
+      pMiddle = pFound;
+      pFound = nullptr;
+   }
+   else if (pFound == nullptr && op == UNION)
+   {
+      pMiddle = pKey;
+      pKey = nullptr;
+   }
+   numFreed += destroy(pKey ? link(nullptr, pKey, nullptr, true) : nullptr) + destroy(pFound);
+
+   if (pMiddle)
+      return join(pLeft, bhLeft, pMiddle, pRight, bhRight, bh);
+   return join2(pLeft, bhLeft, pRight, bhRight, bh);
+}
+
+/*****************************************************
+ * BST :: DESTROY
+ * Free a detached subtree without rebalancing
+ *   OUTPUT : how many nodes were freed
+ ****************************************************/
+template <typename T, typename Compare>
+size_t BST <T, Compare> :: destroy(BNode * pNode)
+{
+   size_t num = 0;
+   while (pNode != nullptr)
+   {
+      num += destroy(pNode->getLeft());
+      BNode * pRight = pNode->getRight();
+      freeNode(pNode);
+      pNode = pRight;
+      num++;
+   }
+   return num;
+}
+
+
+/*****************************************************
+ * BST :: PULL and PULL UP
+ * Work out a node's maxEnd from its own interval and
+ * its children's, after its children changed. pullUp()
+ * does the same for every node up to the root, after
+ * a change below them all. Neither does anything unless
+ * the tree holds intervals
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: pull(BNode * pNode)
+{
+   if constexpr (Augment<T>::enabled)
+   {
+      pNode->maxEnd = Augment<T>::of(pNode->data);
+      BNode * pLeft = pNode->getLeft();
+      BNode * pRight = pNode->getRight();
+      if (pLeft && pNode->maxEnd < pLeft->maxEnd)
+         pNode->maxEnd = pLeft->maxEnd;
+      if (pRight && pNode->maxEnd < pRight->maxEnd)
+         pNode->maxEnd = pRight->maxEnd;
+   }
+}
+
+template <typename T, typename Compare>
+void BST <T, Compare> :: pullUp(BNode * pNode)
+{
+   if constexpr (Augment<T>::enabled)
+      for (; pNode != nullptr; pNode = pNode->getParent())
+         pull(pNode);
+}
+
+template <typename T, typename Compare>
+void BST <T, Compare> :: copyAugment(BNode * pDest, const BNode * pSrc)
+{
+   if constexpr (Augment<T>::enabled)
+      pDest->maxEnd = pSrc->maxEnd;
+}
+
+/*****************************************************
+ * BST :: FIND OVERLAPPING
+ * Put an iterator to every interval that shares a
+ * point with [lo, hi] into out, in order. A subtree
+ * whose maxEnd is below lo holds nothing that reaches
+ * the range, and once an interval starts after hi so
+ * does everything to its right. Only interval trees
+ * have this
+ *   INPUT  : the range, and anything with push_back()
+ *            that takes an iterator
+ *   COST   : O(log n + k) for k found when the found
+ *            intervals are near one another in the
+ *            order, O((k + 1) log n) at worst
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename K, typename Out>
+void BST <T, Compare> :: find_overlapping(const K & lo, const K & hi, Out & out) const
+{
+   static_assert(Augment<T>::enabled, "find_overlapping() needs a BST of intervals");
+   findOverlapping(root, lo, hi, out);
+}
+
+template <typename T, typename Compare>
+template <typename K, typename Out>
+void BST <T, Compare> :: findOverlapping(const BNode * pNode, const K & lo, const K & hi, Out & out)
+{
+   // walk right iteratively, so only left subtrees use the stack
+   while (pNode != nullptr && !(pNode->maxEnd < lo))
+   {
+      findOverlapping(pNode->getLeft(), lo, hi, out);
+      if (hi < pNode->data.lo)
+         return;
+      if (!(pNode->data.hi < lo))
+         out.push_back(iterator(const_cast<BNode *>(pNode)));
+      pNode = pNode->getRight();
+   }
+}
+
+/*****************************************************
+ * BST :: FREE NODE
+ * Delete a node, or give its room back to the block
+ * it was laid out in
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: freeNode(BNode * pNode)
+{
+   if (pNode->isInBlock())
+   {
+      pNode->~BNode();
+      NodeBlock<BNode>::of(pNode)->release();
+   }
+   else
+      delete pNode;
+}
+
+/*****************************************************
+ * BST :: COMPACT
+ * Move every node, in order, into blocks where they sit
+ * side by side, so a scan reads memory front to back and
+ * the last levels of a find land on the same few lines.
+ * The shape of the tree and the order of the elements do
+ * not change, but every iterator is invalidated. A
+ * compact_step() pass under way is started over
+ *   COST   : O(n)
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: compact()
+{
+   stopCompact();
+   compact_step(numElements);
 }
 
+/*****************************************************
+ * BST :: COMPACT STEP
+ * Move at most maxNodes nodes of a compact() pass,
+ * starting one if none is under way, so the work can
+ * be spread over time slices. The tree is usable in
+ * between, though iterators are not kept. Erasing one
+ * element at a time and inserting leave the pass where
+ * it was (a node inserted behind it stays where it is);
+ * anything that takes nodes away in bulk, such as
+ * erase_if() or split(), starts it over
+ *   OUTPUT : true once the pass is done
+ *   COST   : O(maxNodes) amortized
+ ****************************************************/
+template <typename T, typename Compare>
+bool BST <T, Compare> :: compact_step(size_t maxNodes)
+{
+   if (!compaction.underWay)
+   {
+      compaction.underWay = true;
+      compaction.pNext = root;
+      while (compaction.pNext && compaction.pNext->getLeft())
+         compaction.pNext = compaction.pNext->getLeft();
+   }
+
+   for (; compaction.pNext && maxNodes > 0; maxNodes--)
+   {
+      iterator it(relocate(compaction.pNext));
+      compaction.pNext = (++it).pNode;
+   }
+
+   if (compaction.pNext)
+      return false;
+   stopCompact();
+   return true;
+}
+
+/*****************************************************
+ * BST :: RELOCATE
+ * Move a node's element into the next slot of the pass
+ * and put the new node where the old one was
+ *   OUTPUT : the new node
+ ****************************************************/
+template <typename T, typename Compare>
+typename BST <T, Compare> :: BNode * BST <T, Compare> :: relocate(BNode * pNode)
+{
+   BNode * pNew = ::new (compaction.arena.allocate()) BNode(std::move(pNode->data));
+   pNew->setInBlock();
+   pNew->setRed(pNode->isRed());
+   copyAugment(pNew, pNode);
+   pNew->addLeft(pNode->getLeft());
+   pNew->addRight(pNode->getRight());
+
+   BNode * pParent = pNode->getParent();
+   if (pParent == nullptr)
+      root = pNew;
+   else if (pParent->getLeft() == pNode)
+      pParent->addLeft(pNew);
+   else
+      pParent->addRight(pNew);
+
+   freeNode(pNode);
+   return pNew;
+}
+
+/*****************************************************
+ * BST :: NODE ARENA :: ALLOCATE
+ * Room for the next node: the slot after the last one
+ * in the block being filled, or the start of a new
+ * block. Under BST_INDEX_NODE every node has to be in
+ * the pool, so it is the pool's next fresh slot instead
+ ****************************************************/
+template <typename T, typename Compare>
+void * BST <T, Compare> :: NodeArena :: allocate()
+{
+#ifdef BST_INDEX_NODE
+   return NodePool<BNode>::allocateFresh();
+#else
+   if (pBlock == nullptr || pSlot == pBlock->end())
+   {
+      if (pBlock)
+         pBlock->release();
+      pBlock = NodeBlock<BNode>::create();
+      pSlot = pBlock->begin();
+   }
+   pBlock->hold();
+   return pSlot++;
+#endif // BST_INDEX_NODE
+}
+
+/*****************************************************
+ * BST :: NODE ARENA :: RELEASE
+ * Stop filling the block. It lives on while nodes in
+ * it are in use
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: NodeArena :: release()
+{
+   if (pBlock)
+      pBlock->release();
+   pBlock = nullptr;
+   pSlot = nullptr;
+}
+
+/*****************************************************
+ * BST :: STOP COMPACT
+ * Drop a compact() pass under way, letting go of the
+ * block it was filling
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: stopCompact()
+{
+   compaction.arena.release();
+   compaction = Compaction();
+}
 
 /******************************************************
  ******************************************************
@@ -790,18 +2616,18 @@ typename BST <T> :: iterator BST<T> :: find(const T & t)
  * BINARY NODE :: ADD LEFT
  * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST<T>::BNode::addLeft(BNode *pNode)
+template <typename T, typename Compare>
+void BST<T, Compare>::BNode::addLeft(BNode *pNode)
 {
    // Ensure pNode is not null and points to a valid object
    if (pNode == nullptr)
    {
-      pLeft = nullptr; // Handle null case
+      setLeft(nullptr); // Handle null case
       return;
    }
 
-   pLeft = pNode;    // Assign the left child
-   pNode->pParent = this;  // Set parent to this node
+   setLeft(pNode);  // Assign the left child
+   pNode->setParent(this);  // Set parent to this node
 }
 
 
@@ -809,24 +2635,24 @@ void BST<T>::BNode::addLeft(BNode *pNode)
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addRight (BNode * pNode)
+template <typename T, typename Compare>
+void BST <T, Compare> :: BNode :: addRight (BNode * pNode)
 {
    if (pNode == nullptr)
    {
-      pRight = nullptr; // Check for null node
+      setRight(nullptr); // Check for null node
       return;
    }
-   pRight = pNode;
-   pNode->pParent = this;
+   setRight(pNode);
+   pNode->setParent(this);
 }
 
 /******************************************************
  * BINARY NODE :: ADD LEFT
  * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST<T> :: BNode :: addLeft (const T & t)
+template <typename T, typename Compare>
+void BST<T, Compare> :: BNode :: addLeft (const T & t)
 {
    this->addLeft(new BNode(t));
 }
@@ -835,8 +2661,8 @@ void BST<T> :: BNode :: addLeft (const T & t)
  * BINARY NODE :: ADD LEFT
  * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST<T> ::BNode::addLeft(T && t)
+template <typename T, typename Compare>
+void BST<T, Compare> ::BNode::addLeft(T && t)
 {
    this->addLeft(new BNode(std::move(t)));
 }
@@ -845,8 +2671,8 @@ void BST<T> ::BNode::addLeft(T && t)
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addRight (const T & t)
+template <typename T, typename Compare>
+void BST <T, Compare> :: BNode :: addRight (const T & t)
 {
    this->addRight(new BNode(t));
 }
@@ -855,8 +2681,8 @@ void BST <T> :: BNode :: addRight (const T & t)
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> ::BNode::addRight(T && t)
+template <typename T, typename Compare>
+void BST <T, Compare> ::BNode::addRight(T && t)
 {
    this->addRight(new BNode(std::move(t)));
 }
@@ -867,59 +2693,59 @@ void BST <T> ::BNode::addRight(T && t)
  * Find the depth of the black nodes. This is useful for
  * verifying that a given red-black tree is valid
  ****************************************************/
-template <typename T>
-int BST <T> :: BNode :: findDepth() const
+template <typename T, typename Compare>
+int BST <T, Compare> :: BNode :: findDepth() const
 {
    // if there are no children, the depth is ourselves
-   if (pRight == nullptr && pLeft == nullptr)
-      return (isRed ? 0 : 1);
+   if (getRight() == nullptr && getLeft() == nullptr)
+      return (isRed() ? 0 : 1);
 
    // if there is a right child, go that way
-   if (pRight != nullptr)
-      return (isRed ? 0 : 1) + pRight->findDepth();
+   if (getRight() != nullptr)
+      return (isRed() ? 0 : 1) + getRight()->findDepth();
    else
-      return (isRed ? 0 : 1) + pLeft->findDepth();
+      return (isRed() ? 0 : 1) + getLeft()->findDepth();
 }
 
 /****************************************************
  * BINARY NODE :: VERIFY RED BLACK
  * Do all four red-black rules work here?
  ***************************************************/
-template <typename T>
-bool BST <T> :: BNode :: verifyRedBlack(int depth) const
+template <typename T, typename Compare>
+bool BST <T, Compare> :: BNode :: verifyRedBlack(int depth) const
 {
    bool fReturn = true;
-   depth -= (isRed == false) ? 1 : 0;
+   depth -= (isRed() == false) ? 1 : 0;
 
    // Rule a) Every node is either red or black
-   assert(isRed == true || isRed == false); // this feels silly
+   assert(isRed() == true || isRed() == false); // this feels silly
 
    // Rule b) The root is black
-   if (pParent == nullptr)
-      if (isRed == true)
+   if (getParent() == nullptr)
+      if (isRed() == true)
          fReturn = false;
 
    // Rule c) Red nodes have black children
-   if (isRed == true)
+   if (isRed() == true)
    {
-      if (pLeft != nullptr)
-         if (pLeft->isRed == true)
+      if (getLeft() != nullptr)
+         if (getLeft()->isRed() == true)
             fReturn = false;
 
-      if (pRight != nullptr)
-         if (pRight->isRed == true)
+      if (getRight() != nullptr)
+         if (getRight()->isRed() == true)
             fReturn = false;
    }
 
    // Rule d) Every path from a leaf to the root has the same # of black nodes
-   if (pLeft == nullptr && pRight && nullptr)
+   if (getLeft() == nullptr && getRight() && nullptr)
       if (depth != 0)
          fReturn = false;
-   if (pLeft != nullptr)
-      if (!pLeft->verifyRedBlack(depth))
+   if (getLeft() != nullptr)
+      if (!getLeft()->verifyRedBlack(depth))
          fReturn = false;
-   if (pRight != nullptr)
-      if (!pRight->verifyRedBlack(depth))
+   if (getRight() != nullptr)
+      if (!getRight()->verifyRedBlack(depth))
          fReturn = false;
 
    return fReturn;
@@ -930,8 +2756,8 @@ bool BST <T> :: BNode :: verifyRedBlack(int depth) const
  * VERIFY B TREE
  * Verify that the tree is correctly formed
  ******************************************************/
-template <typename T>
-std::pair <T, T> BST <T> :: BNode :: verifyBTree() const
+template <typename T, typename Compare>
+std::pair <T, T> BST <T, Compare> :: BNode :: verifyBTree() const
 {
    // largest and smallest values
    std::pair <T, T> extremes;
@@ -939,29 +2765,29 @@ std::pair <T, T> BST <T> :: BNode :: verifyBTree() const
    extremes.second = data;
 
    // check parent
-   if (pParent)
-      assert(pParent->pLeft == this || pParent->pRight == this);
+   if (getParent())
+      assert(getParent()->getLeft() == this || getParent()->getRight() == this);
 
    // check left, the smaller sub-tree
-   if (pLeft)
+   if (getLeft())
    {
-      assert(!(data < pLeft->data));
-      assert(pLeft->pParent == this);
-      pLeft->verifyBTree();
-      std::pair <T, T> p = pLeft->verifyBTree();
+      assert(!(data < getLeft()->data));
+      assert(getLeft()->getParent() == this);
+      getLeft()->verifyBTree();
+      std::pair <T, T> p = getLeft()->verifyBTree();
       assert(!(data < p.second));
       extremes.first = p.first;
 
    }
 
    // check right
-   if (pRight)
+   if (getRight())
    {
-      assert(!(pRight->data < data));
-      assert(pRight->pParent == this);
-      pRight->verifyBTree();
+      assert(!(getRight()->data < data));
+      assert(getRight()->getParent() == this);
+      getRight()->verifyBTree();
 
-      std::pair <T, T> p = pRight->verifyBTree();
+      std::pair <T, T> p = getRight()->verifyBTree();
       assert(!(p.first < data));
       extremes.second = p.second;
    }
@@ -974,12 +2800,12 @@ std::pair <T, T> BST <T> :: BNode :: verifyBTree() const
  * COMPUTE SIZE
  * Verify that the BST is as large as we think it is
  ********************************************/
-template <typename T>
-int BST <T> :: BNode :: computeSize() const
+template <typename T, typename Compare>
+int BST <T, Compare> :: BNode :: computeSize() const
 {
    return 1 +
-      (pLeft  == nullptr ? 0 : pLeft->computeSize()) +
-      (pRight == nullptr ? 0 : pRight->computeSize());
+      (getLeft()  == nullptr ? 0 : getLeft()->computeSize()) +
+      (getRight() == nullptr ? 0 : getRight()->computeSize());
 }
 #endif // DEBUG
 
@@ -987,130 +2813,196 @@ int BST <T> :: BNode :: computeSize() const
  * BINARY NODE :: BALANCE
  * Balance the tree from a given location
  ******************************************************/
-template <typename T>
-void BST<T>::BNode::balance(BST<T>* bst)
+template <typename T, typename Compare>
+void BST<T, Compare>::BNode::balance(BST<T, Compare>* bst)
 {
-   BNode* pGranny = pParent ? pParent->pParent : nullptr;
-   BNode* pSibling = pParent ? (pParent->pLeft == this ? pParent->pRight : pParent->pLeft) : nullptr;
-   BNode* pGreatGranny = pGranny ? pGranny->pParent : nullptr;
-   BNode* pAunt = pGranny ? (pGranny->pLeft == pParent ? pGranny->pRight : pGranny->pLeft) : nullptr;
+   BNode* pParent = getParent();
+   BNode* pGranny = pParent ? pParent->getParent() : nullptr;
+   BNode* pSibling = pParent ? (pParent->getLeft() == this ? pParent->getRight() : pParent->getLeft()) : nullptr;
+   BNode* pGreatGranny = pGranny ? pGranny->getParent() : nullptr;
+   BNode* pAunt = pGranny ? (pGranny->getLeft() == pParent ? pGranny->getRight() : pGranny->getLeft()) : nullptr;
+   bool grannyIsLeft = pGranny && pGranny->isLeftChild(); // remember before rotating
 
    // Case 1: If we are the root, color ourselves black and return.
    if (pParent == nullptr)
    {
-      isRed = false;
+      setRed(false);
       return;
    }
 
    // Case 2: If the parent is black, there's nothing left to do.
-   if (!pParent->isRed)
+   if (!pParent->isRed())
    {
       return;
    }
 
+   // A red parent with no granny is a root that was left red: fix it.
+   if (pGranny == nullptr)
+   {
+      pParent->setRed(false);
+      return;
+   }
+
    // Case 3: If the aunt is red, recolor the parent, aunt, and granny.
-   if (pAunt && pParent->isRed && pAunt->isRed && !pGranny->isRed)
+   if (pAunt && pParent->isRed() && pAunt->isRed() && !pGranny->isRed())
    {
-      pParent->isRed = false;
-      pAunt->isRed = false;
-      pGranny->isRed = true;
+      pParent->setRed(false);
+      pAunt->setRed(false);
+      pGranny->setRed(true);
       pGranny->balance(bst); // Recurse up the tree.
       return;
    }
 
    // Case 4: If the aunt is black or non-existent, we need to rotate.
-   if (pParent->isRed && (!pAunt || !pAunt->isRed) && !pGranny->isRed)
+   if (pParent->isRed() && (!pAunt || !pAunt->isRed()) && !pGranny->isRed())
    {
       // Case 4a: We are mom's left and mom is granny's left (LL rotation)
       if (this->isLeftChild() && pParent->isLeftChild())
       {
-         pGranny->isRed = true;
-         pParent->isRed = false;
+         pGranny->setRed(true);
+         pParent->setRed(false);
          pParent->addRight(pGranny); // Promote pParent, make pGranny its right child
          pGranny->addLeft(pSibling); // Attach pSibling to pGranny's left.
 
          // Adjust parent pointers and root.
          if (pGreatGranny)
          {
-            pGranny->isLeftChild() ?  pGreatGranny->addRight(pParent) : pGreatGranny->addLeft(pParent);
+            grannyIsLeft ? pGreatGranny->addLeft(pParent) : pGreatGranny->addRight(pParent);
          }
          else
          {
             bst->root = pParent; // Update root to the new root after rotation.
-            pParent->pParent = nullptr;
+            pParent->setParent(nullptr);
          }
       }
 
       // Case 4b: We are mom's right and mom is granny's right (RR rotation)
       else if (this->isRightChild() && pParent->isRightChild())
       {
-         pGranny->isRed = true;
-         pParent->isRed = false;
+         pGranny->setRed(true);
+         pParent->setRed(false);
          pParent->addLeft(pGranny); // Promote pParent, make pGranny its left child.
          pGranny->addRight(pSibling); // Attach pSibling to pGranny's right.
 
          // Adjust parent pointers and root.
          if (pGreatGranny)
          {
-            pGranny->isLeftChild() ?  pGreatGranny->addRight(pParent) : pGreatGranny->addLeft(pParent);
+            grannyIsLeft ? pGreatGranny->addLeft(pParent) : pGreatGranny->addRight(pParent);
          }
          else
          {
             bst->root = pParent; // Update root to the new root after rotation.
-            pParent->pParent = nullptr;
+            pParent->setParent(nullptr);
          }
       }
 
       // Case 4c: We are mom's right and mom is granny's left (RL rotation)
       else if (isRightChild() && pParent->isLeftChild())
       {
-         isRed = false;
-         pGranny->isRed = true;
+         setRed(false);
+         pGranny->setRed(true);
 
-         pParent->addRight(pLeft); // Move the left child of current node to the right of parent.
-         pGranny->addLeft(pRight); // Move the right child of current node to the left of granny.
+         pParent->addRight(getLeft()); // Move the left child of current node to the right of parent.
+         pGranny->addLeft(getRight()); // Move the right child of current node to the left of granny.
          addLeft(pParent); // Make the current node the left child of parent.
          addRight(pGranny); // Make the current node the right child of granny.
 
          // Adjust parent pointers and root.
          if (pGreatGranny)
          {
-            pGranny->isLeftChild() ? pGreatGranny->addLeft(this) : pGreatGranny->addRight(this);
+            grannyIsLeft ? pGreatGranny->addLeft(this) : pGreatGranny->addRight(this);
          }
          else
          {
             bst->root = this; // Update root to the current node after rotation.
-            pParent = nullptr;
+            setParent(nullptr);
          }
       }
 
       // Case 4d: We are mom's left and mom is granny's right (LR rotation)
       else if (isLeftChild() && pParent->isRightChild())
       {
-         isRed = false;
-         pGranny->isRed = true;
+         setRed(false);
+         pGranny->setRed(true);
 
-         pGranny->addRight(pLeft); // Move the left child of current node to the right of granny.
-         pParent->addLeft(pRight); // Move the right child of current node to the left of parent.
+         pGranny->addRight(getLeft()); // Move the left child of current node to the right of granny.
+         pParent->addLeft(getRight()); // Move the right child of current node to the left of parent.
          addLeft(pGranny); // Make the current node the left child of granny.
          addRight(pParent); // Make the current node the right child of parent.
 
          // Adjust parent pointers and root.
          if (pGreatGranny)
          {
-            pGranny->isLeftChild() ? pGreatGranny->addLeft(this) : pGreatGranny->addRight(this);
+            grannyIsLeft ? pGreatGranny->addLeft(this) : pGreatGranny->addRight(this);
          }
          else
          {
             bst->root = this; // Update root to the current node after rotation.
-            pParent = nullptr;
+            setParent(nullptr);
          }
       }
+
+      // these three are now a parent and its two children: pull the
+      // children before the parent
+      BNode * pTop = getParent() == pParent ? pParent : this;
+      pull(pTop == this ? pParent : this);
+      pull(pGranny);
+      pull(pTop);
    }
 }
 
 
 
+/*****************************************************
+ * BST :: FOR EACH
+ * Call f on every element in order
+ *   COST   : O(n), with no parent pointers followed
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename F>
+void BST <T, Compare> :: for_each(F f) const
+{
+   for (scanner it(*this); !it.done(); ++it)
+      f(*it);
+}
+
+/*****************************************************
+ * BST SCANNER :: COLLECT
+ * Copy the next n elements, or as many as are left
+ *   INPUT  : where to put them and how many
+ *   OUTPUT : how many were copied
+ ****************************************************/
+template <typename T, typename Compare>
+template <typename Out>
+size_t BST <T, Compare> :: scanner :: collect(Out & out, size_t n)
+{
+   size_t num = 0;
+   for (; num < n && depth > 0; num++)
+   {
+      BNode * pNode = stack[--depth];
+      out.push_back(pNode->data);
+      pushLeft(pNode->getRight());
+   }
+   return num;
+}
+
+/*****************************************************
+ * BST SCANNER :: GROW
+ * A tree that has lost its balance through erase can
+ * be deeper than the stack built into the scanner
+ ****************************************************/
+template <typename T, typename Compare>
+void BST <T, Compare> :: scanner :: grow()
+{
+   BNode ** stackNew = new BNode * [capacity * 2];
+   for (int i = 0; i < depth; i++)
+      stackNew[i] = stack[i];
+   if (stack != inlineStack)
+      delete [] stack;
+   stack = stackNew;
+   capacity *= 2;
+}
+
 /*************************************************
  *************************************************
  *************************************************
@@ -1123,41 +3015,29 @@ void BST<T>::BNode::balance(BST<T>* bst)
  * BST ITERATOR :: INCREMENT PREFIX
  * advance by one
  *************************************************/
-template <typename T>
-typename BST <T> :: iterator & BST <T> :: iterator :: operator ++ ()
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator & BST <T, Compare> :: iterator :: operator ++ ()
 {
    if (pNode == nullptr) return *this;  // End of traversal
     
    // Case 1: If there is a right child, go to the leftmost node in the right subtree
-   if (pNode->pRight != nullptr)
+   if (pNode->getRight() != nullptr)
    {
-      pNode = pNode->pRight;
-      while (pNode->pLeft != nullptr)
+      pNode = pNode->getRight();
+      while (pNode->getLeft() != nullptr)
       {
-         pNode = pNode->pLeft;
+         pNode = pNode->getLeft();
       }
       return *this;
    }
 
-   // Case 2: If there is no right child and we are the left child of the parent, move up to the parent
-   if (pNode->pRight == nullptr && pNode->pParent != nullptr && pNode->pParent->pLeft == pNode)
+   // Case 2: If there is no right child, move up until we come from a left child.
+   // If we never do, we were the last node and the parent of the root is the end
+   while (pNode->getParent() != nullptr && pNode->getParent()->getRight() == pNode)
    {
-      pNode = pNode->pParent;
-      return *this;
+      pNode = pNode->getParent();
    }
-
-   // Case 3: If there is no right child and we are the right child of the parent, move up to the parent
-   // and continue moving up until we are the left child of a parent
-   if (pNode->pRight == nullptr && pNode->pParent != nullptr && pNode->pParent->pRight == pNode)
-   {
-      while (pNode->pParent != nullptr && pNode->pParent->pRight == pNode)
-      {
-         pNode = pNode->pParent;
-      }
-      pNode = pNode->pParent;  // Move to the parent
-      return *this;
-   }
-
+   pNode = pNode->getParent();  // Move to the parent
    return *this;
 }
 
@@ -1166,37 +3046,27 @@ typename BST <T> :: iterator & BST <T> :: iterator :: operator ++ ()
  * BST ITERATOR :: DECREMENT PREFIX
  * advance by one
  *************************************************/
-template <typename T>
-typename BST <T> :: iterator & BST <T> :: iterator :: operator -- ()
+template <typename T, typename Compare>
+typename BST <T, Compare> :: iterator & BST <T, Compare> :: iterator :: operator -- ()
 {
    if (pNode == nullptr) return *this;
    
-   if (pNode->pLeft)
+   if (pNode->getLeft())
    {
-      pNode = pNode->pLeft;
-      while (pNode->pRight)
+      pNode = pNode->getLeft();
+      while (pNode->getRight())
       {
-         pNode = pNode->pRight;
+         pNode = pNode->getRight();
       }
       return *this;
    }
-   if (pNode->pLeft == nullptr and pNode->pParent->pRight == pNode)
+   // no left child, so move up until we come from a right child
+   while (pNode->getParent() and pNode->getParent()->getLeft() == pNode)
    {
-      pNode = pNode->pParent;
-      return *this;
-   }
-   if (pNode->pLeft == nullptr and pNode->pParent->pLeft == pNode)
-   {
-      while (pNode->pParent and pNode->pParent->pLeft == pNode)
-      {
-         pNode = pNode->pParent;
-
-      }
-      pNode = pNode->pParent;
-      return *this;
+      pNode = pNode->getParent();
    }
+   pNode = pNode->getParent();
    return *this;
-
 }
 
 
@@ -0,0 +1,1117 @@
+/***********************************************************************
+ * Header:
+ *    DISK B-TREE
+ * Summary:
+ *    An ordered index that lives in a file, for indexes bigger than
+ *    memory. It is a B+-tree of fixed-size pages: the elements are all
+ *    in the leaves, which are linked in order both ways so a scan reads
+ *    one leaf after another, and the inner pages hold only separators
+ *    and the page numbers of their children. With 4K pages and 8-byte
+ *    keys an inner page has about 250 children, so a hundred million
+ *    keys are four pages deep and the top two levels fit in a few
+ *    hundred kilobytes of cache.
+ *
+ *    Pages are read and written through a page cache of a fixed number
+ *    of pages. The least recently used page that is not in use is the
+ *    one to go, and only if it is dirty is it written back. Everything
+ *    is read and written with pread() and pwrite(), a page at a time,
+ *    so the cache's counts of reads and writes are the I/O the tree
+ *    asks of the file (the operating system may still satisfy a read
+ *    from its own cache).
+ *
+ *    Page 0 holds the tree's metadata: where the root is, how deep the
+ *    tree is, and how many pages and elements there are. flush() writes
+ *    every dirty page and then page 0, so a file closed cleanly opens
+ *    again with everything in it.
+ *
+ *    This will contain the class definition of:
+ *        disk_btree            : A B+-tree in a file
+ *        disk_btree::iterator  : An iterator through disk_btree
+ *        btree::PageCache      : The LRU cache of pages
+ *        btree::PageRef        : A page pinned in the cache
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>     // for std::sort
+#include <cerrno>        // for errno
+#include <cstdint>       // for uint32_t and uint64_t
+#include <cstdlib>       // for std::aligned_alloc and std::free
+#include <cstring>       // for memcpy, memmove, memset, and memcmp
+#include <functional>    // for std::less
+#include <new>           // for std::bad_alloc
+#include <stdexcept>     // for std::runtime_error and std::length_error
+#include <string>
+#include <system_error>  // for std::system_error
+#include <type_traits>   // for std::is_trivially_copyable
+#include <utility>       // for std::pair
+#include <vector>        // for the dirty pages to write back
+#include <fcntl.h>       // for open
+#include <unistd.h>      // for pread, pwrite, ftruncate, fdatasync, and close
+#include "hash.h"        // for unordered_map
+#include "vector.h"
+
+class TestDiskBTree; // forward declaration for unit tests
+
+namespace custom
+{
+
+namespace btree
+{
+   /*************************************************
+    * PAGE CACHE
+    * numFrames pages of memory in front of a file.
+    * Each frame holds one page, and frames are kept
+    * in a list from most to least recently used
+    *************************************************/
+   template <size_t PageSize>
+   class PageCache
+   {
+   public:
+      struct Stats
+      {
+         size_t reads;    // pages read from the file
+         size_t writes;   // pages written to the file
+         size_t hits;     // pages asked for that were in the cache
+         size_t misses;   // pages asked for that had to be read
+      };
+
+      PageCache(const std::string & path, size_t numFrames);
+      PageCache(const PageCache &) = delete;
+      PageCache & operator = (const PageCache &) = delete;
+     ~PageCache();
+
+      char * pin(uint64_t pageNo, bool fresh, size_t & frame);
+      void   unpin(size_t frame)     { frames[frame].pins--;       }
+      void   markDirty(size_t frame) { frames[frame].dirty = true; }
+      void   writeBack();
+      void   reset(uint64_t numPages);
+      void   sync();
+
+      void readPage (uint64_t pageNo,       char * p);
+      void writePage(uint64_t pageNo, const char * p);
+      uint64_t fileSize() const;
+
+      const Stats & stats() const { return counts; }
+      void resetStats()           { counts = Stats(); }
+
+   private:
+      static const size_t NONE = (size_t)-1;
+
+      struct Frame
+      {
+         Frame() : pageNo(0), dirty(false), pins(0), prev(NONE), next(NONE) {}
+         uint64_t pageNo;
+         bool dirty;
+         unsigned pins;
+         size_t prev;     // the next more recently used
+         size_t next;     // the next less recently used
+      };
+
+      size_t victim();
+      void   unlink(size_t frame);
+      void   pushFront(size_t frame);
+      char * data(size_t frame) { return pool + frame * PageSize; }
+
+      int fd;
+      char * pool;                               // numFrames pages, page aligned
+      custom::vector<Frame> frames;
+      custom::unordered_map<uint64_t, size_t> index;  // page number to frame
+      size_t numUsed;                            // frames that have ever held a page
+      size_t head;                               // the most recently used
+      size_t tail;                               // the least recently used
+      Stats counts;
+   };
+
+   /*************************************************
+    * PAGE REF
+    * A page pinned in the cache for as long as the
+    * PageRef lives, so it cannot be evicted while
+    * its memory is in use
+    *************************************************/
+   template <size_t PageSize>
+   class PageRef
+   {
+   public:
+      PageRef(PageCache<PageSize> & cache, uint64_t pageNo, bool fresh = false)
+         : pCache(&cache), pageNo(pageNo)
+      {
+         p = cache.pin(pageNo, fresh, frame);
+      }
+      PageRef(const PageRef &) = delete;
+      PageRef & operator = (const PageRef &) = delete;
+     ~PageRef() { pCache->unpin(frame); }
+
+      char * data() const  { return p;                   }
+      uint64_t number() const { return pageNo;           }
+      void markDirty()     { pCache->markDirty(frame);   }
+
+   private:
+      PageCache<PageSize> * pCache;
+      uint64_t pageNo;
+      size_t frame;
+      char * p;
+   };
+
+   /*************************************************
+    * PAGE HEADER
+    * The start of every leaf and inner page. count is
+    * the elements in a leaf or the separators in an
+    * inner page, which has one child more
+    *************************************************/
+   struct PageHeader
+   {
+      uint32_t isLeaf;
+      uint32_t count;
+      uint64_t next;     // leaves only: the next leaf, or 0 for none
+      uint64_t prev;     // leaves only: the previous leaf, or 0 for none
+   };
+
+   /*************************************************
+    * META
+    * Page 0
+    *************************************************/
+   struct Meta
+   {
+      char     magic[8];
+      uint32_t version;
+      uint32_t sizeOfT;
+      uint32_t pageSize;
+      uint32_t height;       // 0 for an empty tree, 1 when the root is a leaf
+      uint64_t root;
+      uint64_t firstLeaf;
+      uint64_t numPages;     // including page 0
+      uint64_t numElements;
+   };
+} // namespace btree
+
+/*****************************************************************
+ * DISK B-TREE
+ * Elements of a fixed size, so T must be trivially copyable; they
+ * are copied to and from pages as raw bytes, so a file can only be
+ * read on a machine with the same byte order.
+ *
+ * As with BST, duplicates are kept unless insert() is asked not to.
+ * erase() never merges pages: a leaf can empty out and stay in the
+ * chain, and scans step over it. An index that has shrunk a lot is
+ * best rebuilt with assign_sorted().
+ *
+ * An iterator carries a copy of its element and where it was found,
+ * so it stays safe to use while pages come and go from the cache,
+ * but like a BST iterator it is no longer good after the tree is
+ * changed anywhere but through it.
+ *****************************************************************/
+template <typename T, typename Compare = std::less<T>, size_t PageSize = 4096>
+class disk_btree
+{
+   friend class ::TestDiskBTree; // give unit tests access to the privates
+
+   static_assert(std::is_trivially_copyable<T>::value, "disk_btree needs fixed-size elements");
+   static_assert(alignof(T) <= alignof(uint64_t), "disk_btree elements cannot be over-aligned");
+
+   typedef btree::PageCache<PageSize> Cache;
+   typedef btree::PageRef<PageSize>   Page;
+   typedef btree::PageHeader          Header;
+
+public:
+   typedef typename Cache::Stats IOStats;
+
+   //
+   // Construct
+   //
+   explicit disk_btree(const std::string & path, size_t cachePages = 1024,
+                       const Compare & compare = Compare());
+   disk_btree(const disk_btree &) = delete;
+   disk_btree & operator = (const disk_btree &) = delete;
+  ~disk_btree();
+
+   //
+   // Assign
+   //
+   template <typename Source>
+   void assign_sorted(size_t num, Source next);
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin();
+   iterator end() { return iterator(this, 0, 0); }
+
+   //
+   // Access
+   //
+   iterator find(const T & t);
+   iterator lower_bound(const T & t);
+   iterator upper_bound(const T & t);
+
+   //
+   // Insert
+   //
+   std::pair<iterator, bool> insert(const T & t, bool keepUnique = false);
+
+   //
+   // Remove
+   //
+   iterator erase(iterator & it);
+   void clear();
+
+   //
+   // Status and Upkeep
+   //
+   bool   empty()  const { return size() == 0;       }
+   size_t size()   const { return meta.numElements;  }
+   size_t height() const { return meta.height;       }
+   void   flush();
+   const IOStats & stats() const { return cache.stats(); }
+   void   resetStats()           { cache.resetStats();   }
+
+private:
+   // how many elements a leaf holds and how many separators an inner page does
+   static const size_t leafCap  = (PageSize - sizeof(Header)) / sizeof(T);
+   static const size_t innerCap = (PageSize - sizeof(Header) - sizeof(uint64_t)) / (sizeof(T) + sizeof(uint64_t));
+   static_assert(leafCap >= 3 && innerCap >= 3, "disk_btree pages are too small for the elements");
+   static const size_t maxHeight = 32;
+
+   static Header   & header  (char * p) { return *reinterpret_cast<Header *>(p); }
+   static T        * elements(char * p) { return reinterpret_cast<T *>(p + sizeof(Header)); }
+   static uint64_t * children(char * p) { return reinterpret_cast<uint64_t *>(p + sizeof(Header)); }
+   static T * separators(char * p)
+   {
+      return reinterpret_cast<T *>(p + sizeof(Header) + (innerCap + 1) * sizeof(uint64_t));
+   }
+
+   size_t lowerIndex(const T * a, size_t num, const T & t) const;
+   size_t upperIndex(const T * a, size_t num, const T & t) const;
+   uint64_t allocate();
+   iterator iteratorAt(uint64_t pageNo, size_t slot);
+   void insertSeparator(const uint64_t * path, const size_t * childIndex, size_t level,
+                        T separator, uint64_t right);
+   void initMeta();
+
+   Cache cache;
+   Compare compare;
+   btree::Meta meta;
+};
+
+/**************************************************
+ * DISK B-TREE ITERATOR
+ * Forward and back through the leaf chain
+ *************************************************/
+template <typename T, typename Compare, size_t PageSize>
+class disk_btree <T, Compare, PageSize> :: iterator
+{
+   friend class ::TestDiskBTree; // give unit tests access to the privates
+   friend class disk_btree <T, Compare, PageSize>;
+public:
+   iterator() : pTree(nullptr), pageNo(0), slot(0), t() {}
+
+   bool operator == (const iterator & rhs) const { return pageNo == rhs.pageNo && slot == rhs.slot; }
+   bool operator != (const iterator & rhs) const { return !(*this == rhs); }
+
+   const T & operator *  () const { return  t; }
+   const T * operator -> () const { return &t; }
+
+   iterator & operator ++ ()
+   {
+      *this = pTree->iteratorAt(pageNo, slot + 1);
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator itReturn = *this;
+      ++(*this);
+      return itReturn;
+   }
+   iterator & operator -- ();
+   iterator operator -- (int)
+   {
+      iterator itReturn = *this;
+      --(*this);
+      return itReturn;
+   }
+
+private:
+   iterator(disk_btree * pTree, uint64_t pageNo, size_t slot, const T & t = T())
+      : pTree(pTree), pageNo(pageNo), slot(slot), t(t) {}
+
+   disk_btree * pTree;
+   uint64_t pageNo;    // the leaf, or 0 for end()
+   size_t slot;        // where in the leaf
+   T t;                // a copy of the element there
+};
+
+/*************************************************
+ *************************************************
+ *************************************************
+ ****************** PAGE CACHE *******************
+ *************************************************
+ *************************************************
+ *************************************************/
+
+/*****************************************************
+ * PAGE CACHE :: CONSTRUCTOR
+ * Open the file, making it if there is none
+ *   INPUT  : the file, and how many pages to cache
+ ****************************************************/
+template <size_t PageSize>
+btree::PageCache <PageSize> :: PageCache(const std::string & path, size_t numFrames)
+   : fd(-1), pool(nullptr), frames(numFrames), numUsed(0), head(NONE), tail(NONE), counts()
+{
+   fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+   if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "custom::disk_btree: " + path);
+
+   pool = static_cast<char *>(std::aligned_alloc(PageSize, numFrames * PageSize));
+   if (pool == nullptr)
+   {
+      ::close(fd);
+      throw std::bad_alloc();
+   }
+}
+
+/*****************************************************
+ * PAGE CACHE :: DESTRUCTOR
+ * Dirty pages are lost unless writeBack() came first
+ ****************************************************/
+template <size_t PageSize>
+btree::PageCache <PageSize> :: ~PageCache()
+{
+   std::free(pool);
+   ::close(fd);
+}
+
+/*****************************************************
+ * PAGE CACHE :: PIN
+ * Find a page in the cache, reading it if it is not
+ * there, and keep it there until unpin(). A fresh
+ * page is one just added to the end of the file: it
+ * is not read, but zeroed and marked dirty
+ *   INPUT  : the page number and whether it is fresh
+ *   OUTPUT : the page's memory and its frame
+ ****************************************************/
+template <size_t PageSize>
+char * btree::PageCache <PageSize> :: pin(uint64_t pageNo, bool fresh, size_t & frame)
+{
+   auto it = index.find(pageNo);
+   if (it != index.end())
+   {
+      counts.hits++;
+      frame = (*it).second;
+      unlink(frame);
+   }
+   else
+   {
+      frame = victim();
+      frames[frame].pageNo = pageNo;
+      frames[frame].dirty = fresh;
+      if (fresh)
+         memset(data(frame), 0, PageSize);
+      else
+      {
+         counts.misses++;
+         readPage(pageNo, data(frame));
+      }
+      index.insert(std::make_pair(pageNo, frame));
+   }
+
+   pushFront(frame);
+   frames[frame].pins++;
+   return data(frame);
+}
+
+/*****************************************************
+ * PAGE CACHE :: VICTIM
+ * A frame to put a page in: one never used, else the
+ * least recently used that is not pinned, written
+ * back first if it is dirty
+ ****************************************************/
+template <size_t PageSize>
+size_t btree::PageCache <PageSize> :: victim()
+{
+   if (numUsed < frames.size())
+      return numUsed++;
+
+   size_t frame = tail;
+   while (frame != NONE && frames[frame].pins > 0)
+      frame = frames[frame].prev;
+   if (frame == NONE)
+      throw std::length_error("custom::disk_btree: every cached page is in use");
+
+   if (frames[frame].dirty)
+      writePage(frames[frame].pageNo, data(frame));
+   index.erase(frames[frame].pageNo);
+   unlink(frame);
+   return frame;
+}
+
+/*****************************************************
+ * PAGE CACHE :: UNLINK and PUSH FRONT
+ * Take a frame out of the recently-used list, and
+ * put one in as the most recent
+ ****************************************************/
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: unlink(size_t frame)
+{
+   Frame & f = frames[frame];
+   (f.prev == NONE ? head : frames[f.prev].next) = f.next;
+   (f.next == NONE ? tail : frames[f.next].prev) = f.prev;
+   f.prev = f.next = NONE;
+}
+
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: pushFront(size_t frame)
+{
+   frames[frame].prev = NONE;
+   frames[frame].next = head;
+   (head == NONE ? tail : frames[head].prev) = frame;
+   head = frame;
+}
+
+/*****************************************************
+ * PAGE CACHE :: WRITE BACK
+ * Write every dirty page, in page order so that a
+ * tree just loaded goes out in one sweep
+ ****************************************************/
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: writeBack()
+{
+   std::vector<std::pair<uint64_t, size_t> > dirty;
+   for (size_t frame = 0; frame < numUsed; frame++)
+      if (frames[frame].dirty)
+         dirty.push_back(std::make_pair(frames[frame].pageNo, frame));
+   std::sort(dirty.begin(), dirty.end());
+
+   for (const std::pair<uint64_t, size_t> & d : dirty)
+   {
+      writePage(d.first, data(d.second));
+      frames[d.second].dirty = false;
+   }
+}
+
+/*****************************************************
+ * PAGE CACHE :: RESET
+ * Forget every page without writing any, and cut
+ * the file down to numPages pages
+ ****************************************************/
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: reset(uint64_t numPages)
+{
+   index.clear();
+   for (size_t frame = 0; frame < frames.size(); frame++)
+      frames[frame] = Frame();
+   numUsed = 0;
+   head = tail = NONE;
+   if (::ftruncate(fd, (off_t)(numPages * PageSize)) != 0)
+      throw std::system_error(errno, std::generic_category(), "custom::disk_btree: truncate");
+}
+
+// make what has been written so far survive a crash
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: sync()
+{
+   if (::fdatasync(fd) != 0)
+      throw std::system_error(errno, std::generic_category(), "custom::disk_btree: sync");
+}
+
+/*****************************************************
+ * PAGE CACHE :: READ PAGE and WRITE PAGE
+ * One page to or from the file, counted
+ ****************************************************/
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: readPage(uint64_t pageNo, char * p)
+{
+   counts.reads++;
+   ssize_t num = ::pread(fd, p, PageSize, (off_t)(pageNo * PageSize));
+   if (num < 0)
+      throw std::system_error(errno, std::generic_category(), "custom::disk_btree: read");
+   if ((size_t)num != PageSize)
+      throw std::runtime_error("custom::disk_btree: the file ends inside a page");
+}
+
+template <size_t PageSize>
+void btree::PageCache <PageSize> :: writePage(uint64_t pageNo, const char * p)
+{
+   counts.writes++;
+   ssize_t num = ::pwrite(fd, p, PageSize, (off_t)(pageNo * PageSize));
+   if (num < 0)
+      throw std::system_error(errno, std::generic_category(), "custom::disk_btree: write");
+   if ((size_t)num != PageSize)
+      throw std::runtime_error("custom::disk_btree: short write");
+}
+
+template <size_t PageSize>
+uint64_t btree::PageCache <PageSize> :: fileSize() const
+{
+   off_t size = ::lseek(fd, 0, SEEK_END);
+   if (size < 0)
+      throw std::system_error(errno, std::generic_category(), "custom::disk_btree: seek");
+   return (uint64_t)size;
+}
+
+/*************************************************
+ *************************************************
+ *************************************************
+ ****************** DISK B-TREE ******************
+ *************************************************
+ *************************************************
+ *************************************************/
+
+/*****************************************************
+ * DISK B-TREE :: CONSTRUCTOR
+ * Open the tree in a file, or start a new one if the
+ * file is empty or not there. A file holding anything
+ * else, or a tree of another type, is an error
+ *   INPUT  : the file, and how many pages to cache
+ *            (at least 16)
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+disk_btree <T, Compare, PageSize> :: disk_btree(const std::string & path, size_t cachePages,
+                                                const Compare & compare)
+   : cache(path, cachePages < 16 ? 16 : cachePages), compare(compare)
+{
+   if (cache.fileSize() == 0)
+   {
+      initMeta();
+      return;
+   }
+
+   alignas(uint64_t) char page[PageSize];
+   cache.readPage(0, page);
+   btree::Meta stored;
+   memcpy(&stored, page, sizeof(stored));
+
+   initMeta();
+   if (memcmp(stored.magic, meta.magic, sizeof(meta.magic)) != 0)
+      throw std::runtime_error("custom::disk_btree: " + path + " is not a disk_btree");
+   if (stored.version != meta.version || stored.sizeOfT != meta.sizeOfT || stored.pageSize != meta.pageSize)
+      throw std::runtime_error("custom::disk_btree: " + path + " holds a different kind of disk_btree");
+   meta = stored;
+}
+
+/*****************************************************
+ * DISK B-TREE :: DESTRUCTOR
+ * Everything goes to the file
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+disk_btree <T, Compare, PageSize> :: ~disk_btree()
+{
+   try
+   {
+      flush();
+   }
+   catch (...)
+   {
+      // a destructor cannot report it; call flush() first to find out
+   }
+}
+
+// the metadata of an empty tree
+template <typename T, typename Compare, size_t PageSize>
+void disk_btree <T, Compare, PageSize> :: initMeta()
+{
+   meta = btree::Meta();
+   memcpy(meta.magic, "C232BPT", 8);
+   meta.version = 1;
+   meta.sizeOfT = (uint32_t)sizeof(T);
+   meta.pageSize = (uint32_t)PageSize;
+   meta.numPages = 1;
+}
+
+/*****************************************************
+ * DISK B-TREE :: FLUSH
+ * Write every dirty page and then the metadata, and
+ * wait for the file to have them
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+void disk_btree <T, Compare, PageSize> :: flush()
+{
+   cache.writeBack();
+   cache.sync();
+
+   alignas(uint64_t) char page[PageSize] = {};
+   memcpy(page, &meta, sizeof(meta));
+   cache.writePage(0, page);
+   cache.sync();
+}
+
+/*****************************************************
+ * DISK B-TREE :: CLEAR
+ * Back to an empty tree in a file of one page
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+void disk_btree <T, Compare, PageSize> :: clear()
+{
+   initMeta();
+   cache.reset(1);
+}
+
+/*****************************************************
+ * DISK B-TREE :: ALLOCATE
+ * A new page at the end of the file
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+uint64_t disk_btree <T, Compare, PageSize> :: allocate()
+{
+   return meta.numPages++;
+}
+
+/*****************************************************
+ * DISK B-TREE :: LOWER INDEX and UPPER INDEX
+ * Binary search a page: the first element not less
+ * than t, or the first greater than it
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+size_t disk_btree <T, Compare, PageSize> :: lowerIndex(const T * a, size_t num, const T & t) const
+{
+   size_t lo = 0;
+   while (num > 0)
+   {
+      size_t half = num / 2;
+      if (compare(a[lo + half], t))
+      {
+         lo += half + 1;
+         num -= half + 1;
+      }
+      else
+         num = half;
+   }
+   return lo;
+}
+
+template <typename T, typename Compare, size_t PageSize>
+size_t disk_btree <T, Compare, PageSize> :: upperIndex(const T * a, size_t num, const T & t) const
+{
+   size_t lo = 0;
+   while (num > 0)
+   {
+      size_t half = num / 2;
+      if (!compare(t, a[lo + half]))
+      {
+         lo += half + 1;
+         num -= half + 1;
+      }
+      else
+         num = half;
+   }
+   return lo;
+}
+
+/*****************************************************
+ * DISK B-TREE :: ITERATOR AT
+ * An iterator to a slot in a leaf, or if the leaf
+ * has nothing there, to the first element after it
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator
+disk_btree <T, Compare, PageSize> :: iteratorAt(uint64_t pageNo, size_t slot)
+{
+   while (pageNo != 0)
+   {
+      Page leaf(cache, pageNo);
+      if (slot < header(leaf.data()).count)
+         return iterator(this, pageNo, slot, elements(leaf.data())[slot]);
+      pageNo = header(leaf.data()).next;
+      slot = 0;
+   }
+   return end();
+}
+
+/*****************************************************
+ * DISK B-TREE :: BEGIN
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator
+disk_btree <T, Compare, PageSize> :: begin()
+{
+   return meta.root == 0 ? end() : iteratorAt(meta.firstLeaf, 0);
+}
+
+/*****************************************************
+ * DISK B-TREE :: LOWER BOUND and UPPER BOUND
+ * Go down by the separators to the leaf that would
+ * hold t. A separator is the first element of the
+ * child to its right, and with duplicates the child
+ * to its left can end with the same value, so the
+ * lower bound goes left of an equal separator
+ *   COST   : height() pages, each binary searched
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator
+disk_btree <T, Compare, PageSize> :: lower_bound(const T & t)
+{
+   if (meta.root == 0)
+      return end();
+
+   uint64_t pageNo = meta.root;
+   for (size_t level = meta.height; level > 1; level--)
+   {
+      Page inner(cache, pageNo);
+      size_t i = lowerIndex(separators(inner.data()), header(inner.data()).count, t);
+      pageNo = children(inner.data())[i];
+   }
+
+   size_t slot;
+   {
+      Page leaf(cache, pageNo);
+      slot = lowerIndex(elements(leaf.data()), header(leaf.data()).count, t);
+   }
+   return iteratorAt(pageNo, slot);
+}
+
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator
+disk_btree <T, Compare, PageSize> :: upper_bound(const T & t)
+{
+   if (meta.root == 0)
+      return end();
+
+   uint64_t pageNo = meta.root;
+   for (size_t level = meta.height; level > 1; level--)
+   {
+      Page inner(cache, pageNo);
+      size_t i = upperIndex(separators(inner.data()), header(inner.data()).count, t);
+      pageNo = children(inner.data())[i];
+   }
+
+   size_t slot;
+   {
+      Page leaf(cache, pageNo);
+      slot = upperIndex(elements(leaf.data()), header(leaf.data()).count, t);
+   }
+   return iteratorAt(pageNo, slot);
+}
+
+/*****************************************************
+ * DISK B-TREE :: FIND
+ * The first element equal to t, or end()
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator
+disk_btree <T, Compare, PageSize> :: find(const T & t)
+{
+   iterator it = lower_bound(t);
+   if (it != end() && compare(t, *it))
+      return end();
+   return it;
+}
+
+/*****************************************************
+ * DISK B-TREE :: INSERT
+ * Go down to the leaf remembering the way, and put t
+ * after any equal elements. A full leaf splits in
+ * half, and its new right half's first element goes
+ * up to the parent as a separator, which may split
+ * the parent in turn, up to a new root
+ *   INPUT  : t, and whether to leave the tree alone
+ *            when t is there already
+ *   OUTPUT : an iterator to t, and whether it is new
+ *   COST   : height() pages, plus two for each split
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+std::pair<typename disk_btree <T, Compare, PageSize> :: iterator, bool>
+disk_btree <T, Compare, PageSize> :: insert(const T & t, bool keepUnique)
+{
+   if (keepUnique)
+   {
+      iterator it = find(t);
+      if (it != end())
+         return std::make_pair(it, false);
+   }
+
+   // the first element goes in a root that is a leaf
+   if (meta.root == 0)
+   {
+      meta.root = meta.firstLeaf = allocate();
+      meta.height = 1;
+      Page leaf(cache, meta.root, true /*fresh*/);
+      header(leaf.data()).isLeaf = 1;
+   }
+
+   uint64_t path[maxHeight];
+   size_t childIndex[maxHeight];
+   uint64_t pageNo = meta.root;
+   for (size_t level = meta.height; level > 1; level--)
+   {
+      Page inner(cache, pageNo);
+      size_t i = upperIndex(separators(inner.data()), header(inner.data()).count, t);
+      path[level] = pageNo;
+      childIndex[level] = i;
+      pageNo = children(inner.data())[i];
+   }
+
+   meta.numElements++;
+   Page leaf(cache, pageNo);
+   leaf.markDirty();
+   Header & h = header(leaf.data());
+   T * a = elements(leaf.data());
+   size_t slot = upperIndex(a, h.count, t);
+
+   if (h.count < leafCap)
+   {
+      memmove((void *)(a + slot + 1), (const void *)(a + slot), (h.count - slot) * sizeof(T));
+      a[slot] = t;
+      h.count++;
+      return std::make_pair(iterator(this, pageNo, slot, t), true);
+   }
+
+   // split: the upper half moves to a new leaf just after this one
+   uint64_t rightNo = allocate();
+   Page right(cache, rightNo, true /*fresh*/);
+   Header & hRight = header(right.data());
+   T * aRight = elements(right.data());
+   size_t mid = h.count / 2;
+   hRight.isLeaf = 1;
+   hRight.count = (uint32_t)(h.count - mid);
+   memcpy((void *)aRight, (const void *)(a + mid), hRight.count * sizeof(T));
+   h.count = (uint32_t)mid;
+
+   hRight.prev = pageNo;
+   hRight.next = h.next;
+   if (h.next != 0)
+   {
+      Page after(cache, h.next);
+      header(after.data()).prev = rightNo;
+      after.markDirty();
+   }
+   h.next = rightNo;
+
+   // now there is room on whichever side t belongs
+   uint64_t tNo = pageNo;
+   if (slot > mid)
+   {
+      slot -= mid;
+      a = aRight;
+      tNo = rightNo;
+   }
+   Header & hT = (tNo == pageNo ? h : hRight);
+   memmove((void *)(a + slot + 1), (const void *)(a + slot), (hT.count - slot) * sizeof(T));
+   a[slot] = t;
+   hT.count++;
+
+   T separator = aRight[0];
+   iterator it(this, tNo, slot, t);
+   insertSeparator(path, childIndex, 2, separator, rightNo);
+   return std::make_pair(it, true);
+}
+
+/*****************************************************
+ * DISK B-TREE :: INSERT SEPARATOR
+ * Give the inner page at a level on the path a new
+ * child, right after the one we went down through,
+ * splitting the page if it is full. An inner split
+ * moves its middle separator up instead of copying it
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+void disk_btree <T, Compare, PageSize> :: insertSeparator(const uint64_t * path, const size_t * childIndex,
+                                                          size_t level, T separator, uint64_t right)
+{
+   for (; level <= meta.height; level++)
+   {
+      Page inner(cache, path[level]);
+      inner.markDirty();
+      Header & h = header(inner.data());
+      uint64_t * kids = children(inner.data());
+      T * seps = separators(inner.data());
+      size_t i = childIndex[level];
+
+      if (h.count < innerCap)
+      {
+         memmove((void *)(seps + i + 1), (const void *)(seps + i), (h.count - i) * sizeof(T));
+         memmove(kids + i + 2, kids + i + 1, (h.count - i) * sizeof(uint64_t));
+         seps[i] = separator;
+         kids[i + 1] = right;
+         h.count++;
+         return;
+      }
+
+      // the page's separators and children with the new ones in place
+      T allSeps[innerCap + 1];
+      uint64_t allKids[innerCap + 2];
+      memcpy((void *)allSeps, (const void *)seps, i * sizeof(T));
+      allSeps[i] = separator;
+      memcpy((void *)(allSeps + i + 1), (const void *)(seps + i), (h.count - i) * sizeof(T));
+      memcpy(allKids, kids, (i + 1) * sizeof(uint64_t));
+      allKids[i + 1] = right;
+      memcpy(allKids + i + 2, kids + i + 1, (h.count - i) * sizeof(uint64_t));
+
+      size_t total = h.count + 1;
+      size_t mid = total / 2;
+      uint64_t newNo = allocate();
+      Page newer(cache, newNo, true /*fresh*/);
+      Header & hNew = header(newer.data());
+      hNew.count = (uint32_t)(total - mid - 1);
+      memcpy((void *)separators(newer.data()), (const void *)(allSeps + mid + 1), hNew.count * sizeof(T));
+      memcpy(children(newer.data()), allKids + mid + 1, (hNew.count + 1) * sizeof(uint64_t));
+
+      h.count = (uint32_t)mid;
+      memcpy((void *)seps, (const void *)allSeps, mid * sizeof(T));
+      memcpy(kids, allKids, (mid + 1) * sizeof(uint64_t));
+
+      separator = allSeps[mid];
+      right = newNo;
+   }
+
+   // the root split: a new root above it
+   if (meta.height + 1 >= maxHeight)
+      throw std::length_error("custom::disk_btree: too deep");
+   uint64_t rootNo = allocate();
+   Page root(cache, rootNo, true /*fresh*/);
+   header(root.data()).count = 1;
+   children(root.data())[0] = meta.root;
+   children(root.data())[1] = right;
+   separators(root.data())[0] = separator;
+   meta.root = rootNo;
+   meta.height++;
+}
+
+/*****************************************************
+ * DISK B-TREE :: ERASE
+ * Take an element out of its leaf. The leaf is left
+ * in the tree even when that empties it
+ *   INPUT  : an iterator to the element
+ *   OUTPUT : an iterator to the one after it
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator
+disk_btree <T, Compare, PageSize> :: erase(iterator & it)
+{
+   if (it.pageNo == 0)
+      return end();
+
+   {
+      Page leaf(cache, it.pageNo);
+      leaf.markDirty();
+      Header & h = header(leaf.data());
+      T * a = elements(leaf.data());
+      memmove((void *)(a + it.slot), (const void *)(a + it.slot + 1), (h.count - it.slot - 1) * sizeof(T));
+      h.count--;
+   }
+   meta.numElements--;
+
+   it = iteratorAt(it.pageNo, it.slot);
+   return it;
+}
+
+/*****************************************************
+ * DISK B-TREE :: ASSIGN SORTED
+ * Replace everything with num elements already in
+ * order, building the tree bottom up: full leaves
+ * one after another, then each level of inner pages
+ * over the one below, so every page is written once
+ * and the leaves are in file order for scans
+ *   INPUT  : how many, and a function returning each
+ *            element in turn
+ *   COST   : O(n) and about n / leafCap page writes
+ ****************************************************/
+template <typename T, typename Compare, size_t PageSize>
+template <typename Source>
+void disk_btree <T, Compare, PageSize> :: assign_sorted(size_t num, Source next)
+{
+   clear();
+   if (num == 0)
+      return;
+
+   // the leaves, and the first element of each for the level above
+   custom::vector<std::pair<uint64_t, T> > level;
+   level.reserve((num + leafCap - 1) / leafCap);
+   uint64_t prevNo = 0;
+   for (size_t done = 0; done < num; )
+   {
+      uint64_t pageNo = allocate();
+      Page leaf(cache, pageNo, true /*fresh*/);
+      Header & h = header(leaf.data());
+      T * a = elements(leaf.data());
+      h.isLeaf = 1;
+      h.prev = prevNo;
+      h.next = (done + leafCap < num) ? pageNo + 1 : 0;
+      h.count = (uint32_t)((num - done < leafCap) ? num - done : leafCap);
+      for (size_t i = 0; i < h.count; i++)
+         a[i] = next();
+      level.push_back(std::make_pair(pageNo, a[0]));
+      done += h.count;
+      prevNo = pageNo;
+   }
+   meta.firstLeaf = level[0].first;
+   meta.height = 1;
+
+   // each inner level spreads the children below it evenly over its pages
+   while (level.size() > 1)
+   {
+      size_t numPages = (level.size() + innerCap) / (innerCap + 1);
+      custom::vector<std::pair<uint64_t, T> > above;
+      above.reserve(numPages);
+      size_t first = 0;
+      for (size_t page = 0; page < numPages; page++)
+      {
+         size_t numKids = level.size() / numPages + (page < level.size() % numPages ? 1 : 0);
+         uint64_t pageNo = allocate();
+         Page inner(cache, pageNo, true /*fresh*/);
+         header(inner.data()).count = (uint32_t)(numKids - 1);
+         for (size_t i = 0; i < numKids; i++)
+         {
+            children(inner.data())[i] = level[first + i].first;
+            if (i > 0)
+               separators(inner.data())[i - 1] = level[first + i].second;
+         }
+         above.push_back(std::make_pair(pageNo, level[first].second));
+         first += numKids;
+      }
+      level.swap(above);
+      meta.height++;
+   }
+
+   meta.root = level[0].first;
+   meta.numElements = num;
+}
+
+/**************************************************
+ * DISK B-TREE ITERATOR :: DECREMENT PREFIX
+ * Back one, or from end() to the last element
+ *************************************************/
+template <typename T, typename Compare, size_t PageSize>
+typename disk_btree <T, Compare, PageSize> :: iterator &
+disk_btree <T, Compare, PageSize> :: iterator :: operator -- ()
+{
+   disk_btree & tree = *pTree;
+   uint64_t pageNo = this->pageNo;
+   size_t slot = this->slot;
+
+   // end() is just past the last leaf, at the bottom of the right edge
+   if (pageNo == 0)
+   {
+      if (tree.meta.root == 0)
+         return *this;
+      pageNo = tree.meta.root;
+      for (size_t level = tree.meta.height; level > 1; level--)
+      {
+         Page inner(tree.cache, pageNo);
+         pageNo = children(inner.data())[header(inner.data()).count];
+      }
+      Page leaf(tree.cache, pageNo);
+      slot = header(leaf.data()).count;
+   }
+
+   while (pageNo != 0)
+   {
+      Page leaf(tree.cache, pageNo);
+      if (slot > 0)
+      {
+         *this = iterator(pTree, pageNo, slot - 1, elements(leaf.data())[slot - 1]);
+         return *this;
+      }
+      pageNo = header(leaf.data()).prev;
+      if (pageNo != 0)
+      {
+         Page before(tree.cache, pageNo);
+         slot = header(before.data()).count;
+      }
+   }
+
+   // there is nothing before begin(), so stay put
+   return *this;
+}
+
+} // namespace custom
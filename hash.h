@@ -0,0 +1,724 @@
+/***********************************************************************
+ * Header:
+ *    HASH
+ * Summary:
+ *    Open-addressing hash set and map in the style of Google's
+ *    SwissTable. Every slot has a one-byte control: empty, deleted,
+ *    or seven bits of the hash of the element that lives there. A
+ *    lookup loads sixteen control bytes at once and compares all of
+ *    them against the key's seven bits with one SIMD instruction, so
+ *    it only ever compares keys that almost certainly match.
+ *
+ *    The control bytes and the slots each live in a custom::vector.
+ *    The slots hold raw storage; an element is only constructed in a
+ *    slot when it is inserted there.
+ *
+ *    This will contain the class definition of:
+ *        hash_table           : The table, generic over how to find
+ *                               the key in an element
+ *        hash_table::iterator : An iterator through hash_table
+ *        unordered_set        : A hash_table of keys
+ *        unordered_map        : A hash_table of key/value pairs
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // for ASSERT
+#include <cstdint>     // for int8_t and uint64_t
+#include <cstring>     // for memcpy
+#include <functional>  // for std::hash and std::equal_to
+#include <initializer_list>
+#include <new>         // for placement new and std::launder
+#include <stdexcept>   // for std::out_of_range
+#include <tuple>       // for std::forward_as_tuple
+#include <utility>     // for std::pair
+#ifdef __SSE2__
+#include <emmintrin.h> // for the SSE2 group compares
+#endif
+#include "vector.h"
+
+class TestHash; // forward declaration for unit tests
+
+namespace custom
+{
+
+namespace swiss
+{
+   /*************************************************
+    * CONTROL BYTES
+    * A full slot's control is H2, the low seven bits
+    * of its element's hash, so it is never negative
+    *************************************************/
+   typedef int8_t ctrl_t;
+   const ctrl_t EMPTY   = -128;   // never held an element since the last rehash
+   const ctrl_t DELETED = -2;     // held one, and a probe may still need to pass
+
+   inline uint32_t lowestBit(uint32_t mask)  { return (uint32_t)__builtin_ctz(mask); }
+   inline uint32_t highestGap(uint32_t mask) { return (uint32_t)__builtin_clz(mask) - 16; }
+
+   /*************************************************
+    * GROUP
+    * Sixteen control bytes, loaded together. Each
+    * match returns a bit mask, bit i for byte i
+    *************************************************/
+   struct Group
+   {
+      static const size_t width = 16;
+#ifdef __SSE2__
+      explicit Group(const ctrl_t * p) : ctrl(_mm_loadu_si128((const __m128i *)p)) {}
+      uint32_t match(ctrl_t h2) const
+      {
+         return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+      }
+      uint32_t matchEmptyOrDeleted() const { return (uint32_t)_mm_movemask_epi8(ctrl); }
+      __m128i ctrl;
+#else
+      explicit Group(const ctrl_t * p) { memcpy(ctrl, p, width); }
+      uint32_t match(ctrl_t h2) const
+      {
+         uint32_t mask = 0;
+         for (size_t i = 0; i < width; i++)
+            mask |= (uint32_t)(ctrl[i] == h2) << i;
+         return mask;
+      }
+      uint32_t matchEmptyOrDeleted() const
+      {
+         uint32_t mask = 0;
+         for (size_t i = 0; i < width; i++)
+            mask |= (uint32_t)(ctrl[i] < 0) << i;
+         return mask;
+      }
+      ctrl_t ctrl[width];
+#endif
+      uint32_t matchEmpty() const { return match(EMPTY);                     }
+      uint32_t matchFull()  const { return matchEmptyOrDeleted() ^ 0xFFFF;   }
+   };
+
+   /*************************************************
+    * MIX
+    * std::hash of an integer is the integer itself.
+    * Spread its bits so both H1 (which group to start
+    * at) and H2 (the control byte) see all of them
+    *************************************************/
+   inline size_t mix(size_t h)
+   {
+      uint64_t x = (uint64_t)h * 0x9E3779B97F4A7C15ull;
+      return (size_t)(x ^ (x >> 32));
+   }
+
+   // how to find the key in an element
+   struct Identity
+   {
+      template <class T>
+      const T & operator () (const T & t) const { return t; }
+   };
+   struct SelectFirst
+   {
+      template <class P>
+      const typename P::first_type & operator () (const P & p) const { return p.first; }
+   };
+} // namespace swiss
+
+/*****************************************************************
+ * HASH TABLE
+ * Elements of type T, looked up by the key KeyOf finds in them.
+ * The capacity is a power of two, at least one group. The control
+ * bytes have one group more than the capacity: the first group is
+ * copied to the end, so a group can be loaded at any slot without
+ * wrapping around.
+ *
+ * A probe starts at slot H1 and looks at one group after another,
+ * each further along than the last (1, 2, 3, ... groups on), until
+ * a group has an empty slot in it. That always happens, because the
+ * table grows before its last empty slot is used.
+ *****************************************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+class hash_table
+{
+   friend class ::TestHash; // give unit tests access to the privates
+   typedef swiss::ctrl_t ctrl_t;
+   typedef swiss::Group  Group;
+public:
+   //
+   // Construct
+   //
+
+   hash_table() : numElements(0), numGrowth(0), maxLoad(0.875f) {}
+   hash_table(const hash_table &  rhs);
+   hash_table(      hash_table && rhs);
+   hash_table(const std::initializer_list<T>& il);
+   ~hash_table() { clear(); }
+
+   //
+   // Assign
+   //
+
+   hash_table & operator = (const hash_table &  rhs);
+   hash_table & operator = (      hash_table && rhs);
+   void swap(hash_table & rhs);
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   iterator begin() const;
+   iterator end()   const { return iterator(this, capacity()); }
+
+   //
+   // Access
+   //
+
+   iterator find(const K & key) const;
+   size_t   count(const K & key) const { return find(key) != end() ? 1 : 0; }
+
+   //
+   // Insert
+   //
+
+   std::pair<iterator, bool> insert(const T &  t) { return emplaceKey(KeyOf()(t), t); }
+   std::pair<iterator, bool> insert(      T && t) { return emplaceKey(KeyOf()(t), std::move(t)); }
+   void reserve(size_t num);
+   void rehash(size_t numSlots);
+
+   //
+   // Remove
+   //
+
+   size_t   erase(const K & key);
+   iterator erase(iterator it);
+   void     clear();
+
+   //
+   // Status
+   //
+
+   size_t size()            const { return numElements;              }
+   bool   empty()           const { return numElements == 0;         }
+   size_t capacity()        const { return slots.size();             }
+   float  load_factor()     const { return capacity() ? (float)numElements / capacity() : 0.0f; }
+   float  max_load_factor() const { return maxLoad;                  }
+   void   max_load_factor(float ml);
+
+protected:
+
+   template <class... Args>
+   std::pair<iterator, bool> emplaceKey(const K & key, Args&&... args);
+
+private:
+
+   // raw storage for one element
+   struct Slot
+   {
+      alignas(T) unsigned char bytes[sizeof(T)];
+   };
+
+   T & value(size_t i) const
+   {
+      return *std::launder(reinterpret_cast<T *>(const_cast<unsigned char *>(slots[i].bytes)));
+   }
+   size_t hash(const K & key) const { return swiss::mix(hasher(key)); }
+   size_t findIndex(const K & key, size_t h) const;
+   size_t findInsertSlot(size_t h) const;
+   void   setCtrl(size_t i, ctrl_t c);
+   size_t maxSize(size_t numSlots) const;
+   void   grow();
+   void   resize(size_t numSlots);
+
+   custom::vector<ctrl_t> ctrl;  // capacity() + Group::width control bytes
+   custom::vector<Slot>   slots; // capacity() slots, constructed where ctrl is full
+   size_t numElements;           // full slots
+   size_t numGrowth;             // empty slots we may still fill before growing
+   float  maxLoad;               // the fraction of slots that may be full or deleted
+   Hash     hasher;
+   KeyEqual equal;
+};
+
+/**************************************************
+ * HASH TABLE ITERATOR
+ * Walks the slots in order, skipping a group of
+ * empty ones at a time
+ *************************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+class hash_table <T, K, KeyOf, Hash, KeyEqual> :: iterator
+{
+   friend class hash_table;
+public:
+   iterator() : pTable(nullptr), index(0) {}
+
+   bool operator == (const iterator & rhs) const { return index == rhs.index; }
+   bool operator != (const iterator & rhs) const { return index != rhs.index; }
+
+   T & operator *  () const { return  pTable->value(index); }
+   T * operator -> () const { return &pTable->value(index); }
+
+   iterator & operator ++ ()
+   {
+      index++;
+      skipEmpty();
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator it = *this;
+      ++*this;
+      return it;
+   }
+
+private:
+   iterator(const hash_table * pTable, size_t index) : pTable(pTable), index(index) {}
+
+   // move forward to the first full slot at or after index
+   void skipEmpty()
+   {
+      size_t num = pTable->capacity();
+      while (index < num)
+      {
+         uint32_t mask = Group(&pTable->ctrl[index]).matchFull();
+         if (num - index < Group::width)
+            mask &= (1u << (num - index)) - 1;   // past the end is the copy of the start
+         if (mask)
+         {
+            index += swiss::lowestBit(mask);
+            return;
+         }
+         index += Group::width;
+      }
+      index = num;
+   }
+
+   const hash_table * pTable;
+   size_t index;
+};
+
+/*********************************************
+ * HASH TABLE :: COPY CONSTRUCTOR
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: hash_table(const hash_table & rhs) : hash_table()
+{
+   *this = rhs;
+}
+
+/*********************************************
+ * HASH TABLE :: MOVE CONSTRUCTOR
+ * Take the slots of rhs, leaving it empty
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: hash_table(hash_table && rhs) : hash_table()
+{
+   swap(rhs);
+}
+
+/*********************************************
+ * HASH TABLE :: INITIALIZER LIST CONSTRUCTOR
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: hash_table(const std::initializer_list<T>& il) : hash_table()
+{
+   reserve(il.size());
+   for (const T & t : il)
+      insert(t);
+}
+
+/*********************************************
+ * HASH TABLE :: ASSIGNMENT OPERATOR
+ * The keys in rhs are already unique, so every
+ * element goes straight into the first free slot
+ * of its probe with no key compares
+ *   COST   : O(n)
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+hash_table <T, K, KeyOf, Hash, KeyEqual> &
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: operator = (const hash_table & rhs)
+{
+   if (this == &rhs)
+      return *this;
+   clear();
+   hasher  = rhs.hasher;
+   equal   = rhs.equal;
+   maxLoad = rhs.maxLoad;
+   reserve(rhs.size());
+
+   for (iterator it = rhs.begin(); it != rhs.end(); ++it)
+   {
+      size_t h = hash(KeyOf()(*it));
+      size_t i = findInsertSlot(h);
+      new (slots[i].bytes) T(*it);
+      setCtrl(i, (ctrl_t)(h & 0x7F));
+      numElements++;
+      numGrowth--;
+   }
+   return *this;
+}
+
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+hash_table <T, K, KeyOf, Hash, KeyEqual> &
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: operator = (hash_table && rhs)
+{
+   clear();
+   swap(rhs);
+   return *this;
+}
+
+/*********************************************
+ * HASH TABLE :: SWAP
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: swap(hash_table & rhs)
+{
+   ctrl.swap(rhs.ctrl);
+   slots.swap(rhs.slots);
+   std::swap(numElements, rhs.numElements);
+   std::swap(numGrowth,   rhs.numGrowth);
+   std::swap(maxLoad,     rhs.maxLoad);
+   std::swap(hasher,      rhs.hasher);
+   std::swap(equal,       rhs.equal);
+}
+
+/*********************************************
+ * HASH TABLE :: BEGIN
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+typename hash_table <T, K, KeyOf, Hash, KeyEqual> :: iterator
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: begin() const
+{
+   iterator it(this, 0);
+   it.skipEmpty();
+   return it;
+}
+
+/*********************************************
+ * HASH TABLE :: FIND
+ * Probe group by group. Only the slots whose
+ * control byte matches H2 have their keys
+ * compared, and a group with an empty slot in
+ * it means the key was never inserted
+ *   COST   : O(1) expected
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+typename hash_table <T, K, KeyOf, Hash, KeyEqual> :: iterator
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: find(const K & key) const
+{
+   if (numElements == 0)
+      return end();
+   return iterator(this, findIndex(key, hash(key)));
+}
+
+/*********************************************
+ * HASH TABLE :: FIND INDEX
+ * The slot holding key, whose hash is h, or
+ * capacity() when it is not there
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+size_t hash_table <T, K, KeyOf, Hash, KeyEqual> :: findIndex(const K & key, size_t h) const
+{
+   size_t mask = capacity() - 1;
+   size_t pos = (h >> 7) & mask;
+   for (size_t step = Group::width; ; step += Group::width)
+   {
+      Group group(&ctrl[pos]);
+      for (uint32_t match = group.match((ctrl_t)(h & 0x7F)); match; match &= match - 1)
+      {
+         size_t i = (pos + swiss::lowestBit(match)) & mask;
+         if (equal(KeyOf()(value(i)), key))
+            return i;
+      }
+      if (group.matchEmpty())
+         return capacity();
+      pos = (pos + step) & mask;
+   }
+}
+
+/*********************************************
+ * HASH TABLE :: EMPLACE KEY
+ * Find key, and if it is not there construct a
+ * new element from args in the first empty or
+ * deleted slot of its probe. Filling a deleted
+ * slot does not use up any growth
+ *   OUTPUT : the element and whether it is new
+ *   COST   : O(1) expected, O(n) when it grows
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+template <class... Args>
+std::pair<typename hash_table <T, K, KeyOf, Hash, KeyEqual> :: iterator, bool>
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: emplaceKey(const K & key, Args&&... args)
+{
+   size_t h = hash(key);
+   size_t i = capacity();
+   if (numElements && (i = findIndex(key, h)) != capacity())
+      return std::make_pair(iterator(this, i), false);
+
+   if (capacity())
+      i = findInsertSlot(h);
+   if (numGrowth == 0 && (capacity() == 0 || ctrl[i] == swiss::EMPTY))
+   {
+      grow();
+      i = findInsertSlot(h);
+   }
+   if (ctrl[i] == swiss::EMPTY)
+      numGrowth--;
+
+   new (slots[i].bytes) T(std::forward<Args>(args)...);
+   setCtrl(i, (ctrl_t)(h & 0x7F));
+   numElements++;
+   return std::make_pair(iterator(this, i), true);
+}
+
+/*********************************************
+ * HASH TABLE :: RESERVE
+ * Make room for num elements with no rehash
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: reserve(size_t num)
+{
+   if (num <= size() + numGrowth)
+      return;
+   size_t numSlots = Group::width;
+   while (maxSize(numSlots) < num)
+      numSlots *= 2;
+   if (numSlots > capacity())
+      resize(numSlots);
+}
+
+/*********************************************
+ * HASH TABLE :: REHASH
+ * Move every element into a table of at least
+ * numSlots slots (rounded up to a power of two,
+ * and to what size() needs). This also clears
+ * out every deleted slot
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: rehash(size_t numSlots)
+{
+   if (numSlots == 0 && numElements == 0)
+   {
+      clear();
+      custom::vector<ctrl_t>().swap(ctrl);
+      custom::vector<Slot>().swap(slots);
+      numGrowth = 0;
+      return;
+   }
+
+   size_t num = Group::width;
+   while (num < numSlots || maxSize(num) < numElements)
+      num *= 2;
+   resize(num);
+}
+
+/*********************************************
+ * HASH TABLE :: ERASE
+ * A slot can go back to empty, rather than to
+ * deleted, when no probe ever passed over it.
+ * A probe only passes a group with no empty slot
+ * in it, so if every group containing this slot
+ * also holds an empty one, none did
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+typename hash_table <T, K, KeyOf, Hash, KeyEqual> :: iterator
+hash_table <T, K, KeyOf, Hash, KeyEqual> :: erase(iterator it)
+{
+   size_t i = it.index;
+   iterator itNext = it;
+   ++itNext;
+
+   value(i).~T();
+   numElements--;
+
+   size_t mask = capacity() - 1;
+   uint32_t emptyBefore = Group(&ctrl[(i - Group::width) & mask]).matchEmpty();
+   uint32_t emptyAfter  = Group(&ctrl[i]).matchEmpty();
+   bool neverFull = emptyBefore && emptyAfter &&
+                    swiss::lowestBit(emptyAfter) + swiss::highestGap(emptyBefore) < Group::width;
+   setCtrl(i, neverFull ? swiss::EMPTY : swiss::DELETED);
+   if (neverFull)
+      numGrowth++;
+   return itNext;
+}
+
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+size_t hash_table <T, K, KeyOf, Hash, KeyEqual> :: erase(const K & key)
+{
+   iterator it = find(key);
+   if (it == end())
+      return 0;
+   erase(it);
+   return 1;
+}
+
+/*********************************************
+ * HASH TABLE :: CLEAR
+ * Destroy every element but keep the slots
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: clear()
+{
+   if (numElements)
+      for (iterator it = begin(); it != end(); ++it)
+         it->~T();
+   for (size_t i = 0; i < ctrl.size(); i++)
+      ctrl[i] = swiss::EMPTY;
+   numElements = 0;
+   numGrowth = maxSize(capacity());
+}
+
+/*********************************************
+ * HASH TABLE :: MAX LOAD FACTOR
+ * Fuller tables probe further. Past 7/8 a probe
+ * may not find an empty slot in time, and below
+ * 1/4 most of the memory is empty
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: max_load_factor(float ml)
+{
+   maxLoad = ml < 0.25f ? 0.25f : (ml > 0.875f ? 0.875f : ml);
+   if (capacity())
+      rehash(0);
+}
+
+/*********************************************
+ * HASH TABLE :: FIND INSERT SLOT
+ * The first empty or deleted slot along the
+ * probe for hash h
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+size_t hash_table <T, K, KeyOf, Hash, KeyEqual> :: findInsertSlot(size_t h) const
+{
+   size_t mask = capacity() - 1;
+   size_t pos = (h >> 7) & mask;
+   for (size_t step = Group::width; ; step += Group::width)
+   {
+      uint32_t match = Group(&ctrl[pos]).matchEmptyOrDeleted();
+      if (match)
+         return (pos + swiss::lowestBit(match)) & mask;
+      pos = (pos + step) & mask;
+   }
+}
+
+/*********************************************
+ * HASH TABLE :: SET CTRL
+ * The first group's bytes also live at the end
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: setCtrl(size_t i, ctrl_t c)
+{
+   ctrl[i] = c;
+   if (i < Group::width)
+      ctrl[capacity() + i] = c;
+}
+
+/*********************************************
+ * HASH TABLE :: MAX SIZE
+ * How many slots may be full or deleted before
+ * we grow. At least one is always left empty
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+size_t hash_table <T, K, KeyOf, Hash, KeyEqual> :: maxSize(size_t numSlots) const
+{
+   if (numSlots == 0)
+      return 0;
+   size_t num = (size_t)(numSlots * maxLoad);
+   return num < numSlots ? num : numSlots - 1;
+}
+
+/*********************************************
+ * HASH TABLE :: GROW
+ * Out of empty slots. If deleted ones are most
+ * of what filled the table, rehashing at the same
+ * size clears them out; otherwise double
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: grow()
+{
+   size_t numSlots = capacity();
+   if (numSlots == 0)
+      resize(Group::width);
+   else if (numElements * 2 < maxSize(numSlots))
+      resize(numSlots);
+   else
+      resize(numSlots * 2);
+}
+
+/*********************************************
+ * HASH TABLE :: RESIZE
+ * Move every element into fresh slots. The keys
+ * are unique, so nothing is compared
+ *   COST   : O(n)
+ ********************************************/
+template <typename T, typename K, typename KeyOf, typename Hash, typename KeyEqual>
+void hash_table <T, K, KeyOf, Hash, KeyEqual> :: resize(size_t numSlots)
+{
+   assert(numSlots >= Group::width && (numSlots & (numSlots - 1)) == 0);
+   custom::vector<ctrl_t> ctrlOld;
+   custom::vector<Slot>   slotsOld;
+   ctrlOld.swap(ctrl);
+   slotsOld.swap(slots);
+
+   ctrl.resize(numSlots + Group::width, swiss::EMPTY);
+   slots.resize(numSlots);
+   for (size_t iOld = 0; iOld < slotsOld.size(); iOld++)
+      if (ctrlOld[iOld] >= 0)
+      {
+         T & t = *std::launder(reinterpret_cast<T *>(slotsOld[iOld].bytes));
+         size_t h = hash(KeyOf()(t));
+         size_t i = findInsertSlot(h);
+         new (slots[i].bytes) T(std::move(t));
+         t.~T();
+         setCtrl(i, (ctrl_t)(h & 0x7F));
+      }
+   numGrowth = maxSize(numSlots) - numElements;
+}
+
+/*****************************************************************
+ * UNORDERED SET
+ * A hash_table whose elements are their own keys
+ *****************************************************************/
+template <typename K, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K> >
+class unordered_set : public hash_table<K, K, swiss::Identity, Hash, KeyEqual>
+{
+public:
+   using hash_table<K, K, swiss::Identity, Hash, KeyEqual>::hash_table;
+};
+
+/*****************************************************************
+ * UNORDERED MAP
+ * A hash_table of pairs, looked up by the first of the pair
+ *****************************************************************/
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K> >
+class unordered_map : public hash_table<std::pair<const K, V>, K, swiss::SelectFirst, Hash, KeyEqual>
+{
+   typedef hash_table<std::pair<const K, V>, K, swiss::SelectFirst, Hash, KeyEqual> Table;
+public:
+   using Table::Table;
+   typedef typename Table::iterator iterator;
+
+   // insert a value made from args, unless key is already there
+   template <class... Args>
+   std::pair<iterator, bool> try_emplace(const K & key, Args&&... args)
+   {
+      return this->emplaceKey(key, std::piecewise_construct,
+                              std::forward_as_tuple(key),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+   }
+
+   V & operator [] (const K & key) { return try_emplace(key).first->second; }
+
+   V & at(const K & key)
+   {
+      iterator it = this->find(key);
+      if (it == this->end())
+         throw std::out_of_range("custom::unordered_map::at");
+      return it->second;
+   }
+   const V & at(const K & key) const
+   {
+      iterator it = this->find(key);
+      if (it == this->end())
+         throw std::out_of_range("custom::unordered_map::at");
+      return it->second;
+   }
+};
+
+} // namespace custom
@@ -0,0 +1,588 @@
+/***********************************************************************
+ * Header:
+ *    LSM MAP
+ * Summary:
+ *    A write-optimized ordered map in the style of a log-structured
+ *    merge tree. Writes go into a small BST, the memtable, which stays
+ *    in cache however big the map grows, so its rebalancing is cheap.
+ *    When the memtable is full it is frozen: its elements are copied
+ *    out in order into a sorted run, a custom::vector that is never
+ *    changed again, and the memtable starts over empty.
+ *
+ *    Runs are kept in levels. A new run goes into level 0, and once a
+ *    level holds fanout runs a background thread merges them into one
+ *    run in the next level ("tiered" compaction), so every element is
+ *    copied about log_fanout(n / memtable) times in all.
+ *
+ *    An erase is a write too: it puts a tombstone over the key, which
+ *    hides older values until a merge into the bottom level, where
+ *    nothing older is left to hide, drops it. A lookup searches the
+ *    memtable and then each run from newest to oldest and stops at
+ *    the first entry for the key. Each run can have a Bloom filter,
+ *    so a lookup does not binary search runs that lack the key.
+ *
+ *    This will contain the class definition of:
+ *        lsm_map          : The map
+ *        lsm::Entry       : A key with its value, or a tombstone
+ *        lsm::Bloom       : A Bloom filter over one run's keys
+ *        lsm::Run         : A sorted run and its filter
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <condition_variable>  // for std::condition_variable
+#include <cstdint>             // for uint64_t
+#include <functional>          // for std::less and std::hash
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <utility>             // for std::move
+#include <vector>              // for the level lists
+#include "bst.h"
+#include "hash.h"              // for swiss::mix
+#include "vector.h"
+
+class TestLSMMap; // forward declaration for unit tests
+
+namespace custom
+{
+
+namespace lsm
+{
+   /*************************************************
+    * ENTRY
+    * What the memtable and the runs hold: a key and
+    * its value, or a key that was erased
+    *************************************************/
+   template <typename K, typename V>
+   struct Entry
+   {
+      Entry() : key(), value(), erased(false) {}
+      explicit Entry(const K & key) : key(key), value(), erased(false) {}
+      K key;
+      V value;
+      bool erased;   // a tombstone: the key is gone, whatever older runs say
+   };
+
+   // orders entries by key, and takes a bare key too
+   template <typename K, typename V, typename Compare>
+   struct EntryLess
+   {
+      typedef void is_transparent;
+      typedef Entry<K, V> E;
+      bool operator () (const E & lhs, const E & rhs) const { return Compare()(lhs.key, rhs.key); }
+      bool operator () (const E & lhs, const K & rhs) const { return Compare()(lhs.key, rhs);     }
+      bool operator () (const K & lhs, const E & rhs) const { return Compare()(lhs, rhs.key);     }
+   };
+
+   /*************************************************
+    * BLOOM
+    * bitsPerKey bits for every key in the run, and
+    * k = 0.69 bitsPerKey probes per key, which gives
+    * about 1% false positives at 10 bits. A filter
+    * with no bits says yes to everything. The probes
+    * come from one hash by double hashing
+    *************************************************/
+   class Bloom
+   {
+   public:
+      Bloom() : numHashes(0) {}
+      void build(size_t numKeys, size_t bitsPerKey)
+      {
+         if (numKeys == 0 || bitsPerKey == 0)
+            return;
+         bits.resize((numKeys * bitsPerKey + 63) / 64, 0);
+         numHashes = (unsigned)(bitsPerKey * 69 / 100);
+         numHashes = numHashes < 1 ? 1 : (numHashes > 16 ? 16 : numHashes);
+      }
+      void add(size_t h)
+      {
+         for (Probe probe(h, bits.size() * 64); probe.i < numHashes; probe.next())
+            bits[probe.bit / 64] |= (uint64_t)1 << (probe.bit % 64);
+      }
+      bool mayContain(size_t h) const
+      {
+         for (Probe probe(h, bits.size() * 64); probe.i < numHashes; probe.next())
+            if (!(bits[probe.bit / 64] & ((uint64_t)1 << (probe.bit % 64))))
+               return false;
+         return true;
+      }
+      size_t sizeBytes() const { return bits.size() * sizeof(uint64_t); }
+
+   private:
+      struct Probe
+      {
+         Probe(size_t h, size_t numBits) : i(0), numBits(numBits),
+            bit(numBits ? h % numBits : 0), delta(((h >> 32) | 1) % (numBits ? numBits : 1)) {}
+         void next() { i++; bit += delta; if (bit >= numBits) bit -= numBits; }
+         unsigned i;
+         size_t numBits;
+         size_t bit;
+         size_t delta;
+      };
+
+      custom::vector<uint64_t> bits;
+      unsigned numHashes;
+   };
+
+   /*************************************************
+    * RUN
+    * Entries sorted by key, one per key, and never
+    * changed once built
+    *************************************************/
+   template <typename K, typename V>
+   struct Run
+   {
+      custom::vector<Entry<K, V> > entries;
+      Bloom bloom;
+   };
+} // namespace lsm
+
+/*****************************************************************
+ * LSM MAP
+ * One thread at a time may use the map, as with the other
+ * containers; the merging goes on in a thread of the map's own.
+ * V must be default-constructible.
+ *
+ * Only the merge thread takes runs out of the levels, and it only
+ * deletes them after taking them out with the lock held. Lookups
+ * read runs with the lock held, so they never see one deleted,
+ * and the merge thread reads the runs it is merging without it.
+ *****************************************************************/
+template <typename K, typename V, typename Compare = std::less<K>, typename Hash = std::hash<K> >
+class lsm_map
+{
+   friend class ::TestLSMMap; // give unit tests access to the privates
+
+   typedef lsm::Entry<K, V> Entry;
+   typedef lsm::Run<K, V> Run;
+   typedef BST<Entry, lsm::EntryLess<K, V, Compare> > Memtable;
+
+public:
+   //
+   // Construct
+   //
+   explicit lsm_map(size_t memtableSize = 4096, size_t fanout = 4, size_t bitsPerKey = 10);
+   lsm_map(const lsm_map &) = delete;
+   lsm_map & operator = (const lsm_map &) = delete;
+  ~lsm_map();
+
+   //
+   // Insert and Remove
+   //
+   void insert(const K & key, const V & value);
+   void erase(const K & key);
+
+   //
+   // Access
+   //
+   bool find(const K & key, V & value) const;
+   bool contains(const K & key) const
+   {
+      V value;
+      return find(key, value);
+   }
+   template <typename F>
+   void for_each(F f) const;
+
+   //
+   // Status and Upkeep
+   //
+   void flush();
+   void drain();
+   size_t numRuns() const;
+
+private:
+   Entry & write(const K & key);
+   void freeze();
+   void run();
+   bool pickMerge(size_t & level, size_t & numTaken, bool & dropErased);
+   Run * merge(const std::vector<Run *> & runs, bool dropErased) const;
+   template <typename Out>
+   static void mergeEntries(const std::vector<const Run *> & runs, bool dropErased, Out out);
+   bool findInRun(const Run & run, const K & key, size_t h, V & value, bool & erased) const;
+
+   Memtable memtable;
+   size_t memtableSize;             // freeze the memtable when it has this many
+   size_t fanout;                   // merge a level when it has this many runs
+   size_t bitsPerKey;               // Bloom filter size; 0 for none
+   std::vector<std::vector<Run *> > levels;  // each level oldest first
+   bool merging;                    // the merge thread has runs out of the levels
+   bool stopping;                   // the destructor is waiting for the thread
+   mutable std::mutex mutex;        // guards levels, merging, and stopping
+   std::condition_variable work;    // a new run, or stopping
+   std::condition_variable done;    // a merge finished
+   std::thread thread;
+};
+
+/*****************************************************
+ * LSM MAP :: CONSTRUCTOR
+ *   INPUT  : how big the memtable gets, how many runs
+ *            a level takes before they are merged, and
+ *            the Bloom filter bits per key
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+lsm_map <K, V, Compare, Hash> :: lsm_map(size_t memtableSize, size_t fanout, size_t bitsPerKey)
+   : memtableSize(memtableSize ? memtableSize : 1), fanout(fanout < 2 ? 2 : fanout),
+     bitsPerKey(bitsPerKey), levels(1), merging(false), stopping(false)
+{
+   thread = std::thread([this]() { run(); });
+}
+
+/*****************************************************
+ * LSM MAP :: DESTRUCTOR
+ * Stop the merge thread, abandoning any merge that
+ * has not started, and free every run
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+lsm_map <K, V, Compare, Hash> :: ~lsm_map()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   work.notify_one();
+   thread.join();
+
+   for (std::vector<Run *> & level : levels)
+      for (Run * pRun : level)
+         delete pRun;
+}
+
+/*****************************************************
+ * LSM MAP :: INSERT and ERASE
+ * Both only write to the memtable: insert gives the
+ * key a value, erase gives it a tombstone
+ *   COST   : O(log memtableSize), and now and then a
+ *            freeze of the memtable
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+void lsm_map <K, V, Compare, Hash> :: insert(const K & key, const V & value)
+{
+   Entry & entry = write(key);
+   entry.value = value;
+   entry.erased = false;
+   if (memtable.size() >= memtableSize)
+      freeze();
+}
+
+template <typename K, typename V, typename Compare, typename Hash>
+void lsm_map <K, V, Compare, Hash> :: erase(const K & key)
+{
+   Entry & entry = write(key);
+   entry.value = V();
+   entry.erased = true;
+   if (memtable.size() >= memtableSize)
+      freeze();
+}
+
+// the memtable's entry for key, new if it had none. The BST only
+// hands out const elements, but only the key decides the order
+template <typename K, typename V, typename Compare, typename Hash>
+typename lsm_map <K, V, Compare, Hash> :: Entry &
+lsm_map <K, V, Compare, Hash> :: write(const K & key)
+{
+   return const_cast<Entry &>(*memtable.try_emplace(key).first);
+}
+
+/*****************************************************
+ * LSM MAP :: FIND
+ * The newest entry for key decides: the memtable's,
+ * else the newest run's that has one
+ *   INPUT  : the key, and where to put its value
+ *   OUTPUT : whether the key is in the map
+ *   COST   : O(log memtableSize) and, for each run
+ *            the filter lets through, O(log run)
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+bool lsm_map <K, V, Compare, Hash> :: find(const K & key, V & value) const
+{
+   auto it = const_cast<Memtable &>(memtable).find(key);
+   if (it != memtable.end())
+   {
+      if ((*it).erased)
+         return false;
+      value = (*it).value;
+      return true;
+   }
+
+   size_t h = swiss::mix(Hash()(key));
+   bool erased;
+   std::lock_guard<std::mutex> lock(mutex);
+   for (const std::vector<Run *> & level : levels)
+      for (size_t i = level.size(); i-- > 0; )
+         if (findInRun(*level[i], key, h, value, erased))
+            return !erased;
+   return false;
+}
+
+/*****************************************************
+ * LSM MAP :: FIND IN RUN
+ * Binary search one run, unless its filter says the
+ * key is not there
+ *   OUTPUT : whether the run has an entry for key,
+ *            and if so its value or that it is erased
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+bool lsm_map <K, V, Compare, Hash> :: findInRun(const Run & run, const K & key, size_t h,
+                                                V & value, bool & erased) const
+{
+   if (!run.bloom.mayContain(h))
+      return false;
+
+   Compare compare;
+   size_t lo = 0;
+   size_t hi = run.entries.size();
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      if (compare(run.entries[mid].key, key))
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   if (lo == run.entries.size() || compare(key, run.entries[lo].key))
+      return false;
+
+   erased = run.entries[lo].erased;
+   if (!erased)
+      value = run.entries[lo].value;
+   return true;
+}
+
+/*****************************************************
+ * LSM MAP :: FOR EACH
+ * Call f(key, value) for every key in the map, in
+ * order. The lock is held throughout, so f must not
+ * use the map
+ *   COST   : O(n r) for r runs
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+template <typename F>
+void lsm_map <K, V, Compare, Hash> :: for_each(F f) const
+{
+   // the memtable as a run of its own, the newest
+   Run newest;
+   newest.entries.reserve(memtable.size());
+   memtable.for_each([&newest](const Entry & entry) { newest.entries.push_back(entry); });
+
+   std::lock_guard<std::mutex> lock(mutex);
+   std::vector<const Run *> runs;
+   for (size_t level = levels.size(); level-- > 0; )
+      for (const Run * pRun : levels[level])
+         runs.push_back(pRun);
+   runs.push_back(&newest);
+
+   mergeEntries(runs, true /*dropErased*/, [&f](const Entry & entry) { f(entry.key, entry.value); });
+}
+
+/*****************************************************
+ * LSM MAP :: FLUSH
+ * Freeze the memtable now rather than when it fills
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+void lsm_map <K, V, Compare, Hash> :: flush()
+{
+   if (!memtable.empty())
+      freeze();
+}
+
+/*****************************************************
+ * LSM MAP :: DRAIN
+ * Wait until no level has a merge waiting for it
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+void lsm_map <K, V, Compare, Hash> :: drain()
+{
+   std::unique_lock<std::mutex> lock(mutex);
+   done.wait(lock, [this]()
+   {
+      if (merging)
+         return false;
+      for (const std::vector<Run *> & level : levels)
+         if (level.size() >= fanout)
+            return false;
+      return true;
+   });
+}
+
+// how many runs a lookup may have to search
+template <typename K, typename V, typename Compare, typename Hash>
+size_t lsm_map <K, V, Compare, Hash> :: numRuns() const
+{
+   std::lock_guard<std::mutex> lock(mutex);
+   size_t num = 0;
+   for (const std::vector<Run *> & level : levels)
+      num += level.size();
+   return num;
+}
+
+/*****************************************************
+ * LSM MAP :: FREEZE
+ * Copy the memtable out into a new run in level 0,
+ * and start it over. If the merge thread has fallen
+ * so far behind that level 0 has four times fanout
+ * runs, wait for it: lookups would slow down without
+ * limit otherwise
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+void lsm_map <K, V, Compare, Hash> :: freeze()
+{
+   Run * pRun = new Run;
+   pRun->entries.reserve(memtable.size());
+   pRun->bloom.build(memtable.size(), bitsPerKey);
+   memtable.for_each([pRun](const Entry & entry)
+   {
+      pRun->entries.push_back(entry);
+      pRun->bloom.add(swiss::mix(Hash()(entry.key)));
+   });
+   memtable.clear();
+
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      levels[0].push_back(pRun);
+      work.notify_one();
+      done.wait(lock, [this]() { return levels[0].size() < fanout * 4; });
+   }
+}
+
+/*****************************************************
+ * LSM MAP :: RUN
+ * The merge thread: merge the shallowest full level
+ * into the next, over and over, and sleep when no
+ * level is full
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+void lsm_map <K, V, Compare, Hash> :: run()
+{
+   std::unique_lock<std::mutex> lock(mutex);
+   while (true)
+   {
+      size_t level;
+      size_t numTaken;
+      bool dropErased;
+      work.wait(lock, [&]() { return stopping || pickMerge(level, numTaken, dropErased); });
+      if (stopping)
+         return;
+
+      // the runs stay in the level, where lookups still find them,
+      // until the merged run takes their place
+      std::vector<Run *> runs(levels[level].begin(), levels[level].begin() + numTaken);
+      merging = true;
+      lock.unlock();
+      Run * pMerged = merge(runs, dropErased);
+      lock.lock();
+
+      std::vector<Run *> & from = levels[level];
+      from.erase(from.begin(), from.begin() + numTaken);
+      if (level + 1 == levels.size())
+         levels.emplace_back();
+      levels[level + 1].push_back(pMerged);
+      merging = false;
+
+      lock.unlock();
+      for (Run * pRun : runs)
+         delete pRun;
+      lock.lock();
+      done.notify_all();
+   }
+}
+
+/*****************************************************
+ * LSM MAP :: PICK MERGE
+ * The shallowest level with fanout runs, if any.
+ * Tombstones can go when the merged run will be the
+ * oldest one left: the next level and every deeper
+ * one are empty
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+bool lsm_map <K, V, Compare, Hash> :: pickMerge(size_t & level, size_t & numTaken, bool & dropErased)
+{
+   for (level = 0; level < levels.size(); level++)
+      if (levels[level].size() >= fanout)
+      {
+         numTaken = levels[level].size();
+         dropErased = true;
+         for (size_t deeper = level + 1; deeper < levels.size(); deeper++)
+            dropErased = dropErased && levels[deeper].empty();
+         return true;
+      }
+   return false;
+}
+
+/*****************************************************
+ * LSM MAP :: MERGE
+ * One run out of several, oldest first, with a new
+ * filter over the keys that are kept
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+typename lsm_map <K, V, Compare, Hash> :: Run *
+lsm_map <K, V, Compare, Hash> :: merge(const std::vector<Run *> & runs, bool dropErased) const
+{
+   size_t num = 0;
+   for (const Run * pRun : runs)
+      num += pRun->entries.size();
+
+   Run * pMerged = new Run;
+   pMerged->entries.reserve(num);
+   mergeEntries(std::vector<const Run *>(runs.begin(), runs.end()), dropErased,
+                [pMerged](const Entry & entry) { pMerged->entries.push_back(entry); });
+   pMerged->entries.shrink_to_fit();
+
+   pMerged->bloom.build(pMerged->entries.size(), bitsPerKey);
+   for (size_t i = 0; i < pMerged->entries.size(); i++)
+      pMerged->bloom.add(swiss::mix(Hash()(pMerged->entries[i].key)));
+   return pMerged;
+}
+
+/*****************************************************
+ * LSM MAP :: MERGE ENTRIES
+ * Walk several runs, oldest first, together in key
+ * order, and hand each key's newest entry to out.
+ * There are only ever a few runs, so the smallest
+ * key is found by looking at each of them
+ *   INPUT  : the runs, whether to leave out tombstones,
+ *            and what to call with each entry
+ *   COST   : O(n r) for n entries in r runs
+ ****************************************************/
+template <typename K, typename V, typename Compare, typename Hash>
+template <typename Out>
+void lsm_map <K, V, Compare, Hash> :: mergeEntries(const std::vector<const Run *> & runs,
+                                                   bool dropErased, Out out)
+{
+   Compare compare;
+   std::vector<size_t> next(runs.size(), 0);
+   while (true)
+   {
+      // the newest run with the smallest key; on a tie the later run is newer
+      const Entry * pSmallest = nullptr;
+      for (size_t i = 0; i < runs.size(); i++)
+         if (next[i] < runs[i]->entries.size())
+         {
+            const Entry & entry = runs[i]->entries[next[i]];
+            if (pSmallest == nullptr || !compare(pSmallest->key, entry.key))
+               pSmallest = &entry;
+         }
+      if (pSmallest == nullptr)
+         return;
+
+      if (!(dropErased && pSmallest->erased))
+         out(*pSmallest);
+
+      // every older entry for the same key is hidden by this one
+      const K & key = pSmallest->key;
+      for (size_t i = 0; i < runs.size(); i++)
+         if (next[i] < runs[i]->entries.size() && !compare(key, runs[i]->entries[next[i]].key)
+             && &runs[i]->entries[next[i]] != pSmallest)
+            next[i]++;
+      for (size_t i = 0; i < runs.size(); i++)
+         if (next[i] < runs[i]->entries.size() && &runs[i]->entries[next[i]] == pSmallest)
+         {
+            next[i]++;
+            break;
+         }
+   }
+}
+
+} // namespace custom
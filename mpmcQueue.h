@@ -0,0 +1,417 @@
+/***********************************************************************
+ * Header:
+ *    MPMC QUEUE
+ * Summary:
+ *    A lock-free multi-producer, multi-consumer queue for passing work
+ *    between threads. It is a Michael-Scott queue: a singly linked list
+ *    of nodes with a dummy node at the head, where producers CAS new
+ *    nodes onto the tail and consumers CAS the head forward. Nodes that
+ *    leave the queue are reclaimed through hazard pointers, so a consumer
+ *    never frees a node another thread is still reading.
+ *
+ *    This will contain the class definition of:
+ *        HazardPointers       : Safe reclamation for lock-free structures
+ *        mpmc_queue           : A lock-free FIFO queue
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include <new>         // for placement new
+#include <utility>     // for std::move
+#include <algorithm>   // for std::sort and std::binary_search
+#include "vector.h"    // for the retired list and bulk pop
+
+namespace custom
+{
+
+/*************************************************
+ * HAZARD POINTERS
+ * Each thread owns a record with a couple of hazard
+ * slots. Before a thread dereferences a shared node it
+ * publishes the pointer in a slot; a retired node is only
+ * freed once no slot anywhere holds it. Records are never
+ * freed, only recycled when their thread exits, so the
+ * list of records can be walked without locks.
+ *************************************************/
+class HazardPointers
+{
+public:
+   static const int numSlots = 2;  // hazards one thread holds at once
+
+   struct Record
+   {
+      Record() : active(true), pNext(nullptr)
+      {
+         for (int i = 0; i < numSlots; i++)
+            hazard[i].store(nullptr);
+      }
+
+      std::atomic<void *> hazard[numSlots];  // published pointers
+      std::atomic<bool> active;              // owned by a live thread
+      Record * pNext;                        // fixed once published
+      custom::vector<std::pair<void *, void (*)(void *)>> retired;
+   };
+
+   // the record of the calling thread
+   static Record * mine()
+   {
+      thread_local Owner owner;
+      if (owner.pRecord == nullptr)
+         owner.pRecord = acquire();
+      return owner.pRecord;
+   }
+
+   /***********************************************
+    * PROTECT
+    * Publish the current value of src in slot i and
+    * return it, retrying until src did not change
+    * underneath us
+    **********************************************/
+   template <class P>
+   static P * protect(Record * pRecord, int i, const std::atomic<P *> & src)
+   {
+      P * p = src.load();
+      while (true)
+      {
+         pRecord->hazard[i].store(p);
+         P * pCheck = src.load();
+         if (pCheck == p)
+            return p;
+         p = pCheck;
+      }
+   }
+
+   /***********************************************
+    * RETIRE
+    * Hand p to the reclaimer. It is freed with deleter
+    * once no thread has it published.
+    **********************************************/
+   static void retire(Record * pRecord, void * p, void (*deleter)(void *))
+   {
+      pRecord->retired.push_back(std::make_pair(p, deleter));
+      if (pRecord->retired.size() >= threshold())
+         scan(pRecord);
+   }
+
+   /***********************************************
+    * SCAN
+    * Free every retired pointer of this record that no
+    * hazard slot holds
+    *   COST   : O(R log H)
+    **********************************************/
+   static void scan(Record * pRecord)
+   {
+      custom::vector<void *> hazards;
+      for (Record * p = pHead.load(); p; p = p->pNext)
+         for (int i = 0; i < numSlots; i++)
+         {
+            void * pHazard = p->hazard[i].load();
+            if (pHazard != nullptr)
+               hazards.push_back(pHazard);
+         }
+      if (!hazards.empty())
+         std::sort(&hazards[0], &hazards[0] + hazards.size());
+
+      custom::vector<std::pair<void *, void (*)(void *)>> keep;
+      for (size_t i = 0; i < pRecord->retired.size(); i++)
+      {
+         auto & retired = pRecord->retired[i];
+         if (!hazards.empty() &&
+             std::binary_search(&hazards[0], &hazards[0] + hazards.size(), retired.first))
+            keep.push_back(retired);
+         else
+            retired.second(retired.first);
+      }
+      pRecord->retired.swap(keep);
+   }
+
+private:
+   // give the record back when the thread exits
+   struct Owner
+   {
+      Record * pRecord = nullptr;
+      ~Owner()
+      {
+         if (pRecord == nullptr)
+            return;
+         for (int i = 0; i < numSlots; i++)
+            pRecord->hazard[i].store(nullptr);
+         scan(pRecord);  // leftovers go to the next owner
+         pRecord->active.store(false);
+      }
+   };
+
+   // reuse an idle record, or push a new one on the list
+   static Record * acquire()
+   {
+      for (Record * p = pHead.load(); p; p = p->pNext)
+      {
+         bool expected = false;
+         if (!p->active.load() && p->active.compare_exchange_strong(expected, true))
+            return p;
+      }
+
+      Record * pNew = new Record;
+      pNew->pNext = pHead.load();
+      while (!pHead.compare_exchange_weak(pNew->pNext, pNew))
+         ;
+      numRecords.fetch_add(1);
+      return pNew;
+   }
+
+   // scan once a thread has retired about twice as many nodes as can be hazardous
+   static size_t threshold()
+   {
+      return 2 * numSlots * numRecords.load() + 64;
+   }
+
+   inline static std::atomic<Record *> pHead { nullptr };
+   inline static std::atomic<size_t> numRecords { 0 };
+};
+
+/*************************************************
+ * MPMC QUEUE
+ * A lock-free FIFO queue. push and pop may be called
+ * from any number of threads at once; construction
+ * and destruction may not.
+ *************************************************/
+template <class T>
+class mpmc_queue
+{
+public:
+   //
+   // Construct
+   //
+   mpmc_queue();
+   mpmc_queue(const mpmc_queue &) = delete;
+   mpmc_queue & operator = (const mpmc_queue &) = delete;
+   ~mpmc_queue();
+
+   //
+   // Insert
+   //
+   void push(const T & t) { QNode * p = new QNode(t);            link(p, p); }
+   void push(T && t)      { QNode * p = new QNode(std::move(t)); link(p, p); }
+   template <class Iterator>
+   void push_bulk(Iterator first, Iterator last);
+
+   //
+   // Remove
+   //
+   bool pop(T & t);
+   size_t pop_bulk(custom::vector<T> & out, size_t max);
+
+   //
+   // Status
+   //
+   bool empty() const;
+
+private:
+   /*************************************************
+    * QUEUE NODE
+    * Like Node<T> but singly linked through an atomic
+    * pointer. The value lives in raw storage so the
+    * dummy node at the head holds no T.
+    *************************************************/
+   struct QNode
+   {
+      QNode() : pNext(nullptr) {}
+      QNode(const T & t) : pNext(nullptr) { new ((void *)buffer) T(t); }
+      QNode(T && t)      : pNext(nullptr) { new ((void *)buffer) T(std::move(t)); }
+      T & data() { return *(T *)buffer; }
+
+      std::atomic<QNode *> pNext;             // next node, NULL at the tail
+      alignas(T) unsigned char buffer[sizeof(T)]; // the value, if any
+   };
+
+   static void deleteNode(void * p) { delete (QNode *)p; }
+   void link(QNode * pFirst, QNode * pLast);
+   bool pop(T & t, HazardPointers::Record * pRecord);
+
+   alignas(64) std::atomic<QNode *> pHead;   // dummy node; the front is pHead->pNext
+   alignas(64) std::atomic<QNode *> pTail;   // last node, or close to it
+};
+
+/***********************************************
+ * MPMC QUEUE :: CONSTRUCTOR
+ * Start with only the dummy node
+ **********************************************/
+template <class T>
+mpmc_queue <T> :: mpmc_queue()
+{
+   QNode * pDummy = new QNode;
+   pHead.store(pDummy);
+   pTail.store(pDummy);
+}
+
+/***********************************************
+ * MPMC QUEUE :: DESTRUCTOR
+ * Destroy the values still queued and free the nodes
+ **********************************************/
+template <class T>
+mpmc_queue <T> :: ~mpmc_queue()
+{
+   QNode * p = pHead.load();
+   QNode * pNext = p->pNext.load();
+   delete p;                     // the dummy holds no value
+   for (p = pNext; p; p = pNext)
+   {
+      pNext = p->pNext.load();
+      p->data().~T();
+      delete p;
+   }
+}
+
+/***********************************************
+ * MPMC QUEUE :: PUSH BULK
+ * Link the whole range together privately, then
+ * append it to the queue with a single CAS
+ *   COST   : O(k), one successful CAS
+ **********************************************/
+template <class T>
+template <class Iterator>
+void mpmc_queue <T> :: push_bulk(Iterator first, Iterator last)
+{
+   if (first == last)
+      return;
+
+   QNode * pFirst = new QNode(*first);
+   QNode * pLast = pFirst;
+   for (++first; first != last; ++first)
+   {
+      QNode * pNew = new QNode(*first);
+      pLast->pNext.store(pNew, std::memory_order_relaxed);
+      pLast = pNew;
+   }
+   link(pFirst, pLast);
+}
+
+/***********************************************
+ * MPMC QUEUE :: LINK
+ * Append the private chain pFirst..pLast at the tail.
+ * Anyone who sees the tail lagging swings it forward,
+ * so the tail catches up even if we stall.
+ **********************************************/
+template <class T>
+void mpmc_queue <T> :: link(QNode * pFirst, QNode * pLast)
+{
+   HazardPointers::Record * pRecord = HazardPointers::mine();
+   while (true)
+   {
+      QNode * pT = HazardPointers::protect(pRecord, 0, pTail);
+      QNode * pNext = pT->pNext.load();
+      if (pT != pTail.load())
+         continue;
+
+      // the tail is lagging: help it along
+      if (pNext != nullptr)
+      {
+         pTail.compare_exchange_strong(pT, pNext);
+         continue;
+      }
+
+      QNode * pExpected = nullptr;
+      if (pT->pNext.compare_exchange_strong(pExpected, pFirst))
+      {
+         pTail.compare_exchange_strong(pT, pLast);
+         break;
+      }
+   }
+   pRecord->hazard[0].store(nullptr);
+}
+
+/***********************************************
+ * MPMC QUEUE :: POP
+ * Take the value at the front of the queue
+ *   INPUT  : where to put the value
+ *   OUTPUT : false if the queue was empty
+ **********************************************/
+template <class T>
+bool mpmc_queue <T> :: pop(T & t)
+{
+   return pop(t, HazardPointers::mine());
+}
+
+template <class T>
+bool mpmc_queue <T> :: pop(T & t, HazardPointers::Record * pRecord)
+{
+   bool found = false;
+   while (true)
+   {
+      QNode * pH = HazardPointers::protect(pRecord, 0, pHead);
+      QNode * pT = pTail.load();
+      QNode * pNext = pH->pNext.load();
+      pRecord->hazard[1].store(pNext);
+      if (pH != pHead.load())
+         continue;
+
+      if (pNext == nullptr)
+         break;               // empty
+
+      // the tail is lagging behind the head: help it along
+      if (pH == pT)
+      {
+         pTail.compare_exchange_strong(pT, pNext);
+         continue;
+      }
+
+      // pNext becomes the new dummy. Only the thread whose CAS
+      // wins may touch its value, so it is safe to move it out
+      if (pHead.compare_exchange_strong(pH, pNext))
+      {
+         t = std::move(pNext->data());
+         pNext->data().~T();
+         pRecord->hazard[0].store(nullptr);
+         pRecord->hazard[1].store(nullptr);
+         HazardPointers::retire(pRecord, pH, deleteNode);
+         found = true;
+         break;
+      }
+   }
+   pRecord->hazard[0].store(nullptr);
+   pRecord->hazard[1].store(nullptr);
+   return found;
+}
+
+/***********************************************
+ * MPMC QUEUE :: POP BULK
+ * Take up to max values from the front, appending
+ * them to out. The hazard record is looked up once
+ * for the whole batch.
+ *   OUTPUT : how many values were taken
+ **********************************************/
+template <class T>
+size_t mpmc_queue <T> :: pop_bulk(custom::vector<T> & out, size_t max)
+{
+   HazardPointers::Record * pRecord = HazardPointers::mine();
+   size_t num = 0;
+   T t;
+   while (num < max && pop(t, pRecord))
+   {
+      out.push_back(std::move(t));
+      num++;
+   }
+   return num;
+}
+
+/***********************************************
+ * MPMC QUEUE :: EMPTY
+ * Whether there was nothing to pop. The dummy at the
+ * head is published first, as in pop(), since another
+ * consumer may retire it while we look at it
+ **********************************************/
+template <class T>
+bool mpmc_queue <T> :: empty() const
+{
+   HazardPointers::Record * pRecord = HazardPointers::mine();
+   QNode * pH = HazardPointers::protect(pRecord, 0, pHead);
+   bool isEmpty = pH->pNext.load() == nullptr;
+   pRecord->hazard[0].store(nullptr);
+   return isEmpty;
+}
+
+} // namespace custom
@@ -12,6 +12,7 @@
  *
  *    This will contain the class definition of:
  *        Node         : A class representing a Node
+ *        NodeCache    : A free list of Nodes to recycle
  *    Additionally, it will contain a few functions working on Node
  * Author
  *    <your names here>
@@ -21,6 +22,9 @@
 
 #include <cassert>     // for ASSERT
 #include <iostream>    // for NULL
+#include <functional>  // for std::less
+#include <utility>     // for std::pair
+#include "vector.h"    // for the slabs owned by a NodeCache
 
 /*************************************************
  * NODE
@@ -301,6 +305,128 @@ inline std::ostream & operator << (std::ostream & out, const Node <T> * pHead)
    return out;
 }
 
+/***********************************************
+ * MERGE NEXT
+ * Merge two sorted chains linked through pNext only,
+ * ignoring pPrev. On ties the node from pA comes first,
+ * so merging an earlier chain with a later one is stable.
+ *   COST   : O(n + m)
+ **********************************************/
+template <class T, class Compare>
+inline Node<T>* mergeNext(Node<T>* pA, Node<T>* pB, Compare & less)
+{
+   Node<T>* pHead = nullptr;
+   Node<T>** ppTail = &pHead;
+   while (pA != nullptr && pB != nullptr)
+   {
+      if (less(pB->data, pA->data))
+      {
+         *ppTail = pB;
+         pB = pB->pNext;
+      }
+      else
+      {
+         *ppTail = pA;
+         pA = pA->pNext;
+      }
+      ppTail = &(*ppTail)->pNext;
+   }
+   *ppTail = (pA != nullptr) ? pA : pB;
+   return pHead;
+}
+
+/***********************************************
+ * LINK PREVIOUS
+ * Rebuild the pPrev pointers of a chain that was
+ * relinked through pNext only
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+inline void linkPrev(Node<T>* pHead)
+{
+   Node<T>* pPrevious = nullptr;
+   for (Node<T>* p = pHead; p; p = p->pNext)
+   {
+      p->pPrev = pPrevious;
+      pPrevious = p;
+   }
+}
+
+/***********************************************
+ * MERGE
+ * Merge two sorted lists into one sorted list by
+ * relinking their nodes. Nothing is allocated or copied.
+ *   INPUT  : two sorted lists (heads) and, optionally, the
+ *            comparison they are sorted by
+ *   OUTPUT : the head of the merged list
+ *   COST   : O(n + m)
+ **********************************************/
+template <class T, class Compare>
+inline Node<T>* merge(Node<T>* pA, Node<T>* pB, Compare less)
+{
+   Node<T>* pHead = mergeNext(pA, pB, less);
+   linkPrev(pHead);
+   return pHead;
+}
+
+template <class T>
+inline Node<T>* merge(Node<T>* pA, Node<T>* pB)
+{
+   return merge(pA, pB, std::less<T>());
+}
+
+/***********************************************
+ * SORT
+ * Stable, in-place, bottom-up merge sort. Nodes are
+ * taken from the front one at a time and carried up
+ * through bins of 1, 2, 4, ... sorted nodes like a
+ * binary counter, so each merge works on runs that
+ * were touched recently. Only pNext is relinked while
+ * sorting; pPrev is rebuilt in one final pass.
+ *   INPUT  : the head of the list and, optionally, the
+ *            comparison to sort by
+ *   OUTPUT : pHead is the smallest node
+ *   COST   : O(n log n), no allocations
+ **********************************************/
+template <class T, class Compare>
+inline void sort(Node<T>* & pHead, Compare less)
+{
+   if (pHead == nullptr || pHead->pNext == nullptr)
+      return;
+
+   const size_t numBins = 64;          // enough for 2^64 nodes
+   Node<T>* bins[numBins] = {};        // bins[i] holds 2^i sorted nodes or NULL
+
+   while (pHead != nullptr)
+   {
+      Node<T>* pRun = pHead;
+      pHead = pHead->pNext;
+      pRun->pNext = nullptr;
+
+      // carry the run up while the bin is full. The bin holds earlier nodes
+      size_t i = 0;
+      for (; i < numBins - 1 && bins[i] != nullptr; i++)
+      {
+         pRun = mergeNext(bins[i], pRun, less);
+         bins[i] = nullptr;
+      }
+      bins[i] = (bins[i] == nullptr) ? pRun : mergeNext(bins[i], pRun, less);
+   }
+
+   // collapse the bins. Higher bins hold earlier nodes
+   for (size_t i = 0; i < numBins; i++)
+      if (bins[i] != nullptr)
+         pHead = mergeNext(bins[i], pHead, less);
+
+   linkPrev(pHead);
+}
+
+template <class T>
+inline void sort(Node<T>* & pHead)
+{
+   sort(pHead, std::less<T>());
+}
+
 /*****************************************************
  * FREE DATA
  * Free all the data currently in the linked list
@@ -320,3 +446,362 @@ inline void clear(Node <T> * & pHead)
 }
 
 
+/*************************************************
+ * NODE CACHE
+ * A free list of Nodes. The functions below that take
+ * a cache draw their nodes from it instead of calling
+ * new, and hand nodes back to it instead of calling
+ * delete, so a list that shrinks and grows again does
+ * not churn the heap. A recycled node keeps its old
+ * value until it is reused, which lets a std::string
+ * reuse its buffer when it is overwritten.
+ *
+ * reserve() allocates nodes in one contiguous slab. Slab
+ * nodes belong to the cache: a list holding them must be
+ * given back with clear(pHead, cache), never clear(pHead),
+ * and the cache must outlive every list using it.
+ *************************************************/
+template <class T>
+class NodeCache
+{
+public:
+   //
+   // Construct
+   //
+   NodeCache() : pFree(nullptr), numFree(0) {}
+   NodeCache(const NodeCache &) = delete;
+   NodeCache & operator = (const NodeCache &) = delete;
+   ~NodeCache();
+
+   //
+   // Acquire and release
+   //
+   Node<T> * acquire(const T & t);
+   Node<T> * acquire(T && t);
+   void release(Node<T> * pNode);
+   void release(Node<T> * pHead, Node<T> * pTail, size_t num);
+
+   //
+   // Capacity
+   //
+   void reserve(size_t num);
+   void shrink();
+   size_t size() const { return numFree; }
+
+private:
+   bool inSlab(const Node<T> * pNode) const;
+
+   Node<T> * pFree;                                   // singly linked through pNext
+   size_t numFree;                                    // nodes on the free list
+   custom::vector<std::pair<Node<T> *, size_t>> slabs; // blocks allocated by reserve()
+};
+
+/***********************************************
+ * NODE CACHE :: DESTRUCTOR
+ * Free the nodes on the free list that came from
+ * the heap, then free the slabs
+ **********************************************/
+template <class T>
+NodeCache <T> :: ~NodeCache()
+{
+   shrink();
+   for (size_t i = 0; i < slabs.size(); i++)
+      delete [] slabs[i].first;
+}
+
+/***********************************************
+ * NODE CACHE :: ACQUIRE
+ * Hand out an unlinked node holding t, reusing one
+ * from the free list when we can
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node<T> * NodeCache <T> :: acquire(const T & t)
+{
+   if (pFree == nullptr)
+      return new Node<T>(t);
+
+   Node<T> * pNode = pFree;
+   pFree = pFree->pNext;
+   numFree--;
+   pNode->data = t;
+   pNode->pNext = pNode->pPrev = nullptr;
+   return pNode;
+}
+
+template <class T>
+Node<T> * NodeCache <T> :: acquire(T && t)
+{
+   if (pFree == nullptr)
+      return new Node<T>(std::move(t));
+
+   Node<T> * pNode = pFree;
+   pFree = pFree->pNext;
+   numFree--;
+   pNode->data = std::move(t);
+   pNode->pNext = pNode->pPrev = nullptr;
+   return pNode;
+}
+
+/***********************************************
+ * NODE CACHE :: RELEASE
+ * Put a node, or a chain of num nodes from pHead to
+ * pTail, on the free list
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void NodeCache <T> :: release(Node<T> * pNode)
+{
+   if (pNode == nullptr)
+      return;
+   pNode->pNext = pFree;
+   pFree = pNode;
+   numFree++;
+}
+
+template <class T>
+void NodeCache <T> :: release(Node<T> * pHead, Node<T> * pTail, size_t num)
+{
+   if (pHead == nullptr)
+      return;
+   pTail->pNext = pFree;
+   pFree = pHead;
+   numFree += num;
+}
+
+/***********************************************
+ * NODE CACHE :: RESERVE
+ * Make sure at least num nodes are on the free list,
+ * allocating any shortfall as one contiguous slab. The
+ * slab is threaded so nodes come off in address order.
+ *   COST   : O(num)
+ **********************************************/
+template <class T>
+void NodeCache <T> :: reserve(size_t num)
+{
+   if (num <= numFree)
+      return;
+
+   size_t numNew = num - numFree;
+   Node<T> * pSlab = new Node<T>[numNew];
+   slabs.push_back(std::make_pair(pSlab, numNew));
+
+   for (size_t i = 0; i + 1 < numNew; i++)
+      pSlab[i].pNext = pSlab + i + 1;
+   release(pSlab, pSlab + numNew - 1, numNew);
+}
+
+/***********************************************
+ * NODE CACHE :: SHRINK
+ * Give the heap back every free node that did not
+ * come from a slab
+ *   COST   : O(n * slabs)
+ **********************************************/
+template <class T>
+void NodeCache <T> :: shrink()
+{
+   Node<T> * pKeep = nullptr;
+   size_t numKeep = 0;
+   while (pFree != nullptr)
+   {
+      Node<T> * pNode = pFree;
+      pFree = pFree->pNext;
+      if (inSlab(pNode))
+      {
+         pNode->pNext = pKeep;
+         pKeep = pNode;
+         numKeep++;
+      }
+      else
+         delete pNode;
+   }
+   pFree = pKeep;
+   numFree = numKeep;
+}
+
+/***********************************************
+ * NODE CACHE :: IN SLAB
+ * Was this node allocated by reserve()?
+ **********************************************/
+template <class T>
+bool NodeCache <T> :: inSlab(const Node<T> * pNode) const
+{
+   for (size_t i = 0; i < slabs.size(); i++)
+      if (pNode >= slabs[i].first && pNode < slabs[i].first + slabs[i].second)
+         return true;
+   return false;
+}
+
+/***********************************************
+ * COPY
+ * Copy the list from the pSource and return the new
+ * list, taking the nodes from the cache. Any shortfall
+ * is reserved up front so it comes from one contiguous block.
+ *   INPUT  : the list to be copied and the cache
+ *   OUTPUT : return the new list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+inline Node<T>* copy(const Node<T>* pSource, NodeCache<T> & cache)
+{
+   if (pSource == nullptr)
+      return nullptr;
+
+   cache.reserve(size(pSource));
+
+   Node<T>* pDestination = cache.acquire(pSource->data);
+   Node<T>* pDesCurrent = pDestination;
+   for (auto pSrcCurrent = pSource->pNext; pSrcCurrent; pSrcCurrent = pSrcCurrent->pNext)
+   {
+      Node<T>* newNode = cache.acquire(pSrcCurrent->data);
+      pDesCurrent->pNext = newNode;
+      newNode->pPrev = pDesCurrent;
+      pDesCurrent = newNode;
+   }
+
+   return pDestination;
+}
+
+/***********************************************
+ * ASSIGN
+ * Copy the values from pSource into pDestination
+ * reusing the nodes already in pDestination, then the
+ * nodes in the cache. Surplus nodes go to the cache.
+ *   INPUT  : the list to be copied and the cache
+ *   OUTPUT : pDestination holds the same values as pSource
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+inline void assign(Node <T> * & pDestination, const Node <T> * pSource, NodeCache<T> & cache)
+{
+   const Node<T>* pSrc = pSource;
+   Node<T>* pDes = pDestination;
+   Node<T>* pDesPrevious = nullptr;
+
+   // Step 1: Update values of existing nodes
+   while (pSrc != nullptr && pDes != nullptr)
+   {
+      pDes->data = pSrc->data;
+      pDesPrevious = pDes;
+      pDes = pDes->pNext;
+      pSrc = pSrc->pNext;
+   }
+
+   // Step 2: If source is longer, take more nodes from the cache
+   while (pSrc != nullptr)
+   {
+      Node<T>* newNode = cache.acquire(pSrc->data);
+      if (pDesPrevious != nullptr)
+      {
+         pDesPrevious->pNext = newNode;
+         newNode->pPrev = pDesPrevious;
+      }
+      else
+         pDestination = newNode;
+      pDesPrevious = newNode;
+      pSrc = pSrc->pNext;
+   }
+
+   // Step 3: If the destination is longer, give the rest to the cache
+   if (pDes != nullptr)
+   {
+      if (pDesPrevious != nullptr)
+         pDesPrevious->pNext = nullptr;
+      else
+         pDestination = nullptr;
+      clear(pDes, cache);
+   }
+}
+
+/**********************************************
+ * INSERT
+ * Insert a new node the the value in "t" into a linked
+ * list, taking the node from the cache
+ *   INPUT   : t - the value to be used for the new node
+ *             pCurrent - a pointer to the node we insert next to
+ *             after - whether we will be inserting after
+ *             cache - where the node comes from
+ *   OUTPUT  : return the newly inserted item
+ *   COST    : O(1)
+ **********************************************/
+template <class T>
+inline Node <T> * insert(Node <T> * pCurrent,
+                  const T & t,
+                  bool after,
+                  NodeCache<T> & cache)
+{
+   Node<T>* pNew = cache.acquire(t);
+   if (pCurrent == nullptr)
+      return pNew;
+
+   if (after)
+   {
+      pNew->pPrev = pCurrent;
+      pNew->pNext = pCurrent->pNext;
+      if (pCurrent->pNext != nullptr)
+         pCurrent->pNext->pPrev = pNew;
+      pCurrent->pNext = pNew;
+   }
+   else
+   {
+      pNew->pNext = pCurrent;
+      pNew->pPrev = pCurrent->pPrev;
+      if (pCurrent->pPrev != nullptr)
+         pCurrent->pPrev->pNext = pNew;
+      pCurrent->pPrev = pNew;
+   }
+   return pNew;
+}
+
+/***********************************************
+ * REMOVE
+ * Remove the node pRemove from the linked list and
+ * give it to the cache
+ *   INPUT  : the node to be removed and the cache
+ *   OUTPUT : the pointer to a neighboring node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+inline Node <T> * remove(Node <T> * pRemove, NodeCache<T> & cache)
+{
+   Node<T>* pReturn = nullptr;
+   if (pRemove != nullptr)
+   {
+      if (pRemove->pNext != nullptr)
+      {
+         pRemove->pNext->pPrev = pRemove->pPrev;
+         pReturn = pRemove->pNext;
+      }
+      if (pRemove->pPrev != nullptr)
+      {
+         pRemove->pPrev->pNext = pRemove->pNext;
+         pReturn = pRemove->pPrev;
+      }
+      cache.release(pRemove);
+   }
+   return pReturn;
+}
+
+/*****************************************************
+ * FREE DATA
+ * Give all the nodes in the linked list to the cache
+ *   INPUT   : pointer to the head of the linked list
+ *   OUTPUT  : pHead set to NULL
+ *   COST    : O(n), but no calls to delete
+ ****************************************************/
+template <class T>
+inline void clear(Node <T> * & pHead, NodeCache<T> & cache)
+{
+   if (pHead == nullptr)
+      return;
+
+   Node<T>* pTail = pHead;
+   size_t num = 1;
+   while (pTail->pNext != nullptr)
+   {
+      pTail = pTail->pNext;
+      num++;
+   }
+   cache.release(pHead, pTail, num);
+   pHead = nullptr;
+}
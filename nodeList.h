@@ -0,0 +1,424 @@
+/***********************************************************************
+ * Header:
+ *    NODE LIST
+ * Summary:
+ *    A list header over the Nodes in node.h. It remembers the head, the
+ *    tail, and the number of nodes, so size() is O(1) and whole ranges of
+ *    nodes can be moved from one list to another by relinking a handful
+ *    of pointers instead of copying them through copy() or assign().
+ *
+ *    This will contain the class definition of:
+ *        NodeList     : The head, tail, and size of a Node list
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // for ASSERT
+#include <functional>  // for std::less
+#include <utility>     // for std::swap
+#include "node.h"      // for Node and the functions that work on it
+
+/*************************************************
+ * NODE LIST
+ * Owns a chain of Nodes. Every splice and split below
+ * only relinks pNext and pPrev: no node is allocated,
+ * freed, or copied, and pointers to nodes stay valid
+ * as the nodes move between lists.
+ *************************************************/
+template <class T>
+class NodeList
+{
+public:
+   //
+   // Construct
+   //
+   NodeList() : pHead(nullptr), pTail(nullptr), numElements(0) {}
+   NodeList(const NodeList & rhs);
+   NodeList(NodeList && rhs) : pHead(nullptr), pTail(nullptr), numElements(0)
+   {
+      swap(rhs);
+   }
+   ~NodeList() { clear(); }
+
+   //
+   // Assign
+   //
+   NodeList & operator = (const NodeList & rhs);
+   NodeList & operator = (NodeList && rhs)
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   void swap(NodeList & rhs)
+   {
+      std::swap(pHead, rhs.pHead);
+      std::swap(pTail, rhs.pTail);
+      std::swap(numElements, rhs.numElements);
+   }
+
+   //
+   // Access
+   //
+   Node<T> * head() const { return pHead; }
+   Node<T> * tail() const { return pTail; }
+         T & front()       { assert(pHead); return pHead->data; }
+   const T & front() const { assert(pHead); return pHead->data; }
+         T & back()        { assert(pTail); return pTail->data; }
+   const T & back()  const { assert(pTail); return pTail->data; }
+
+   //
+   // Insert
+   //
+   Node<T> * push_front(const T & t);
+   Node<T> * push_back (const T & t);
+
+   //
+   // Remove
+   //
+   void pop_front();
+   void pop_back();
+   Node<T> * erase(Node<T> * pNode);
+   void clear();
+
+   //
+   // Relink
+   //
+   void splice(Node<T> * pPos, NodeList & rhs, Node<T> * pNode);
+   void splice(Node<T> * pPos, NodeList & rhs, Node<T> * pFirst, Node<T> * pLast, size_t num);
+   void splice(Node<T> * pPos, NodeList & rhs, Node<T> * pFirst, Node<T> * pLast);
+   void splice(Node<T> * pPos, NodeList & rhs);
+   void concat(NodeList & rhs) { splice(nullptr, rhs); }
+   NodeList split_at(size_t index);
+   template <class Compare>
+   void merge(NodeList & rhs, Compare less);
+   void merge(NodeList & rhs) { merge(rhs, std::less<T>()); }
+   template <class Compare>
+   void sort(Compare less);
+   void sort() { sort(std::less<T>()); }
+
+   //
+   // Status
+   //
+   size_t size()  const { return numElements;      }
+   bool   empty() const { return numElements == 0; }
+
+private:
+   void findTail();
+   void unlink(Node<T> * pFirst, Node<T> * pLast, size_t num);
+   void link(Node<T> * pPos, Node<T> * pFirst, Node<T> * pLast, size_t num);
+
+   Node<T> * pHead;       // first node, NULL when empty
+   Node<T> * pTail;       // last node, NULL when empty
+   size_t numElements;    // number of nodes from pHead to pTail
+};
+
+/***********************************************
+ * NODE LIST :: COPY CONSTRUCTOR
+ * Copy every node of rhs
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+NodeList <T> :: NodeList(const NodeList & rhs) : pHead(nullptr), pTail(nullptr), numElements(0)
+{
+   *this = rhs;
+}
+
+/***********************************************
+ * NODE LIST :: ASSIGN
+ * Copy the values of rhs, reusing our nodes where possible
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+NodeList <T> & NodeList <T> :: operator = (const NodeList & rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   assign(pHead, (const Node<T> *)rhs.pHead);
+   if (pHead != nullptr)
+      pHead->pPrev = nullptr;
+   numElements = rhs.numElements;
+
+   // assign() does not report the tail, so find it
+   findTail();
+   return *this;
+}
+
+/***********************************************
+ * NODE LIST :: PUSH FRONT and PUSH BACK
+ * Add a new node holding t to either end
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node<T> * NodeList <T> :: push_front(const T & t)
+{
+   Node<T> * pNew = new Node<T>(t);
+   link(pHead, pNew, pNew, 1);
+   return pNew;
+}
+
+template <class T>
+Node<T> * NodeList <T> :: push_back(const T & t)
+{
+   Node<T> * pNew = new Node<T>(t);
+   link(nullptr, pNew, pNew, 1);
+   return pNew;
+}
+
+/***********************************************
+ * NODE LIST :: POP FRONT and POP BACK
+ * Remove the node at either end
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void NodeList <T> :: pop_front()
+{
+   if (pHead != nullptr)
+      erase(pHead);
+}
+
+template <class T>
+void NodeList <T> :: pop_back()
+{
+   if (pTail != nullptr)
+      erase(pTail);
+}
+
+/***********************************************
+ * NODE LIST :: ERASE
+ * Remove and free one node of this list
+ *   INPUT  : a node in this list
+ *   OUTPUT : the node that followed it
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node<T> * NodeList <T> :: erase(Node<T> * pNode)
+{
+   assert(pNode != nullptr);
+   Node<T> * pNext = pNode->pNext;
+   unlink(pNode, pNode, 1);
+   delete pNode;
+   return pNext;
+}
+
+/***********************************************
+ * NODE LIST :: CLEAR
+ * Free every node
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void NodeList <T> :: clear()
+{
+   ::clear(pHead);
+   pTail = nullptr;
+   numElements = 0;
+}
+
+/***********************************************
+ * NODE LIST :: SPLICE
+ * Move nodes out of rhs (which may be this list) and
+ * link them in immediately before pPos. A NULL pPos
+ * means the end of this list.
+ *    pNode         : move one node
+ *    pFirst..pLast : move a range, both ends included.
+ *                    Pass num, the length of the range,
+ *                    to keep the splice O(1); otherwise
+ *                    it is counted in O(k)
+ *    (nothing)     : move all of rhs
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void NodeList <T> :: splice(Node<T> * pPos, NodeList & rhs, Node<T> * pNode)
+{
+   assert(pNode != nullptr);
+   if (pNode == pPos)
+      return;
+   rhs.unlink(pNode, pNode, 1);
+   link(pPos, pNode, pNode, 1);
+}
+
+template <class T>
+void NodeList <T> :: splice(Node<T> * pPos, NodeList & rhs,
+                            Node<T> * pFirst, Node<T> * pLast, size_t num)
+{
+   assert(pFirst != nullptr && pLast != nullptr && num > 0);
+   rhs.unlink(pFirst, pLast, num);
+   link(pPos, pFirst, pLast, num);
+}
+
+template <class T>
+void NodeList <T> :: splice(Node<T> * pPos, NodeList & rhs,
+                            Node<T> * pFirst, Node<T> * pLast)
+{
+   size_t num = 1;
+   for (Node<T> * p = pFirst; p != pLast; p = p->pNext)
+   {
+      assert(p != nullptr);
+      num++;
+   }
+   splice(pPos, rhs, pFirst, pLast, num);
+}
+
+template <class T>
+void NodeList <T> :: splice(Node<T> * pPos, NodeList & rhs)
+{
+   if (&rhs == this || rhs.empty())
+      return;
+   splice(pPos, rhs, rhs.pHead, rhs.pTail, rhs.numElements);
+}
+
+/***********************************************
+ * NODE LIST :: SPLIT AT
+ * Cut this list in two: the first index nodes stay here
+ * and the rest are returned as a new list. The cut point
+ * is found from whichever end is closer.
+ *   INPUT  : how many nodes to keep, 0..size()
+ *   OUTPUT : the nodes after the first index
+ *   COST   : O(min(index, n - index))
+ **********************************************/
+template <class T>
+NodeList <T> NodeList <T> :: split_at(size_t index)
+{
+   assert(index <= numElements);
+   NodeList<T> rest;
+   if (index == numElements)
+      return rest;
+
+   Node<T> * pFirst;
+   if (index < numElements - index)
+   {
+      pFirst = pHead;
+      for (size_t i = 0; i < index; i++)
+         pFirst = pFirst->pNext;
+   }
+   else
+   {
+      pFirst = pTail;
+      for (size_t i = numElements - 1; i > index; i--)
+         pFirst = pFirst->pPrev;
+   }
+
+   rest.splice(nullptr, *this, pFirst, pTail, numElements - index);
+   return rest;
+}
+
+/***********************************************
+ * NODE LIST :: MERGE
+ * Move every node of rhs into this list, both already
+ * sorted by less, keeping the result sorted
+ *   COST   : O(n + m), no allocations
+ **********************************************/
+template <class T>
+template <class Compare>
+void NodeList <T> :: merge(NodeList & rhs, Compare less)
+{
+   if (&rhs == this)
+      return;
+   pHead = ::merge(pHead, rhs.pHead, less);
+   numElements += rhs.numElements;
+   rhs.pHead = rhs.pTail = nullptr;
+   rhs.numElements = 0;
+   findTail();
+}
+
+/***********************************************
+ * NODE LIST :: SORT
+ * Stable in-place merge sort, see sort() in node.h
+ *   COST   : O(n log n), no allocations
+ **********************************************/
+template <class T>
+template <class Compare>
+void NodeList <T> :: sort(Compare less)
+{
+   ::sort(pHead, less);
+   findTail();
+}
+
+/***********************************************
+ * NODE LIST :: FIND TAIL
+ * Reset pTail after the nodes were relinked
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void NodeList <T> :: findTail()
+{
+   pTail = pHead;
+   while (pTail != nullptr && pTail->pNext != nullptr)
+      pTail = pTail->pNext;
+}
+
+/***********************************************
+ * NODE LIST :: UNLINK
+ * Detach pFirst..pLast (num nodes) from this list,
+ * leaving the range's outer pointers NULL
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void NodeList <T> :: unlink(Node<T> * pFirst, Node<T> * pLast, size_t num)
+{
+   assert(num <= numElements);
+   if (pFirst->pPrev != nullptr)
+      pFirst->pPrev->pNext = pLast->pNext;
+   else
+      pHead = pLast->pNext;
+
+   if (pLast->pNext != nullptr)
+      pLast->pNext->pPrev = pFirst->pPrev;
+   else
+      pTail = pFirst->pPrev;
+
+   pFirst->pPrev = nullptr;
+   pLast->pNext = nullptr;
+   numElements -= num;
+}
+
+/***********************************************
+ * NODE LIST :: LINK
+ * Attach the detached chain pFirst..pLast (num nodes)
+ * immediately before pPos, or at the end if pPos is NULL
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void NodeList <T> :: link(Node<T> * pPos, Node<T> * pFirst, Node<T> * pLast, size_t num)
+{
+   Node<T> * pBefore = pPos ? pPos->pPrev : pTail;
+
+   pFirst->pPrev = pBefore;
+   if (pBefore != nullptr)
+      pBefore->pNext = pFirst;
+   else
+      pHead = pFirst;
+
+   pLast->pNext = pPos;
+   if (pPos != nullptr)
+      pPos->pPrev = pLast;
+   else
+      pTail = pLast;
+
+   numElements += num;
+}
+
+/***********************************************
+ * SIZE
+ * The number of nodes in the list
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+inline size_t size(const NodeList<T> & list)
+{
+   return list.size();
+}
+
+/***********************************************
+ * DISPLAY
+ * Display all the items in the list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+inline std::ostream & operator << (std::ostream & out, const NodeList<T> & list)
+{
+   return out << (const Node<T> *)list.head();
+}
@@ -0,0 +1,842 @@
+/***********************************************************************
+ * Header:
+ *    PERSISTENT BST
+ * Summary:
+ *    A red-black tree whose nodes are shared between copies. Copying the
+ *    tree, or taking a snapshot() of it, costs O(1): the copy simply holds
+ *    a reference to the same root. An insert or erase afterwards copies
+ *    only the nodes on the path from the root to the change, O(log n) of
+ *    them, and leaves every other subtree shared. Nodes are reference
+ *    counted and freed when the last tree using them lets go.
+ *
+ *    Because a node may sit in several trees at once it cannot know its
+ *    parent, so unlike BST there are no pParent pointers: iterators carry
+ *    the path from the root, and rebalancing follows Okasaki (insert) and
+ *    Kahrs (erase), rebuilding the path on the way back up.
+ *
+ *    This will contain the class definition of:
+ *        PersistentBST           : A copy-on-write binary search tree
+ *        PersistentBST::iterator : An iterator through PersistentBST
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include <cstddef>     // for size_t
+#include <initializer_list>
+#include <utility>     // for std::pair
+
+class TestPersistentBST; // forward declaration for unit tests
+
+namespace custom
+{
+
+/*****************************************************************
+ * PERSISTENT BINARY SEARCH TREE
+ * A tree is a root and a count. Trees that came from one another
+ * share every node neither has changed since.
+ *
+ * One tree object may not be changed by two threads at once, but a
+ * snapshot handed to another thread may be read there while the
+ * original keeps changing: a shared node is never modified.
+ *****************************************************************/
+template <typename T>
+class PersistentBST
+{
+   friend class ::TestPersistentBST; // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+
+   PersistentBST() : root(nullptr), numElements(0) {}
+   PersistentBST(const PersistentBST &  rhs);
+   PersistentBST(      PersistentBST && rhs);
+   PersistentBST(const std::initializer_list<T>& il);
+   ~PersistentBST() { release(root); }
+
+   //
+   // Assign
+   //
+
+   PersistentBST & operator = (const PersistentBST &  rhs);
+   PersistentBST & operator = (      PersistentBST && rhs);
+   PersistentBST & operator = (const std::initializer_list<T>& il);
+   void swap(PersistentBST & rhs);
+   PersistentBST snapshot() const { return *this; }
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   iterator   begin() const;
+   iterator   end()   const { return iterator(root); }
+
+   //
+   // Access
+   //
+
+   iterator find(const T& t) const;
+
+   //
+   // Insert
+   //
+
+   std::pair<iterator, bool> insert(const T&  t, bool keepUnique = false);
+   std::pair<iterator, bool> insert(      T&& t, bool keepUnique = false);
+
+   //
+   // Remove
+   //
+
+   iterator erase(iterator& it);
+   size_t   erase(const T& t);
+   void     clear() noexcept;
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return size() == 0; }
+   size_t size()  const noexcept { return numElements;   }
+
+private:
+
+   class PNode;
+
+   // every PNode * passed to or returned from these carries one reference
+   template <class U>
+   static PNode * insert(PNode * pNode, U && t, PNode *& pNew);
+   static PNode * erase(PNode * pNode, const iterator & it, size_t depth);
+   static PNode * unpack(PNode * pNode, PNode *& pLeft, PNode *& pRight);
+   static PNode * make(PNode * pShell, bool isRed, PNode * pLeft, PNode * pRight);
+   static PNode * paint(PNode * pNode, bool isRed);
+   static PNode * balance(PNode * pLeft, PNode * pShell, PNode * pRight);
+   static PNode * balanceLeft(PNode * pLeft, PNode * pShell, PNode * pRight);
+   static PNode * balanceRight(PNode * pLeft, PNode * pShell, PNode * pRight);
+   static PNode * append(PNode * pLeft, PNode * pRight);
+   static PNode * acquire(PNode * pNode);
+   static void    release(PNode * pNode);
+   static bool    isRed  (const PNode * pNode) { return pNode != nullptr &&  pNode->isRed; }
+   static bool    isBlack(const PNode * pNode) { return pNode != nullptr && !pNode->isRed; }
+   iterator locate(const PNode * pNode) const;
+
+   PNode * root;              // root node, shared with other trees
+   size_t numElements;        // number of elements currently in the tree
+};
+
+/*****************************************************************
+ * PERSISTENT NODE
+ * A BNode without a parent, plus the number of trees and
+ * nodes that refer to it
+ *****************************************************************/
+template <typename T>
+class PersistentBST <T> :: PNode
+{
+public:
+   PNode(const T &  t) : data(t),            pLeft(nullptr), pRight(nullptr), isRed(true), refs(1) {}
+   PNode(      T && t) : data(std::move(t)), pLeft(nullptr), pRight(nullptr), isRed(true), refs(1) {}
+
+   T data;                    // actual data stored in the PNode
+   PNode * pLeft;             // left child - smaller
+   PNode * pRight;            // right child - larger
+   bool isRed;                // red-black balancing stuff
+   std::atomic<size_t> refs;  // trees and parents holding this node
+};
+
+/**********************************************************
+ * PERSISTENT BST ITERATOR
+ * Forward and reverse iterator through a PersistentBST. It
+ * keeps the path from the root to the current node, since
+ * the nodes do not know their parents, in place so that
+ * find() does not allocate. Changing the tree
+ * invalidates its iterators; iterators into a snapshot stay
+ * valid while the snapshot lives.
+ *********************************************************/
+template <typename T>
+class PersistentBST <T> :: iterator
+{
+   friend class ::TestPersistentBST; // give unit tests access to the privates
+   friend class PersistentBST <T>;
+public:
+   // constructors and assignment
+   iterator(const PNode * pRoot = nullptr) : pRoot(pRoot), depth(0) {}
+   iterator(const iterator & rhs) { *this = rhs; }
+   iterator & operator = (const iterator & rhs)
+   {
+      pRoot = rhs.pRoot;
+      depth = rhs.depth;
+      for (size_t i = 0; i < depth; i++)
+         path[i] = rhs.path[i];
+      return *this;
+   }
+
+   // compare
+   bool operator == (const iterator & rhs) const { return node() == rhs.node(); }
+   bool operator != (const iterator & rhs) const { return node() != rhs.node(); }
+
+   // de-reference. Cannot change because it will invalidate the tree
+   const T & operator * () const { return node()->data; }
+
+   // increment and decrement
+   iterator & operator ++ ();
+   iterator   operator ++ (int postfix)
+   {
+      iterator temp = *this;
+      ++*this;
+      return temp;
+   }
+   iterator & operator -- ();
+   iterator   operator -- (int postfix)
+   {
+      iterator temp = *this;
+      --*this;
+      return temp;
+   }
+
+private:
+   // a red-black tree of n is at most 2 log(n + 1) tall, so
+   // this holds the path in any tree of up to 2^32 elements
+   static const size_t maxDepth = 64;
+
+   const PNode * node() const { return depth == 0 ? nullptr : path[depth - 1]; }
+   void push(const PNode * p) { assert(depth < maxDepth); path[depth++] = p; }
+   void leftmost (const PNode * p) { for (; p; p = p->pLeft)  push(p); }
+   void rightmost(const PNode * p) { for (; p; p = p->pRight) push(p); }
+
+   const PNode * pRoot;              // root of the tree, for --end()
+   const PNode * path[maxDepth];     // root to current node
+   size_t depth;                     // length of path, 0 at end()
+};
+
+
+/*********************************************
+ *********************************************
+ *********************************************
+ *************** PERSISTENT BST **************
+ *********************************************
+ *********************************************
+ *********************************************/
+
+
+/*********************************************
+ * PERSISTENT BST :: COPY CONSTRUCTOR
+ * Share the nodes of rhs
+ *   COST   : O(1)
+ ********************************************/
+template <typename T>
+PersistentBST <T> :: PersistentBST(const PersistentBST <T> & rhs) :
+   root(acquire(rhs.root)), numElements(rhs.numElements)
+{
+}
+
+/*********************************************
+ * PERSISTENT BST :: MOVE CONSTRUCTOR
+ ********************************************/
+template <typename T>
+PersistentBST <T> :: PersistentBST(PersistentBST <T> && rhs) :
+   root(rhs.root), numElements(rhs.numElements)
+{
+   rhs.root = nullptr;
+   rhs.numElements = 0;
+}
+
+/*********************************************
+ * PERSISTENT BST :: INITIALIZER LIST CONSTRUCTOR
+ ********************************************/
+template <typename T>
+PersistentBST <T> :: PersistentBST(const std::initializer_list<T>& il) :
+   root(nullptr), numElements(0)
+{
+   *this = il;
+}
+
+/*********************************************
+ * PERSISTENT BST :: ASSIGNMENT OPERATOR
+ * Share the nodes of rhs, letting go of ours
+ *   COST   : O(1), plus freeing nodes only we held
+ ********************************************/
+template <typename T>
+PersistentBST <T> & PersistentBST <T> :: operator = (const PersistentBST <T> & rhs)
+{
+   PNode * pOld = root;
+   root = acquire(rhs.root);
+   numElements = rhs.numElements;
+   release(pOld);
+   return *this;
+}
+
+/*********************************************
+ * PERSISTENT BST :: ASSIGN-MOVE OPERATOR
+ ********************************************/
+template <typename T>
+PersistentBST <T> & PersistentBST <T> :: operator = (PersistentBST <T> && rhs)
+{
+   if (this == &rhs)
+      return *this;
+   clear();
+   swap(rhs);
+   return *this;
+}
+
+/*********************************************
+ * PERSISTENT BST :: ASSIGNMENT OPERATOR with INITIALIZATION LIST
+ ********************************************/
+template <typename T>
+PersistentBST <T> & PersistentBST <T> :: operator = (const std::initializer_list<T>& il)
+{
+   clear();
+   for (const T & value : il)
+      insert(value);
+   return *this;
+}
+
+/*********************************************
+ * PERSISTENT BST :: SWAP
+ ********************************************/
+template <typename T>
+void PersistentBST <T> :: swap(PersistentBST <T> & rhs)
+{
+   std::swap(root, rhs.root);
+   std::swap(numElements, rhs.numElements);
+}
+
+/*********************************************
+ * PERSISTENT BST :: BEGIN
+ * The smallest element
+ ********************************************/
+template <typename T>
+typename PersistentBST <T> :: iterator PersistentBST <T> :: begin() const
+{
+   iterator it(root);
+   it.leftmost(root);
+   return it;
+}
+
+/*****************************************************
+ * PERSISTENT BST :: FIND
+ * Return an element equal to t. Like BST, with duplicates
+ * this is the first one met on the way down
+ *   COST   : O(log n)
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: iterator PersistentBST <T> :: find(const T & t) const
+{
+   // descend without recording the path first: storing it on the
+   // way down keeps the compiler from overlapping the loads, and
+   // walking the path a second time only touches cached nodes
+   size_t depth = 0;
+   const PNode * pFound = root;
+   while (pFound != nullptr && !(t == pFound->data))
+   {
+      pFound = (t < pFound->data) ? pFound->pLeft : pFound->pRight;
+      depth++;
+   }
+
+   iterator it(root);
+   if (pFound == nullptr)
+      return it;
+   const PNode * p = root;
+   for (; depth > 0; depth--)
+   {
+      it.push(p);
+      p = (t < p->data) ? p->pLeft : p->pRight;
+   }
+   it.push(pFound);
+   return it;
+}
+
+/*****************************************************
+ * PERSISTENT BST :: INSERT
+ * Insert t, copying the nodes on the path to it that
+ * are shared with another tree. With keepUnique set,
+ * an element already present is returned instead.
+ *   COST   : O(log n)
+ ****************************************************/
+template <typename T>
+std::pair<typename PersistentBST <T> :: iterator, bool> PersistentBST <T> :: insert(const T & t, bool keepUnique)
+{
+   if (keepUnique)
+   {
+      iterator it = find(t);
+      if (it != end())
+         return std::make_pair(it, false);
+   }
+
+   PNode * pNew = nullptr;
+   root = paint(insert(root, t, pNew), false /*isRed*/);
+   numElements++;
+   return std::make_pair(locate(pNew), true);
+}
+
+template <typename T>
+std::pair<typename PersistentBST <T> :: iterator, bool> PersistentBST <T> :: insert(T && t, bool keepUnique)
+{
+   if (keepUnique)
+   {
+      iterator it = find(t);
+      if (it != end())
+         return std::make_pair(it, false);
+   }
+
+   PNode * pNew = nullptr;
+   root = paint(insert(root, std::move(t), pNew), false /*isRed*/);
+   numElements++;
+   return std::make_pair(locate(pNew), true);
+}
+
+/*****************************************************
+ * PERSISTENT BST :: INSERT (subtree)
+ * Okasaki's insert: put a red leaf at the bottom and
+ * rebalance every black node on the way back up.
+ * Duplicates go after their equals.
+ *   INPUT  : the subtree, the value
+ *   OUTPUT : the new subtree; pNew is the new node
+ ****************************************************/
+template <typename T>
+template <class U>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: insert(PNode * pNode, U && t, PNode *& pNew)
+{
+   if (pNode == nullptr)
+      return pNew = new PNode(std::forward<U>(t));
+
+   bool goLeft = t < pNode->data;
+   PNode * pLeft;
+   PNode * pRight;
+   PNode * pShell = unpack(pNode, pLeft, pRight);
+
+   if (goLeft)
+      pLeft = insert(pLeft, std::forward<U>(t), pNew);
+   else
+      pRight = insert(pRight, std::forward<U>(t), pNew);
+
+   if (pShell->isRed)
+      return make(pShell, true /*isRed*/, pLeft, pRight);
+   return balance(pLeft, pShell, pRight);
+}
+
+/*************************************************
+ * PERSISTENT BST :: ERASE
+ * Remove the element the iterator refers to
+ *   OUTPUT : the element that followed it
+ *   COST   : O(log n)
+ ************************************************/
+template <typename T>
+typename PersistentBST <T> :: iterator PersistentBST <T> :: erase(iterator & it)
+{
+   if (it.depth == 0)
+      return end();
+
+   // the path to the next element changes as the tree is rebuilt, so
+   // find it again afterwards by value. Count the equal elements up to
+   // and including this one to pick the right one among duplicates
+   iterator itNext = it;
+   ++itNext;
+   const PNode * pNext = itNext.node();
+   size_t numEqual = 0;
+   if (pNext != nullptr && !(it.node()->data < pNext->data))
+      for (iterator itPrev = it; itPrev != end() && !(*itPrev < pNext->data); --itPrev)
+         numEqual++;
+
+   // hold on to pNext so its data can still be read afterwards
+   PNode * pHold = acquire(const_cast<PNode *>(pNext));
+   root = paint(erase(root, it, 0), false /*isRed*/);
+   numElements--;
+
+   if (pHold == nullptr)
+      return end();
+   itNext = find(pHold->data);
+   while (true)
+   {
+      iterator itPrev = itNext;
+      if (--itPrev == end() || *itPrev < pHold->data)
+         break;
+      itNext = itPrev;
+   }
+   for (size_t i = 1; i < numEqual; i++)
+      ++itNext;
+   release(pHold);
+   return itNext;
+}
+
+/*************************************************
+ * PERSISTENT BST :: ERASE by value
+ * Remove one element equal to t
+ *   OUTPUT : how many were removed, 0 or 1
+ *   COST   : O(log n)
+ ************************************************/
+template <typename T>
+size_t PersistentBST <T> :: erase(const T & t)
+{
+   iterator it = find(t);
+   if (it == end())
+      return 0;
+   root = paint(erase(root, it, 0), false /*isRed*/);
+   numElements--;
+   return 1;
+}
+
+/*************************************************
+ * PERSISTENT BST :: ERASE (subtree)
+ * Kahrs' delete, following the iterator's path down
+ * instead of comparing so duplicates are handled
+ *   INPUT  : the subtree at it.path[depth]
+ *   OUTPUT : the subtree without that node
+ ************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: erase(PNode * pNode, const iterator & it, size_t depth)
+{
+   assert(pNode == it.path[depth]);
+   bool isTarget = depth + 1 == it.depth;
+   bool goLeft = !isTarget && it.path[depth + 1] == pNode->pLeft;
+   bool leftBlack  = isBlack(pNode->pLeft);
+   bool rightBlack = isBlack(pNode->pRight);
+
+   PNode * pLeft;
+   PNode * pRight;
+   PNode * pShell = unpack(pNode, pLeft, pRight);
+
+   if (isTarget)
+   {
+      release(pShell);
+      return append(pLeft, pRight);
+   }
+
+   if (goLeft)
+   {
+      pLeft = erase(pLeft, it, depth + 1);
+      if (leftBlack)
+         return balanceLeft(pLeft, pShell, pRight);
+   }
+   else
+   {
+      pRight = erase(pRight, it, depth + 1);
+      if (rightBlack)
+         return balanceRight(pLeft, pShell, pRight);
+   }
+   return make(pShell, true /*isRed*/, pLeft, pRight);
+}
+
+/*****************************************************
+ * PERSISTENT BST :: CLEAR
+ * Let go of every node. Nodes shared with another
+ * tree live on there
+ ****************************************************/
+template <typename T>
+void PersistentBST <T> :: clear() noexcept
+{
+   release(root);
+   root = nullptr;
+   numElements = 0;
+}
+
+/*****************************************************
+ * PERSISTENT BST :: LOCATE
+ * The iterator for one particular node. Among equal
+ * elements we stop at the node itself, and equal
+ * elements that are not it are to its left
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: iterator PersistentBST <T> :: locate(const PNode * pNode) const
+{
+   iterator it(root);
+   for (const PNode * p = root; p; )
+   {
+      it.push(p);
+      if (p == pNode)
+         break;
+      p = (pNode->data < p->data) ? p->pLeft : p->pRight;
+   }
+   return it;
+}
+
+/*****************************************************
+ * PERSISTENT BST :: UNPACK
+ * Take a node apart into its children and a shell
+ * holding its value and color. If no one else holds
+ * the node, it becomes the shell and is reused;
+ * otherwise the shell is a copy and the children
+ * gain a reference
+ *   COST   : O(1)
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: unpack(PNode * pNode, PNode *& pLeft, PNode *& pRight)
+{
+   if (pNode->refs.load(std::memory_order_acquire) == 1)
+   {
+      pLeft  = pNode->pLeft;
+      pRight = pNode->pRight;
+      pNode->pLeft = pNode->pRight = nullptr;
+      return pNode;
+   }
+
+   pLeft  = acquire(pNode->pLeft);
+   pRight = acquire(pNode->pRight);
+   PNode * pShell = new PNode(pNode->data);
+   pShell->isRed = pNode->isRed;
+   release(pNode);
+   return pShell;
+}
+
+/*****************************************************
+ * PERSISTENT BST :: MAKE
+ * Fill a shell from unpack() with a color and children
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: make(PNode * pShell, bool isRed, PNode * pLeft, PNode * pRight)
+{
+   pShell->isRed  = isRed;
+   pShell->pLeft  = pLeft;
+   pShell->pRight = pRight;
+   return pShell;
+}
+
+/*****************************************************
+ * PERSISTENT BST :: PAINT
+ * Recolor a node, copying it if it is shared
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: paint(PNode * pNode, bool isRed)
+{
+   if (pNode == nullptr || pNode->isRed == isRed)
+      return pNode;
+   PNode * pLeft;
+   PNode * pRight;
+   PNode * pShell = unpack(pNode, pLeft, pRight);
+   return make(pShell, isRed, pLeft, pRight);
+}
+
+/*****************************************************
+ * PERSISTENT BST :: BALANCE
+ * Build a black node over the two subtrees, first
+ * fixing a red child with a red child. The four
+ * shapes all become a red node with two black children
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: balance(PNode * pLeft, PNode * pShell, PNode * pRight)
+{
+   PNode * a;
+   PNode * b;
+   PNode * c;
+   PNode * d;
+
+   // both children red: push the red up
+   if (isRed(pLeft) && isRed(pRight))
+      return make(pShell, true /*isRed*/,
+                  paint(pLeft, false /*isRed*/), paint(pRight, false /*isRed*/));
+
+   if (isRed(pLeft) && isRed(pLeft->pLeft))
+   {
+      // ((a x b) y c) z d
+      PNode * pY = unpack(pLeft, a, c);
+      PNode * pX = unpack(a, a, b);
+      return make(pY, true, make(pX, false, a, b), make(pShell, false, c, pRight));
+   }
+   if (isRed(pLeft) && isRed(pLeft->pRight))
+   {
+      // (a x (b y c)) z d
+      PNode * pX = unpack(pLeft, a, b);
+      PNode * pY = unpack(b, b, c);
+      return make(pY, true, make(pX, false, a, b), make(pShell, false, c, pRight));
+   }
+   if (isRed(pRight) && isRed(pRight->pRight))
+   {
+      // a x (b y (c z d))
+      PNode * pY = unpack(pRight, b, c);
+      PNode * pZ = unpack(c, c, d);
+      return make(pY, true, make(pShell, false, pLeft, b), make(pZ, false, c, d));
+   }
+   if (isRed(pRight) && isRed(pRight->pLeft))
+   {
+      // a x ((b y c) z d)
+      PNode * pZ = unpack(pRight, b, d);
+      PNode * pY = unpack(b, b, c);
+      return make(pY, true, make(pShell, false, pLeft, b), make(pZ, false, c, d));
+   }
+   return make(pShell, false /*isRed*/, pLeft, pRight);
+}
+
+/*****************************************************
+ * PERSISTENT BST :: BALANCE LEFT
+ * The left subtree just lost a black node. Borrow one
+ * from the right to even out the black heights
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: balanceLeft(PNode * pLeft, PNode * pShell, PNode * pRight)
+{
+   if (isRed(pLeft))
+      return make(pShell, true /*isRed*/, paint(pLeft, false /*isRed*/), pRight);
+   if (isBlack(pRight))
+      return balance(pLeft, pShell, paint(pRight, true /*isRed*/));
+
+   // the right is red over a black left child: a x ((b y c) z d)
+   assert(isRed(pRight) && isBlack(pRight->pLeft));
+   PNode * b;
+   PNode * c;
+   PNode * d;
+   PNode * pZ = unpack(pRight, b, d);
+   PNode * pY = unpack(b, b, c);
+   return make(pY, true /*isRed*/,
+               make(pShell, false /*isRed*/, pLeft, b),
+               balance(c, pZ, paint(d, true /*isRed*/)));
+}
+
+/*****************************************************
+ * PERSISTENT BST :: BALANCE RIGHT
+ * The mirror image of balanceLeft()
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: balanceRight(PNode * pLeft, PNode * pShell, PNode * pRight)
+{
+   if (isRed(pRight))
+      return make(pShell, true /*isRed*/, pLeft, paint(pRight, false /*isRed*/));
+   if (isBlack(pLeft))
+      return balance(paint(pLeft, true /*isRed*/), pShell, pRight);
+
+   // the left is red over a black right child: (a x (b y c)) z d
+   assert(isRed(pLeft) && isBlack(pLeft->pRight));
+   PNode * a;
+   PNode * b;
+   PNode * c;
+   PNode * pX = unpack(pLeft, a, b);
+   PNode * pY = unpack(b, b, c);
+   return make(pY, true /*isRed*/,
+               balance(paint(a, true /*isRed*/), pX, b),
+               make(pShell, false /*isRed*/, c, pRight));
+}
+
+/*****************************************************
+ * PERSISTENT BST :: APPEND
+ * Join two subtrees of equal black height where every
+ * element of the left comes before the right, to fill
+ * the hole left by an erased node
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: append(PNode * pLeft, PNode * pRight)
+{
+   if (pLeft == nullptr)
+      return pRight;
+   if (pRight == nullptr)
+      return pLeft;
+
+   PNode * a;
+   PNode * b;
+   PNode * c;
+   PNode * d;
+
+   // same color: join the inner subtrees and see what comes back
+   if (isRed(pLeft) == isRed(pRight))
+   {
+      bool red = isRed(pLeft);
+      PNode * pX = unpack(pLeft, a, b);
+      PNode * pY = unpack(pRight, c, d);
+      PNode * pMiddle = append(b, c);
+      if (isRed(pMiddle))
+      {
+         PNode * pZ = unpack(pMiddle, b, c);
+         return make(pZ, true /*isRed*/, make(pX, red, a, b), make(pY, red, c, d));
+      }
+      if (red)
+         return make(pX, true /*isRed*/, a, make(pY, true /*isRed*/, pMiddle, d));
+      return balanceLeft(a, pX, make(pY, false /*isRed*/, pMiddle, d));
+   }
+
+   // one red: it stays on top
+   if (isRed(pRight))
+   {
+      PNode * pY = unpack(pRight, c, d);
+      return make(pY, true /*isRed*/, append(pLeft, c), d);
+   }
+   PNode * pX = unpack(pLeft, a, b);
+   return make(pX, true /*isRed*/, a, append(b, pRight));
+}
+
+/*****************************************************
+ * PERSISTENT BST :: ACQUIRE and RELEASE
+ * Add or drop one reference. The last reference
+ * frees the node and drops its children
+ ****************************************************/
+template <typename T>
+typename PersistentBST <T> :: PNode * PersistentBST <T> :: acquire(PNode * pNode)
+{
+   if (pNode != nullptr)
+      pNode->refs.fetch_add(1, std::memory_order_relaxed);
+   return pNode;
+}
+
+template <typename T>
+void PersistentBST <T> :: release(PNode * pNode)
+{
+   while (pNode != nullptr && pNode->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+   {
+      release(pNode->pLeft);
+      PNode * pRight = pNode->pRight;
+      delete pNode;
+      pNode = pRight;   // loop rather than recurse down the right
+   }
+}
+
+
+/*********************************************
+ *********************************************
+ *********************************************
+ ***************** ITERATOR ******************
+ *********************************************
+ *********************************************
+ *********************************************/
+
+
+/**************************************************
+ * PERSISTENT BST ITERATOR :: INCREMENT PREFIX
+ * Down the right and then all the way left, or
+ * else up until we come up from a left child
+ *************************************************/
+template <typename T>
+typename PersistentBST <T> :: iterator & PersistentBST <T> :: iterator :: operator ++ ()
+{
+   if (depth == 0)
+      return *this;
+
+   if (node()->pRight != nullptr)
+   {
+      leftmost(node()->pRight);
+      return *this;
+   }
+
+   const PNode * pChild = path[--depth];
+   while (depth > 0 && node()->pRight == pChild)
+      pChild = path[--depth];
+   return *this;
+}
+
+/**************************************************
+ * PERSISTENT BST ITERATOR :: DECREMENT PREFIX
+ * The mirror image of increment. From end() this
+ * is the largest element
+ *************************************************/
+template <typename T>
+typename PersistentBST <T> :: iterator & PersistentBST <T> :: iterator :: operator -- ()
+{
+   if (depth == 0)
+   {
+      rightmost(pRoot);
+      return *this;
+   }
+
+   if (node()->pLeft != nullptr)
+   {
+      rightmost(node()->pLeft);
+      return *this;
+   }
+
+   const PNode * pChild = path[--depth];
+   while (depth > 0 && node()->pLeft == pChild)
+      pChild = path[--depth];
+   return *this;
+}
+
+} // namespace custom
@@ -0,0 +1,319 @@
+/***********************************************************************
+ * Header:
+ *    PRIORITY QUEUE
+ * Summary:
+ *    Our custom implementation of std::priority_queue: a heap stored in
+ *    a custom::vector, where top() is the largest element according to
+ *    Compare. The heap is d-ary, with the arity chosen at compile time.
+ *    Two children per node is the textbook heap. Four halves the height
+ *    of the tree, so pop() moves fewer elements, and the four children
+ *    it compares sit next to each other in memory.
+ *
+ *    Building from a range heapifies all of it at once in O(n) rather
+ *    than pushing one element at a time, and pop_push() replaces the
+ *    top with one percolate instead of two, which is what a scheduler
+ *    does every time it runs a task and puts it back.
+ *
+ *    This will contain the class definition of:
+ *        priority_queue      : A heap with a d-ary layout
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // for ASSERT
+#include <functional>  // for std::less
+#include <initializer_list>
+#include <iterator>    // for std::distance
+#include <utility>     // for std::move and std::swap
+#include "vector.h"
+
+class TestPQueue; // forward declaration for unit tests
+
+namespace custom
+{
+
+/*************************************************
+ * PRIORITY QUEUE
+ * The element at index i has its children at
+ * Arity*i+1 through Arity*i+Arity, and no child
+ * is larger than its parent.
+ *
+ * Container needs operator [], push_back(),
+ * pop_back(), back(), reserve(), and size()
+ *************************************************/
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Container = custom::vector<T>,
+          size_t Arity = 2>
+class priority_queue
+{
+   friend class ::TestPQueue; // give unit tests access to the privates
+   static_assert(Arity >= 2, "a heap needs at least two children per node");
+public:
+
+   //
+   // Construct
+   //
+
+   priority_queue(const Compare & compare = Compare()) : compare(compare) {}
+   priority_queue(const Compare & compare, Container && c);
+   template <class Iterator>
+   priority_queue(Iterator first, Iterator last, const Compare & compare = Compare());
+   priority_queue(const std::initializer_list<T> & il, const Compare & compare = Compare())
+      : priority_queue(il.begin(), il.end(), compare) {}
+
+   //
+   // Access
+   //
+
+   const T & top() const;
+
+   //
+   // Insert
+   //
+
+   void push(const T &  t);
+   void push(      T && t);
+   template <class Iterator>
+   void push_range(Iterator first, Iterator last);
+
+   //
+   // Remove
+   //
+
+   void pop();
+   void pop_push(const T &  t);
+   void pop_push(      T && t);
+
+   //
+   // Status
+   //
+
+   size_t size()  const { return container.size();   }
+   bool   empty() const { return container.size() == 0; }
+   void   swap(priority_queue & rhs)
+   {
+      std::swap(compare, rhs.compare);
+      container.swap(rhs.container);
+   }
+
+private:
+
+   void percolateUp(size_t index, size_t indexTop = 0);
+   void percolateDown(size_t index);
+   void heapify();
+
+   Compare compare;         // top() is the element nothing compares greater than
+   Container container;     // the heap, in breadth-first order
+};
+
+/************************************************
+ * P QUEUE :: CONTAINER CONSTRUCTOR
+ * Take over the elements of c and heapify them
+ *   COST   : O(n)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+priority_queue <T, Compare, Container, Arity> ::
+priority_queue(const Compare & compare, Container && c) : compare(compare), container(std::move(c))
+{
+   heapify();
+}
+
+/************************************************
+ * P QUEUE :: RANGE CONSTRUCTOR
+ * Copy the elements in, then heapify them all
+ * at once rather than pushing them one at a time
+ *   COST   : O(n)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+template <class Iterator>
+priority_queue <T, Compare, Container, Arity> ::
+priority_queue(Iterator first, Iterator last, const Compare & compare) : compare(compare)
+{
+   push_range(first, last);
+}
+
+/************************************************
+ * P QUEUE :: TOP
+ * The largest element in the heap
+ *   COST   : O(1)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+const T & priority_queue <T, Compare, Container, Arity> :: top() const
+{
+   assert(!empty());
+   return container[0];
+}
+
+/************************************************
+ * P QUEUE :: PUSH
+ * Put the new element at the end and let it rise
+ *   COST   : O(log n)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: push(const T & t)
+{
+   container.push_back(t);
+   percolateUp(container.size() - 1);
+}
+
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: push(T && t)
+{
+   container.push_back(std::move(t));
+   percolateUp(container.size() - 1);
+}
+
+/************************************************
+ * P QUEUE :: PUSH RANGE
+ * Add every element in [first, last). When the
+ * range is at least as big as the heap it is
+ * cheaper to heapify the whole thing again than
+ * to percolate each new element up
+ *   COST   : O(n + k) or O(k log(n + k)), whichever
+ *            is smaller
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+template <class Iterator>
+void priority_queue <T, Compare, Container, Arity> :: push_range(Iterator first, Iterator last)
+{
+   size_t numOld = container.size();
+   size_t numNew = (size_t)std::distance(first, last);
+   if (numNew >= numOld)
+   {
+      container.reserve(numOld + numNew);
+      for (; first != last; ++first)
+         container.push_back(*first);
+      heapify();
+   }
+   else
+      for (; first != last; ++first)
+         push(*first);
+}
+
+/************************************************
+ * P QUEUE :: POP
+ * Move the last element into the top and let it
+ * sink to where it belongs
+ *   COST   : O(log n)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: pop()
+{
+   if (empty())
+      return;
+   if (container.size() > 1)
+      container[0] = std::move(container.back());
+   container.pop_back();
+   if (!empty())
+      percolateDown(0);
+}
+
+/************************************************
+ * P QUEUE :: POP PUSH
+ * Replace the top with t. This is pop() and then
+ * push(t), but t goes straight into the hole at
+ * the top and sinks once
+ *   COST   : O(log n)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: pop_push(const T & t)
+{
+   if (empty())
+      return push(t);
+   container[0] = t;
+   percolateDown(0);
+}
+
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: pop_push(T && t)
+{
+   if (empty())
+      return push(std::move(t));
+   container[0] = std::move(t);
+   percolateDown(0);
+}
+
+/************************************************
+ * P QUEUE :: PERCOLATE UP
+ * Move the element at index up past every parent
+ * smaller than it, but no higher than indexTop.
+ * The parents slide down into the hole, so the
+ * element itself moves only once
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: percolateUp(size_t index, size_t indexTop)
+{
+   T t = std::move(container[index]);
+   while (index > indexTop)
+   {
+      size_t indexParent = (index - 1) / Arity;
+      if (!compare(container[indexParent], t))
+         break;
+      container[index] = std::move(container[indexParent]);
+      index = indexParent;
+   }
+   container[index] = std::move(t);
+}
+
+/************************************************
+ * P QUEUE :: PERCOLATE DOWN
+ * Sink the element at index to where it belongs.
+ * Rather than compare it against the children at
+ * every level, slide the largest child up into
+ * the hole all the way to the bottom, then let the
+ * element rise from there. An element that came
+ * from the bottom of the heap nearly always goes
+ * back near the bottom, so this saves a compare
+ * per level at the cost of a short climb
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: percolateDown(size_t index)
+{
+   size_t num = container.size();
+   size_t indexTop = index;
+   T t = std::move(container[index]);
+
+   // every node with all Arity children, where the loop bound is a constant
+   while (Arity * index + Arity < num)
+   {
+      size_t indexBest = Arity * index + 1;
+      for (size_t i = indexBest + 1; i <= Arity * index + Arity; i++)
+         indexBest = compare(container[indexBest], container[i]) ? i : indexBest;
+      container[index] = std::move(container[indexBest]);
+      index = indexBest;
+   }
+
+   // at most one node at the bottom has only some of its children
+   if (Arity * index + 1 < num)
+   {
+      size_t indexBest = Arity * index + 1;
+      for (size_t i = indexBest + 1; i < num; i++)
+         indexBest = compare(container[indexBest], container[i]) ? i : indexBest;
+      container[index] = std::move(container[indexBest]);
+      index = indexBest;
+   }
+   container[index] = std::move(t);
+   percolateUp(index, indexTop);
+}
+
+/************************************************
+ * P QUEUE :: HEAPIFY
+ * Turn the whole container into a heap from the
+ * bottom up. Most nodes are near the bottom and
+ * have little distance to sink
+ *   COST   : O(n)
+ ***********************************************/
+template <typename T, typename Compare, typename Container, size_t Arity>
+void priority_queue <T, Compare, Container, Arity> :: heapify()
+{
+   size_t num = container.size();
+   if (num < 2)
+      return;
+   for (size_t index = (num - 2) / Arity + 1; index-- > 0; )
+      percolateDown(index);
+}
+
+} // namespace custom
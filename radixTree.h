@@ -0,0 +1,1308 @@
+/***********************************************************************
+ * Header:
+ *    RADIX TREE
+ * Summary:
+ *    An adaptive radix tree (ART) for integer and string keys. Where a
+ *    BST compares the whole key at every level, a radix tree looks at
+ *    one byte of the key per level and goes straight to the child for
+ *    that byte, so a lookup costs O(key length) no matter how many keys
+ *    there are, and never compares keys until the leaf.
+ *
+ *    Inner nodes come in four sizes and grow and shrink between them
+ *    as children come and go: Node4 and Node16 keep sorted arrays of
+ *    key bytes (Node16 searches its sixteen with one SSE2 compare),
+ *    Node48 maps every byte to one of 48 child slots, and Node256 has
+ *    a child pointer for every byte. A chain of nodes with one child
+ *    each is collapsed into a prefix on the node below it. Up to eight
+ *    prefix bytes are kept in the node; a longer prefix is skipped on
+ *    the way down and checked at the leaf, which has the whole key.
+ *
+ *    Integers are stored as their bytes from the most significant down,
+ *    with the sign bit flipped, so byte order is numeric order. Strings
+ *    are stored as they are, and a string that is a prefix of another
+ *    sits in the node where it ends. Leaves are also linked in order,
+ *    so iterating costs O(1) a step.
+ *
+ *    This will contain the class definition of:
+ *        radix_tree           : The tree, generic over how to find
+ *                               the key in an element
+ *        radix_tree::iterator : An iterator through radix_tree
+ *        radix_set            : A radix_tree of keys
+ *        radix_map            : A radix_tree of key/value pairs
+ *        RadixKey             : The bytes of an integer or string key
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>     // for uint8_t and uint64_t
+#include <cstring>     // for memcmp and memcpy
+#include <initializer_list>
+#include <stdexcept>   // for std::out_of_range
+#include <string>
+#include <tuple>       // for std::forward_as_tuple
+#include <type_traits> // for std::is_integral and std::make_unsigned
+#include <utility>     // for std::pair
+#ifdef __SSE2__
+#include <emmintrin.h> // for the Node16 compares
+#endif
+#include "hash.h"      // for swiss::Identity and swiss::SelectFirst
+
+class TestRadixTree; // forward declaration for unit tests
+
+namespace custom
+{
+
+/*****************************************************************
+ * RADIX KEY
+ * The bytes of a key, in an order where comparing them with memcmp
+ * (and then by length) orders the keys the way operator < does.
+ * Integers are copied into the buffer; strings are pointed at
+ *****************************************************************/
+struct KeyBytes
+{
+   KeyBytes() : p(nullptr), len(0) {}
+   KeyBytes(const KeyBytes &) = delete;
+   KeyBytes & operator = (const KeyBytes &) = delete;
+   const uint8_t * p;
+   size_t len;
+   uint8_t buffer[8];
+};
+
+template <typename K, typename = void>
+struct RadixKey;
+
+template <typename K>
+struct RadixKey <K, typename std::enable_if<std::is_integral<K>::value>::type>
+{
+   static_assert(sizeof(K) <= 8, "radix_tree keys are at most 64 bits");
+   static void bytes(const K & k, KeyBytes & out)
+   {
+      typedef typename std::make_unsigned<K>::type U;
+      U u = (U)k;
+      if (std::is_signed<K>::value)
+         u ^= (U)((U)1 << (sizeof(K) * 8 - 1));
+      for (size_t i = 0; i < sizeof(K); i++)
+         out.buffer[i] = (uint8_t)(u >> (8 * (sizeof(K) - 1 - i)));
+      out.p = out.buffer;
+      out.len = sizeof(K);
+   }
+};
+
+template <>
+struct RadixKey <std::string>
+{
+   static void bytes(const std::string & s, KeyBytes & out)
+   {
+      out.p = (const uint8_t *)s.data();
+      out.len = s.size();
+   }
+};
+
+/*****************************************************************
+ * RADIX TREE
+ * Elements of type T, ordered and looked up by the key KeyOf finds
+ * in them. A child pointer with its low bit set is a leaf; every
+ * other one is an inner node, which always has at least two things
+ * under it: children, or children and the leaf of the key ending
+ * there.
+ *****************************************************************/
+template <typename T, typename K, typename KeyOf>
+class radix_tree
+{
+   friend class ::TestRadixTree; // give unit tests access to the privates
+
+public:
+   //
+   // Construct
+   //
+   radix_tree() : root(nullptr), pFirst(nullptr), pLast(nullptr), numElements(0) {}
+   radix_tree(const radix_tree &  rhs);
+   radix_tree(      radix_tree && rhs);
+   radix_tree(const std::initializer_list<T>& il);
+  ~radix_tree() { clear(); }
+
+   //
+   // Assign
+   //
+   radix_tree & operator = (const radix_tree &  rhs);
+   radix_tree & operator = (      radix_tree && rhs);
+   void swap(radix_tree & rhs);
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const { return iterator(this, pFirst);  }
+   iterator end()   const { return iterator(this, nullptr); }
+
+   //
+   // Access
+   //
+   iterator find(const K & key) const;
+   iterator lower_bound(const K & key) const;
+   iterator upper_bound(const K & key) const;
+   size_t   count(const K & key) const { return find(key) != end() ? 1 : 0; }
+
+   //
+   // Insert
+   //
+   std::pair<iterator, bool> insert(const T &  t) { return emplaceKey(KeyOf()(t), t); }
+   std::pair<iterator, bool> insert(      T && t) { return emplaceKey(KeyOf()(t), std::move(t)); }
+
+   //
+   // Remove
+   //
+   size_t   erase(const K & key);
+   iterator erase(iterator it);
+   void     clear();
+
+   //
+   // Status
+   //
+   size_t size()  const { return numElements;      }
+   bool   empty() const { return numElements == 0; }
+
+protected:
+   template <class... Args>
+   std::pair<iterator, bool> emplaceKey(const K & key, Args&&... args);
+
+private:
+   static const size_t maxPrefix = 8;
+   enum NodeType : uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+   struct Leaf;
+   struct Node;
+   struct Node4;
+   struct Node16;
+   struct Node48;
+   struct Node256;
+
+   // a child is either, told apart by the low bit
+   static bool   isLeaf(const Node * p) { return ((uintptr_t)p & 1) != 0;              }
+   static Leaf * asLeaf(const Node * p) { return (Leaf *)((uintptr_t)p & ~(uintptr_t)1); }
+   static Node * tag   (const Leaf * p) { return (Node *)((uintptr_t)p | 1);            }
+
+   static void keyOf(const Leaf * pLeaf, KeyBytes & out) { RadixKey<K>::bytes(KeyOf()(pLeaf->value), out); }
+   static int  compareBytes(const KeyBytes & a, const KeyBytes & b);
+
+   // what every inner node does, whatever its size
+   static Node ** findChild(Node * pNode, uint8_t b);
+   static Node *  nextChild(const Node * pNode, int b);
+   static Node *  prevChild(const Node * pNode, int b);
+   static Node *  firstChild(const Node * pNode) { return nextChild(pNode, -1);  }
+   static Node *  lastChild (const Node * pNode) { return prevChild(pNode, 256); }
+   static void    addChild(Node ** pRef, Node * pNode, uint8_t b, Node * pChild);
+   static void    removeChild(Node ** pRef, Node * pNode, uint8_t b);
+   static void    freeNode(Node * pNode);
+
+   static Leaf * minimum(const Node * p);
+   static Leaf * maximum(const Node * p);
+   static void   setPrefix(Node * pNode, const KeyBytes & kb, size_t depth, size_t len);
+   static size_t prefixMismatch(const Node * pNode, const KeyBytes & kb, size_t depth);
+   static uint8_t prefixByte(const Node * pNode, size_t i, const KeyBytes & kbMin, size_t depth);
+   static void   attach(Node4 * pNode, const KeyBytes & kb, size_t depth, Leaf * pLeaf);
+   static void   collapse(Node ** pRef, Node * pNode, size_t depth);
+
+   Leaf * findLeaf(const KeyBytes & kb) const;
+   static Leaf * lowerBound(const Node * p, size_t depth, const KeyBytes & kb);
+   void linkBefore(Leaf * pNew, Leaf * pNext);
+   void linkAfter (Leaf * pNew, Leaf * pPrev);
+   void removeLeaf(Leaf * pLeaf);
+   static void clear(Node * p);
+
+   Node * root;
+   Leaf * pFirst;          // the smallest key's leaf
+   Leaf * pLast;           // the largest key's leaf
+   size_t numElements;
+};
+
+/**************************************************
+ * RADIX TREE :: LEAF and NODES
+ * Every inner node starts with the same header: its
+ * type, how many children, its prefix, and the leaf
+ * of a key that ends right after the prefix, if any
+ *************************************************/
+template <typename T, typename K, typename KeyOf>
+struct radix_tree <T, K, KeyOf> :: Leaf
+{
+   template <class... Args>
+   explicit Leaf(Args&&... args) : pPrev(nullptr), pNext(nullptr), value(std::forward<Args>(args)...) {}
+   Leaf * pPrev;
+   Leaf * pNext;
+   T value;
+};
+
+template <typename T, typename K, typename KeyOf>
+struct radix_tree <T, K, KeyOf> :: Node
+{
+   explicit Node(NodeType type) : type(type), numChildren(0), prefixLen(0), pLeaf(nullptr) {}
+   NodeType type;
+   uint16_t numChildren;
+   uint32_t prefixLen;            // may be more than the bytes kept in prefix
+   uint8_t  prefix[maxPrefix];
+   Leaf *   pLeaf;                // the key that ends here
+};
+
+template <typename T, typename K, typename KeyOf>
+struct radix_tree <T, K, KeyOf> :: Node4 : Node
+{
+   Node4() : Node(NODE4) {}
+   uint8_t keys[4];               // sorted
+   Node * children[4];
+};
+
+template <typename T, typename K, typename KeyOf>
+struct radix_tree <T, K, KeyOf> :: Node16 : Node
+{
+   Node16() : Node(NODE16) {}
+   uint8_t keys[16];              // sorted
+   Node * children[16];
+};
+
+template <typename T, typename K, typename KeyOf>
+struct radix_tree <T, K, KeyOf> :: Node48 : Node
+{
+   Node48() : Node(NODE48) { memset(index, 0, sizeof(index)); memset(children, 0, sizeof(children)); }
+   uint8_t index[256];            // a slot in children plus one, or 0 for none
+   Node * children[48];
+};
+
+template <typename T, typename K, typename KeyOf>
+struct radix_tree <T, K, KeyOf> :: Node256 : Node
+{
+   Node256() : Node(NODE256) { memset(children, 0, sizeof(children)); }
+   Node * children[256];
+};
+
+/**************************************************
+ * RADIX TREE ITERATOR
+ * A leaf, and the tree for stepping back from end()
+ *************************************************/
+template <typename T, typename K, typename KeyOf>
+class radix_tree <T, K, KeyOf> :: iterator
+{
+   friend class ::TestRadixTree; // give unit tests access to the privates
+   friend class radix_tree <T, K, KeyOf>;
+public:
+   iterator() : pTree(nullptr), pLeaf(nullptr) {}
+
+   bool operator == (const iterator & rhs) const { return pLeaf == rhs.pLeaf; }
+   bool operator != (const iterator & rhs) const { return pLeaf != rhs.pLeaf; }
+
+   T & operator *  () const { return  pLeaf->value; }
+   T * operator -> () const { return &pLeaf->value; }
+
+   iterator & operator ++ ()
+   {
+      pLeaf = pLeaf->pNext;
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator itReturn = *this;
+      ++(*this);
+      return itReturn;
+   }
+   iterator & operator -- ()
+   {
+      pLeaf = (pLeaf == nullptr) ? pTree->pLast : pLeaf->pPrev;
+      return *this;
+   }
+   iterator operator -- (int)
+   {
+      iterator itReturn = *this;
+      --(*this);
+      return itReturn;
+   }
+
+private:
+   iterator(const radix_tree * pTree, Leaf * pLeaf) : pTree(pTree), pLeaf(pLeaf) {}
+   const radix_tree * pTree;
+   Leaf * pLeaf;
+};
+
+/*****************************************************************
+ * RADIX SET
+ * A radix_tree of keys
+ *****************************************************************/
+template <typename K>
+class radix_set : public radix_tree<K, K, swiss::Identity>
+{
+public:
+   using radix_tree<K, K, swiss::Identity>::radix_tree;
+};
+
+/*****************************************************************
+ * RADIX MAP
+ * A radix_tree of pairs, looked up by the first of the pair
+ *****************************************************************/
+template <typename K, typename V>
+class radix_map : public radix_tree<std::pair<const K, V>, K, swiss::SelectFirst>
+{
+   typedef radix_tree<std::pair<const K, V>, K, swiss::SelectFirst> Tree;
+public:
+   using Tree::Tree;
+   typedef typename Tree::iterator iterator;
+
+   // insert a value made from args, unless key is already there
+   template <class... Args>
+   std::pair<iterator, bool> try_emplace(const K & key, Args&&... args)
+   {
+      return this->emplaceKey(key, std::piecewise_construct,
+                              std::forward_as_tuple(key),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+   }
+
+   V & operator [] (const K & key) { return try_emplace(key).first->second; }
+
+   V & at(const K & key)
+   {
+      iterator it = this->find(key);
+      if (it == this->end())
+         throw std::out_of_range("custom::radix_map::at");
+      return it->second;
+   }
+   const V & at(const K & key) const
+   {
+      iterator it = this->find(key);
+      if (it == this->end())
+         throw std::out_of_range("custom::radix_map::at");
+      return it->second;
+   }
+};
+
+/*****************************************************
+ * RADIX TREE :: COPY CONSTRUCTOR and ASSIGNMENT
+ * Insert the elements one at a time, in order
+ *   COST   : O(n k) for keys of k bytes
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+radix_tree <T, K, KeyOf> :: radix_tree(const radix_tree & rhs) : radix_tree()
+{
+   *this = rhs;
+}
+
+template <typename T, typename K, typename KeyOf>
+radix_tree <T, K, KeyOf> :: radix_tree(radix_tree && rhs) : radix_tree()
+{
+   swap(rhs);
+}
+
+template <typename T, typename K, typename KeyOf>
+radix_tree <T, K, KeyOf> :: radix_tree(const std::initializer_list<T>& il) : radix_tree()
+{
+   for (const T & t : il)
+      insert(t);
+}
+
+template <typename T, typename K, typename KeyOf>
+radix_tree <T, K, KeyOf> & radix_tree <T, K, KeyOf> :: operator = (const radix_tree & rhs)
+{
+   if (this == &rhs)
+      return *this;
+   clear();
+   for (Leaf * pLeaf = rhs.pFirst; pLeaf; pLeaf = pLeaf->pNext)
+      insert(pLeaf->value);
+   return *this;
+}
+
+template <typename T, typename K, typename KeyOf>
+radix_tree <T, K, KeyOf> & radix_tree <T, K, KeyOf> :: operator = (radix_tree && rhs)
+{
+   clear();
+   swap(rhs);
+   return *this;
+}
+
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: swap(radix_tree & rhs)
+{
+   std::swap(root, rhs.root);
+   std::swap(pFirst, rhs.pFirst);
+   std::swap(pLast, rhs.pLast);
+   std::swap(numElements, rhs.numElements);
+}
+
+/*****************************************************
+ * RADIX TREE :: CLEAR
+ * Free every node, and then every leaf off the list
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: clear()
+{
+   clear(root);
+   for (Leaf * pLeaf = pFirst; pLeaf; )
+   {
+      Leaf * pNext = pLeaf->pNext;
+      delete pLeaf;
+      pLeaf = pNext;
+   }
+   root = nullptr;
+   pFirst = pLast = nullptr;
+   numElements = 0;
+}
+
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: clear(Node * p)
+{
+   if (p == nullptr || isLeaf(p))
+      return;
+   switch (p->type)
+   {
+      case NODE4:
+         for (size_t i = 0; i < p->numChildren; i++)
+            clear(static_cast<Node4 *>(p)->children[i]);
+         break;
+      case NODE16:
+         for (size_t i = 0; i < p->numChildren; i++)
+            clear(static_cast<Node16 *>(p)->children[i]);
+         break;
+      case NODE48:
+         for (size_t i = 0; i < 48; i++)
+            clear(static_cast<Node48 *>(p)->children[i]);
+         break;
+      case NODE256:
+         for (size_t i = 0; i < 256; i++)
+            clear(static_cast<Node256 *>(p)->children[i]);
+         break;
+   }
+   freeNode(p);
+}
+
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: freeNode(Node * pNode)
+{
+   switch (pNode->type)
+   {
+      case NODE4:   delete static_cast<Node4   *>(pNode); break;
+      case NODE16:  delete static_cast<Node16  *>(pNode); break;
+      case NODE48:  delete static_cast<Node48  *>(pNode); break;
+      case NODE256: delete static_cast<Node256 *>(pNode); break;
+   }
+}
+
+/*****************************************************
+ * RADIX TREE :: COMPARE BYTES
+ * Like memcmp, and then the shorter key first
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+int radix_tree <T, K, KeyOf> :: compareBytes(const KeyBytes & a, const KeyBytes & b)
+{
+   size_t len = a.len < b.len ? a.len : b.len;
+   int result = len ? memcmp(a.p, b.p, len) : 0;
+   if (result != 0)
+      return result;
+   return a.len < b.len ? -1 : (a.len > b.len ? 1 : 0);
+}
+
+/*****************************************************
+ * RADIX TREE :: FIND CHILD
+ * Where the child for byte b hangs, or nullptr. In a
+ * Node16 all sixteen bytes are compared at once
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Node **
+radix_tree <T, K, KeyOf> :: findChild(Node * pNode, uint8_t b)
+{
+   switch (pNode->type)
+   {
+      case NODE4:
+      {
+         Node4 * p = static_cast<Node4 *>(pNode);
+         for (size_t i = 0; i < p->numChildren; i++)
+            if (p->keys[i] == b)
+               return &p->children[i];
+         return nullptr;
+      }
+      case NODE16:
+      {
+         Node16 * p = static_cast<Node16 *>(pNode);
+#ifdef __SSE2__
+         __m128i match = _mm_cmpeq_epi8(_mm_set1_epi8((char)b), _mm_loadu_si128((const __m128i *)p->keys));
+         unsigned mask = (unsigned)_mm_movemask_epi8(match) & ((1u << p->numChildren) - 1);
+         return mask ? &p->children[__builtin_ctz(mask)] : nullptr;
+#else
+         for (size_t i = 0; i < p->numChildren; i++)
+            if (p->keys[i] == b)
+               return &p->children[i];
+         return nullptr;
+#endif
+      }
+      case NODE48:
+      {
+         Node48 * p = static_cast<Node48 *>(pNode);
+         return p->index[b] ? &p->children[p->index[b] - 1] : nullptr;
+      }
+      case NODE256:
+      {
+         Node256 * p = static_cast<Node256 *>(pNode);
+         return p->children[b] ? &p->children[b] : nullptr;
+      }
+   }
+   return nullptr;
+}
+
+/*****************************************************
+ * RADIX TREE :: NEXT CHILD and PREV CHILD
+ * The child with the smallest byte above b, or the
+ * largest below it; nullptr if there is none. b can
+ * be -1 or 256 to get the first or the last child
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Node *
+radix_tree <T, K, KeyOf> :: nextChild(const Node * pNode, int b)
+{
+   switch (pNode->type)
+   {
+      case NODE4:
+      case NODE16:
+      {
+         const uint8_t * keys = pNode->type == NODE4 ? static_cast<const Node4 *>(pNode)->keys
+                                                     : static_cast<const Node16 *>(pNode)->keys;
+         Node * const * children = pNode->type == NODE4 ? static_cast<const Node4 *>(pNode)->children
+                                                        : static_cast<const Node16 *>(pNode)->children;
+         for (size_t i = 0; i < pNode->numChildren; i++)
+            if ((int)keys[i] > b)
+               return children[i];
+         return nullptr;
+      }
+      case NODE48:
+      {
+         const Node48 * p = static_cast<const Node48 *>(pNode);
+         for (int i = b + 1; i < 256; i++)
+            if (p->index[i])
+               return p->children[p->index[i] - 1];
+         return nullptr;
+      }
+      case NODE256:
+      {
+         const Node256 * p = static_cast<const Node256 *>(pNode);
+         for (int i = b + 1; i < 256; i++)
+            if (p->children[i])
+               return p->children[i];
+         return nullptr;
+      }
+   }
+   return nullptr;
+}
+
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Node *
+radix_tree <T, K, KeyOf> :: prevChild(const Node * pNode, int b)
+{
+   switch (pNode->type)
+   {
+      case NODE4:
+      case NODE16:
+      {
+         const uint8_t * keys = pNode->type == NODE4 ? static_cast<const Node4 *>(pNode)->keys
+                                                     : static_cast<const Node16 *>(pNode)->keys;
+         Node * const * children = pNode->type == NODE4 ? static_cast<const Node4 *>(pNode)->children
+                                                        : static_cast<const Node16 *>(pNode)->children;
+         for (size_t i = pNode->numChildren; i-- > 0; )
+            if ((int)keys[i] < b)
+               return children[i];
+         return nullptr;
+      }
+      case NODE48:
+      {
+         const Node48 * p = static_cast<const Node48 *>(pNode);
+         for (int i = b - 1; i >= 0; i--)
+            if (p->index[i])
+               return p->children[p->index[i] - 1];
+         return nullptr;
+      }
+      case NODE256:
+      {
+         const Node256 * p = static_cast<const Node256 *>(pNode);
+         for (int i = b - 1; i >= 0; i--)
+            if (p->children[i])
+               return p->children[i];
+         return nullptr;
+      }
+   }
+   return nullptr;
+}
+
+/*****************************************************
+ * RADIX TREE :: ADD CHILD
+ * Hang a child for byte b, which has none. A full
+ * node is replaced by one of the next size up, and
+ * *pRef, which pointed at it, by the new one
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: addChild(Node ** pRef, Node * pNode, uint8_t b, Node * pChild)
+{
+   switch (pNode->type)
+   {
+      case NODE4:
+      {
+         Node4 * p = static_cast<Node4 *>(pNode);
+         if (p->numChildren < 4)
+         {
+            size_t i = 0;
+            while (i < p->numChildren && p->keys[i] < b)
+               i++;
+            memmove(p->keys + i + 1, p->keys + i, p->numChildren - i);
+            memmove(p->children + i + 1, p->children + i, (p->numChildren - i) * sizeof(Node *));
+            p->keys[i] = b;
+            p->children[i] = pChild;
+            p->numChildren++;
+            return;
+         }
+         Node16 * pBigger = new Node16;
+         memcpy((Node *)pBigger, (const Node *)p, sizeof(Node));
+         pBigger->type = NODE16;
+         memcpy(pBigger->keys, p->keys, 4);
+         memcpy(pBigger->children, p->children, 4 * sizeof(Node *));
+         *pRef = pBigger;
+         delete p;
+         addChild(pRef, pBigger, b, pChild);
+         return;
+      }
+      case NODE16:
+      {
+         Node16 * p = static_cast<Node16 *>(pNode);
+         if (p->numChildren < 16)
+         {
+            // how many keys are below b, with one SSE2 compare
+#ifdef __SSE2__
+            __m128i flip = _mm_set1_epi8((char)0x80);
+            __m128i less = _mm_cmplt_epi8(_mm_xor_si128(_mm_loadu_si128((const __m128i *)p->keys), flip),
+                                          _mm_xor_si128(_mm_set1_epi8((char)b), flip));
+            unsigned mask = (unsigned)_mm_movemask_epi8(less) & ((1u << p->numChildren) - 1);
+            size_t i = (size_t)__builtin_popcount(mask);
+#else
+            size_t i = 0;
+            while (i < p->numChildren && p->keys[i] < b)
+               i++;
+#endif
+            memmove(p->keys + i + 1, p->keys + i, p->numChildren - i);
+            memmove(p->children + i + 1, p->children + i, (p->numChildren - i) * sizeof(Node *));
+            p->keys[i] = b;
+            p->children[i] = pChild;
+            p->numChildren++;
+            return;
+         }
+         Node48 * pBigger = new Node48;
+         memcpy((Node *)pBigger, (const Node *)p, sizeof(Node));
+         pBigger->type = NODE48;
+         for (size_t i = 0; i < 16; i++)
+         {
+            pBigger->index[p->keys[i]] = (uint8_t)(i + 1);
+            pBigger->children[i] = p->children[i];
+         }
+         *pRef = pBigger;
+         delete p;
+         addChild(pRef, pBigger, b, pChild);
+         return;
+      }
+      case NODE48:
+      {
+         Node48 * p = static_cast<Node48 *>(pNode);
+         if (p->numChildren < 48)
+         {
+            size_t slot = 0;
+            while (p->children[slot])
+               slot++;
+            p->children[slot] = pChild;
+            p->index[b] = (uint8_t)(slot + 1);
+            p->numChildren++;
+            return;
+         }
+         Node256 * pBigger = new Node256;
+         memcpy((Node *)pBigger, (const Node *)p, sizeof(Node));
+         pBigger->type = NODE256;
+         for (size_t i = 0; i < 256; i++)
+            if (p->index[i])
+               pBigger->children[i] = p->children[p->index[i] - 1];
+         *pRef = pBigger;
+         delete p;
+         addChild(pRef, pBigger, b, pChild);
+         return;
+      }
+      case NODE256:
+      {
+         Node256 * p = static_cast<Node256 *>(pNode);
+         p->children[b] = pChild;
+         p->numChildren++;
+         return;
+      }
+   }
+}
+
+/*****************************************************
+ * RADIX TREE :: REMOVE CHILD
+ * Take away the child for byte b. A node that has
+ * become sparse enough is replaced by a smaller one,
+ * with some slack so a node on the edge does not
+ * flip back and forth
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: removeChild(Node ** pRef, Node * pNode, uint8_t b)
+{
+   switch (pNode->type)
+   {
+      case NODE4:
+      case NODE16:
+      {
+         uint8_t * keys = pNode->type == NODE4 ? static_cast<Node4 *>(pNode)->keys
+                                               : static_cast<Node16 *>(pNode)->keys;
+         Node ** children = pNode->type == NODE4 ? static_cast<Node4 *>(pNode)->children
+                                                 : static_cast<Node16 *>(pNode)->children;
+         size_t i = (size_t)(findChild(pNode, b) - children);
+         memmove(keys + i, keys + i + 1, pNode->numChildren - i - 1);
+         memmove(children + i, children + i + 1, (pNode->numChildren - i - 1) * sizeof(Node *));
+         pNode->numChildren--;
+
+         if (pNode->type == NODE16 && pNode->numChildren <= 3)
+         {
+            Node16 * p = static_cast<Node16 *>(pNode);
+            Node4 * pSmaller = new Node4;
+            memcpy((Node *)pSmaller, (const Node *)p, sizeof(Node));
+            pSmaller->type = NODE4;
+            memcpy(pSmaller->keys, p->keys, p->numChildren);
+            memcpy(pSmaller->children, p->children, p->numChildren * sizeof(Node *));
+            *pRef = pSmaller;
+            delete p;
+         }
+         return;
+      }
+      case NODE48:
+      {
+         Node48 * p = static_cast<Node48 *>(pNode);
+         p->children[p->index[b] - 1] = nullptr;
+         p->index[b] = 0;
+         p->numChildren--;
+
+         if (p->numChildren <= 12)
+         {
+            Node16 * pSmaller = new Node16;
+            memcpy((Node *)pSmaller, (const Node *)p, sizeof(Node));
+            pSmaller->type = NODE16;
+            size_t num = 0;
+            for (size_t i = 0; i < 256; i++)
+               if (p->index[i])
+               {
+                  pSmaller->keys[num] = (uint8_t)i;
+                  pSmaller->children[num++] = p->children[p->index[i] - 1];
+               }
+            *pRef = pSmaller;
+            delete p;
+         }
+         return;
+      }
+      case NODE256:
+      {
+         Node256 * p = static_cast<Node256 *>(pNode);
+         p->children[b] = nullptr;
+         p->numChildren--;
+
+         if (p->numChildren <= 37)
+         {
+            Node48 * pSmaller = new Node48;
+            memcpy((Node *)pSmaller, (const Node *)p, sizeof(Node));
+            pSmaller->type = NODE48;
+            size_t num = 0;
+            for (size_t i = 0; i < 256; i++)
+               if (p->children[i])
+               {
+                  pSmaller->index[i] = (uint8_t)(num + 1);
+                  pSmaller->children[num++] = p->children[i];
+               }
+            *pRef = pSmaller;
+            delete p;
+         }
+         return;
+      }
+   }
+}
+
+/*****************************************************
+ * RADIX TREE :: MINIMUM and MAXIMUM
+ * The smallest and largest leaf under a child. A key
+ * ending at a node is smaller than any going on
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Leaf *
+radix_tree <T, K, KeyOf> :: minimum(const Node * p)
+{
+   while (!isLeaf(p))
+   {
+      if (p->pLeaf)
+         return p->pLeaf;
+      p = firstChild(p);
+   }
+   return asLeaf(p);
+}
+
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Leaf *
+radix_tree <T, K, KeyOf> :: maximum(const Node * p)
+{
+   while (!isLeaf(p))
+   {
+      Node * pLast = lastChild(p);
+      if (pLast == nullptr)
+         return p->pLeaf;
+      p = pLast;
+   }
+   return asLeaf(p);
+}
+
+/*****************************************************
+ * RADIX TREE :: SET PREFIX
+ * Give a node the len bytes of a key from depth on,
+ * keeping as many as fit
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: setPrefix(Node * pNode, const KeyBytes & kb, size_t depth, size_t len)
+{
+   pNode->prefixLen = (uint32_t)len;
+   memcpy(pNode->prefix, kb.p + depth, len < maxPrefix ? len : maxPrefix);
+}
+
+/*****************************************************
+ * RADIX TREE :: PREFIX BYTE and PREFIX MISMATCH
+ * The i'th byte of a node's prefix, from the node if
+ * it kept it, else from a key under it (kbMin, the
+ * key of its minimum). The mismatch is how many of
+ * the prefix bytes a key shares, comparing them all
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+uint8_t radix_tree <T, K, KeyOf> :: prefixByte(const Node * pNode, size_t i, const KeyBytes & kbMin, size_t depth)
+{
+   return i < maxPrefix ? pNode->prefix[i] : kbMin.p[depth + i];
+}
+
+template <typename T, typename K, typename KeyOf>
+size_t radix_tree <T, K, KeyOf> :: prefixMismatch(const Node * pNode, const KeyBytes & kb, size_t depth)
+{
+   size_t len = pNode->prefixLen;
+   size_t kept = len < maxPrefix ? len : maxPrefix;
+   for (size_t i = 0; i < kept; i++)
+      if (depth + i >= kb.len || pNode->prefix[i] != kb.p[depth + i])
+         return i;
+   if (len == kept)
+      return len;
+
+   KeyBytes kbMin;
+   keyOf(minimum(pNode), kbMin);
+   for (size_t i = kept; i < len; i++)
+      if (depth + i >= kb.len || kbMin.p[depth + i] != kb.p[depth + i])
+         return i;
+   return len;
+}
+
+/*****************************************************
+ * RADIX TREE :: ATTACH
+ * Put a leaf in a new node, as the key that ends
+ * there or as the child for its next byte
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: attach(Node4 * pNode, const KeyBytes & kb, size_t depth, Leaf * pLeaf)
+{
+   if (kb.len == depth)
+      pNode->pLeaf = pLeaf;
+   else
+      addChild(nullptr, pNode, kb.p[depth], tag(pLeaf));
+}
+
+/*****************************************************
+ * RADIX TREE :: LINK BEFORE, LINK AFTER, REMOVE LEAF
+ * Keep the leaves in order in their list
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: linkBefore(Leaf * pNew, Leaf * pNext)
+{
+   pNew->pNext = pNext;
+   pNew->pPrev = pNext->pPrev;
+   (pNext->pPrev ? pNext->pPrev->pNext : pFirst) = pNew;
+   pNext->pPrev = pNew;
+}
+
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: linkAfter(Leaf * pNew, Leaf * pPrev)
+{
+   pNew->pPrev = pPrev;
+   pNew->pNext = pPrev->pNext;
+   (pPrev->pNext ? pPrev->pNext->pPrev : pLast) = pNew;
+   pPrev->pNext = pNew;
+}
+
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: removeLeaf(Leaf * pLeaf)
+{
+   (pLeaf->pPrev ? pLeaf->pPrev->pNext : pFirst) = pLeaf->pNext;
+   (pLeaf->pNext ? pLeaf->pNext->pPrev : pLast) = pLeaf->pPrev;
+   delete pLeaf;
+   numElements--;
+}
+
+/*****************************************************
+ * RADIX TREE :: FIND
+ * Go down a byte at a time, skipping prefixes longer
+ * than a node keeps, and compare the whole key once,
+ * at the leaf
+ *   COST   : O(k) for a key of k bytes
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: iterator
+radix_tree <T, K, KeyOf> :: find(const K & key) const
+{
+   KeyBytes kb;
+   RadixKey<K>::bytes(key, kb);
+   return iterator(this, findLeaf(kb));
+}
+
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Leaf *
+radix_tree <T, K, KeyOf> :: findLeaf(const KeyBytes & kb) const
+{
+   Node * p = root;
+   size_t depth = 0;
+   while (p != nullptr)
+   {
+      if (isLeaf(p))
+         break;
+
+      size_t kept = p->prefixLen < maxPrefix ? p->prefixLen : maxPrefix;
+      for (size_t i = 0; i < kept; i++)
+         if (depth + i >= kb.len || p->prefix[i] != kb.p[depth + i])
+            return nullptr;
+      depth += p->prefixLen;
+
+      if (depth >= kb.len)
+      {
+         if (depth > kb.len || p->pLeaf == nullptr)
+            return nullptr;
+         p = tag(p->pLeaf);
+         break;
+      }
+      Node ** pChild = findChild(p, kb.p[depth++]);
+      p = pChild ? *pChild : nullptr;
+   }
+   if (p == nullptr)
+      return nullptr;
+
+   KeyBytes kbLeaf;
+   keyOf(asLeaf(p), kbLeaf);
+   return compareBytes(kbLeaf, kb) == 0 ? asLeaf(p) : nullptr;
+}
+
+/*****************************************************
+ * RADIX TREE :: LOWER BOUND and UPPER BOUND
+ * The first key not less than key, or greater. Where
+ * the key leaves the tree, everything below is either
+ * all smaller, so the answer is the leaf after their
+ * maximum, or all larger, so it is their minimum
+ *   COST   : O(k), and a scan of the node it stops in
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: iterator
+radix_tree <T, K, KeyOf> :: lower_bound(const K & key) const
+{
+   if (root == nullptr)
+      return end();
+   KeyBytes kb;
+   RadixKey<K>::bytes(key, kb);
+   return iterator(this, lowerBound(root, 0, kb));
+}
+
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: iterator
+radix_tree <T, K, KeyOf> :: upper_bound(const K & key) const
+{
+   iterator it = lower_bound(key);
+   if (it != end())
+   {
+      KeyBytes kb;
+      KeyBytes kbFound;
+      RadixKey<K>::bytes(key, kb);
+      keyOf(it.pLeaf, kbFound);
+      if (compareBytes(kbFound, kb) == 0)
+         ++it;
+   }
+   return it;
+}
+
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: Leaf *
+radix_tree <T, K, KeyOf> :: lowerBound(const Node * p, size_t depth, const KeyBytes & kb)
+{
+   while (!isLeaf(p))
+   {
+      if (p->prefixLen > 0)
+      {
+         KeyBytes kbMin;
+         if (p->prefixLen > maxPrefix)
+            keyOf(minimum(p), kbMin);
+         for (size_t i = 0; i < p->prefixLen; i++)
+         {
+            if (depth + i == kb.len)
+               return minimum(p);
+            uint8_t b = prefixByte(p, i, kbMin, depth);
+            if (b < kb.p[depth + i])
+               return maximum(p)->pNext;
+            if (b > kb.p[depth + i])
+               return minimum(p);
+         }
+         depth += p->prefixLen;
+      }
+
+      if (depth == kb.len)
+         return minimum(p);
+
+      uint8_t b = kb.p[depth];
+      Node ** pChild = findChild(const_cast<Node *>(p), b);
+      if (pChild == nullptr)
+      {
+         Node * pNext = nextChild(p, b);
+         return pNext ? minimum(pNext) : maximum(p)->pNext;
+      }
+      p = *pChild;
+      depth++;
+   }
+
+   KeyBytes kbLeaf;
+   keyOf(asLeaf(p), kbLeaf);
+   return compareBytes(kbLeaf, kb) >= 0 ? asLeaf(p) : asLeaf(p)->pNext;
+}
+
+/*****************************************************
+ * RADIX TREE :: EMPLACE KEY
+ * Go down as find() does. Where the key leaves the
+ * tree, make its leaf from args and hang it there,
+ * splitting a leaf or a prefix it shares only part
+ * of with a new Node4. Its place in the leaf list
+ * is next to a neighbor found on the way
+ *   INPUT  : the key, and what to build the element from
+ *   OUTPUT : the element with that key, and whether it is new
+ *   COST   : O(k)
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+template <class... Args>
+std::pair<typename radix_tree <T, K, KeyOf> :: iterator, bool>
+radix_tree <T, K, KeyOf> :: emplaceKey(const K & key, Args&&... args)
+{
+   KeyBytes kb;
+   RadixKey<K>::bytes(key, kb);
+
+   if (root == nullptr)
+   {
+      Leaf * pNew = new Leaf(std::forward<Args>(args)...);
+      root = tag(pNew);
+      pFirst = pLast = pNew;
+      numElements++;
+      return std::make_pair(iterator(this, pNew), true);
+   }
+
+   Node ** pRef = &root;
+   size_t depth = 0;
+   while (true)
+   {
+      Node * p = *pRef;
+
+      // a leaf where the key would go: both go under a new Node4
+      if (isLeaf(p))
+      {
+         Leaf * pOld = asLeaf(p);
+         KeyBytes kbOld;
+         keyOf(pOld, kbOld);
+         int cmp = compareBytes(kb, kbOld);
+         if (cmp == 0)
+            return std::make_pair(iterator(this, pOld), false);
+
+         size_t common = depth;
+         while (common < kb.len && common < kbOld.len && kb.p[common] == kbOld.p[common])
+            common++;
+         Leaf * pNew = new Leaf(std::forward<Args>(args)...);
+         Node4 * pNode = new Node4;
+         setPrefix(pNode, kb, depth, common - depth);
+         attach(pNode, kbOld, common, pOld);
+         attach(pNode, kb, common, pNew);
+         *pRef = pNode;
+         if (cmp < 0)
+            linkBefore(pNew, pOld);
+         else
+            linkAfter(pNew, pOld);
+         numElements++;
+         return std::make_pair(iterator(this, pNew), true);
+      }
+
+      // the key parts from the prefix: a new Node4 above takes the shared part
+      size_t shared = prefixMismatch(p, kb, depth);
+      if (shared < p->prefixLen)
+      {
+         KeyBytes kbMin;
+         keyOf(minimum(p), kbMin);
+         uint8_t b = kbMin.p[depth + shared];
+         bool before = depth + shared == kb.len || kb.p[depth + shared] < b;
+         Leaf * pNeighbor = before ? minimum(p) : maximum(p);
+
+         Leaf * pNew = new Leaf(std::forward<Args>(args)...);
+         Node4 * pNode = new Node4;
+         setPrefix(pNode, kbMin, depth, shared);
+         setPrefix(p, kbMin, depth + shared + 1, p->prefixLen - shared - 1);
+         addChild(nullptr, pNode, b, p);
+         attach(pNode, kb, depth + shared, pNew);
+         *pRef = pNode;
+         if (before)
+            linkBefore(pNew, pNeighbor);
+         else
+            linkAfter(pNew, pNeighbor);
+         numElements++;
+         return std::make_pair(iterator(this, pNew), true);
+      }
+      depth += p->prefixLen;
+
+      // the key ends at this node
+      if (depth == kb.len)
+      {
+         if (p->pLeaf)
+            return std::make_pair(iterator(this, p->pLeaf), false);
+         Leaf * pNew = new Leaf(std::forward<Args>(args)...);
+         linkBefore(pNew, minimum(p));
+         p->pLeaf = pNew;
+         numElements++;
+         return std::make_pair(iterator(this, pNew), true);
+      }
+
+      uint8_t b = kb.p[depth];
+      Node ** pChild = findChild(p, b);
+      if (pChild)
+      {
+         pRef = pChild;
+         depth++;
+         continue;
+      }
+
+      // a new child of this node
+      Leaf * pNew = new Leaf(std::forward<Args>(args)...);
+      Node * pPrev = prevChild(p, b);
+      if (pPrev)
+         linkAfter(pNew, maximum(pPrev));
+      else if (p->pLeaf)
+         linkAfter(pNew, p->pLeaf);
+      else
+         linkBefore(pNew, minimum(nextChild(p, b)));
+      addChild(pRef, p, b, tag(pNew));
+      numElements++;
+      return std::make_pair(iterator(this, pNew), true);
+   }
+}
+
+/*****************************************************
+ * RADIX TREE :: ERASE
+ * Go down as find() does, remembering where each
+ * node hangs, and take the leaf away. A node left
+ * with one thing under it is folded away: into its
+ * leaf, or into its child's prefix
+ *   OUTPUT : how many elements were erased, 0 or 1
+ *   COST   : O(k)
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+size_t radix_tree <T, K, KeyOf> :: erase(const K & key)
+{
+   KeyBytes kb;
+   RadixKey<K>::bytes(key, kb);
+   if (root == nullptr)
+      return 0;
+
+   KeyBytes kbLeaf;
+   if (isLeaf(root))
+   {
+      keyOf(asLeaf(root), kbLeaf);
+      if (compareBytes(kbLeaf, kb) != 0)
+         return 0;
+      removeLeaf(asLeaf(root));
+      root = nullptr;
+      return 1;
+   }
+
+   Node ** pRef = &root;
+   size_t depth = 0;
+   while (true)
+   {
+      Node * p = *pRef;
+      size_t depthNode = depth;
+      size_t kept = p->prefixLen < maxPrefix ? p->prefixLen : maxPrefix;
+      for (size_t i = 0; i < kept; i++)
+         if (depth + i >= kb.len || p->prefix[i] != kb.p[depth + i])
+            return 0;
+      depth += p->prefixLen;
+      if (depth > kb.len)
+         return 0;
+
+      if (depth == kb.len)
+      {
+         if (p->pLeaf == nullptr)
+            return 0;
+         keyOf(p->pLeaf, kbLeaf);
+         if (compareBytes(kbLeaf, kb) != 0)
+            return 0;
+         removeLeaf(p->pLeaf);
+         p->pLeaf = nullptr;
+         collapse(pRef, p, depthNode);
+         return 1;
+      }
+
+      uint8_t b = kb.p[depth];
+      Node ** pChild = findChild(p, b);
+      if (pChild == nullptr)
+         return 0;
+      if (isLeaf(*pChild))
+      {
+         keyOf(asLeaf(*pChild), kbLeaf);
+         if (compareBytes(kbLeaf, kb) != 0)
+            return 0;
+         removeLeaf(asLeaf(*pChild));
+         removeChild(pRef, p, b);
+         collapse(pRef, *pRef, depthNode);
+         return 1;
+      }
+      pRef = pChild;
+      depth++;
+   }
+}
+
+template <typename T, typename K, typename KeyOf>
+typename radix_tree <T, K, KeyOf> :: iterator
+radix_tree <T, K, KeyOf> :: erase(iterator it)
+{
+   if (it.pLeaf == nullptr)
+      return end();
+   iterator itNext(this, it.pLeaf->pNext);
+   erase(KeyOf()(it.pLeaf->value));
+   return itNext;
+}
+
+/*****************************************************
+ * RADIX TREE :: COLLAPSE
+ * A node with only one thing under it is not needed.
+ * If that is a leaf, the leaf takes its place; if it
+ * is a node, that node takes its place with the two
+ * prefixes and the byte between them as its prefix
+ *   INPUT  : where the node hangs, the node, and the
+ *            depth its prefix starts at
+ ****************************************************/
+template <typename T, typename K, typename KeyOf>
+void radix_tree <T, K, KeyOf> :: collapse(Node ** pRef, Node * pNode, size_t depth)
+{
+   if (pNode->numChildren + (pNode->pLeaf ? 1 : 0) != 1)
+      return;
+
+   Node * pOnly = pNode->pLeaf ? tag(pNode->pLeaf) : firstChild(pNode);
+   if (!isLeaf(pOnly))
+   {
+      KeyBytes kbMin;
+      keyOf(minimum(pOnly), kbMin);
+      setPrefix(pOnly, kbMin, depth, pNode->prefixLen + 1 + pOnly->prefixLen);
+   }
+   *pRef = pOnly;
+   freeNode(pNode);
+}
+
+} // namespace custom
@@ -0,0 +1,230 @@
+/***********************************************************************
+ * Header:
+ *    RECLAIMER
+ * Summary:
+ *    Deferred destruction of big containers. Freeing a tree of millions
+ *    of nodes, a vector of heavy objects, or a long Node<T> chain costs
+ *    time proportional to its size, which is latency on whatever thread
+ *    lets go of it. A Reclaimer takes the container off that thread in
+ *    O(1): the container is moved into a small holder (for a BST or
+ *    vector that steals the root or the buffer) and the holder goes on a
+ *    list. A background thread takes the whole list at once each time
+ *    it wakes and destroys what is on it.
+ *
+ *    Nothing is shared with the thread that retired a container, so any
+ *    container that can be moved can be retired. The elements' own
+ *    destructors run on the background thread. On Linux that thread is
+ *    niced, so it gives way to real work without being starved on a busy
+ *    machine. Should it still fall behind, the backlog is capped: past
+ *    maxPending containers waiting, retire() destroys on the caller.
+ *
+ *    This will contain the class definition of:
+ *        Reclaimer      : A background thread that destroys containers
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <condition_variable>  // for std::condition_variable
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <type_traits>         // for std::is_lvalue_reference
+#include <utility>             // for std::move
+#include "node.h"              // for Node and clear()
+
+#ifdef __linux__
+#include <sys/resource.h>      // for setpriority
+#endif // __linux__
+
+namespace custom
+{
+
+/*************************************************
+ * RECLAIMER
+ * Owns one background thread. Destroying the
+ * Reclaimer destroys whatever is still pending and
+ * then stops the thread
+ *************************************************/
+class Reclaimer
+{
+public:
+   explicit Reclaimer(size_t maxPending = 1024) : pPending(nullptr), numRetired(0), numFreed(0),
+                                                  numInline(0), maxPending(maxPending), stopping(false)
+   {
+      thread = std::thread([this]() { run(); });
+   }
+   Reclaimer(const Reclaimer &) = delete;
+   Reclaimer & operator = (const Reclaimer &) = delete;
+   ~Reclaimer()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stopping = true;
+      }
+      wake.notify_one();
+      thread.join();
+   }
+
+   /***********************************************
+    * RETIRE
+    * Hand over a container to be destroyed in the
+    * background, leaving it empty. It must be moved
+    * in, as retire(std::move(tree)), so that no copy
+    * is ever made by accident
+    *   COST   : O(1): one small allocation, a move,
+    *            and a lock held for two stores
+    **********************************************/
+   template <class C>
+   void retire(C && c)
+   {
+      static_assert(!std::is_lvalue_reference<C>::value,
+                    "retire() takes the container by std::move");
+      push(new Holder<C>(std::move(c)));
+   }
+
+   // a raw list is handed over by its head, which is left nullptr
+   template <class T>
+   void retire(Node <T> * & pHead)
+   {
+      if (pHead == nullptr)
+         return;
+      push(new ListHolder<T>(pHead));
+      pHead = nullptr;
+   }
+
+   /***********************************************
+    * DRAIN
+    * Wait until everything retired so far has been
+    * destroyed
+    **********************************************/
+   void drain()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      size_t target = numRetired;
+      idle.wait(lock, [this, target]() { return numFreed >= target; });
+   }
+
+   // how many retired containers are not destroyed yet
+   size_t pending()
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return numRetired - numFreed;
+   }
+
+   // how many were destroyed by retire() itself because of the cap
+   size_t inlined()
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return numInline;
+   }
+
+private:
+   /***********************************************
+    * HOLDERS
+    * Whatever was retired, behind one virtual
+    * destructor so the list holds any type
+    **********************************************/
+   struct Retired
+   {
+      Retired() : pNext(nullptr) {}
+      virtual ~Retired() {}
+      Retired * pNext;
+   };
+
+   template <class C>
+   struct Holder : Retired
+   {
+      explicit Holder(C && c) : c(std::move(c)) {}
+      C c;
+   };
+
+   template <class T>
+   struct ListHolder : Retired
+   {
+      explicit ListHolder(Node <T> * pHead) : pHead(pHead) {}
+      ~ListHolder() { ::clear(pHead); }
+      Node <T> * pHead;
+   };
+
+   // queue p for the thread, or destroy it here if the thread is too far behind
+   void push(Retired * p)
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (numRetired - numFreed < maxPending)
+         {
+            p->pNext = pPending;
+            pPending = p;
+            numRetired++;
+            p = nullptr;
+         }
+         else
+            numInline++;
+      }
+      if (p == nullptr)
+         wake.notify_one();
+      else
+         delete p;
+   }
+
+   /***********************************************
+    * RUN
+    * Take every pending holder at once, oldest first,
+    * and destroy them with the lock released. Anything
+    * retired meanwhile waits for the next batch
+    **********************************************/
+   void run()
+   {
+#ifdef __linux__
+      // a nice of 10 is a tenth of a core's share: it gives way to the
+      // threads doing real work but, unlike SCHED_IDLE, is never starved
+      setpriority(PRIO_PROCESS, 0 /*this thread*/, 10);
+#endif // __linux__
+
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+         wake.wait(lock, [this]() { return pPending != nullptr || stopping; });
+         if (pPending == nullptr)
+            return;
+
+         // the list is newest first
+         Retired * pBatch = nullptr;
+         while (pPending != nullptr)
+         {
+            Retired * p = pPending;
+            pPending = p->pNext;
+            p->pNext = pBatch;
+            pBatch = p;
+         }
+
+         lock.unlock();
+         size_t num = 0;
+         while (pBatch != nullptr)
+         {
+            Retired * p = pBatch;
+            pBatch = p->pNext;
+            delete p;
+            num++;
+         }
+         lock.lock();
+
+         numFreed += num;
+         idle.notify_all();
+      }
+   }
+
+   Retired * pPending;            // retired and not yet taken, newest first
+   size_t numRetired;             // ever retired
+   size_t numFreed;               // ever destroyed
+   size_t numInline;              // destroyed by retire() past the cap
+   size_t maxPending;             // retired but not destroyed before the cap
+   bool stopping;                 // the destructor is waiting for the thread
+   std::mutex mutex;              // guards everything above
+   std::condition_variable wake;  // something was retired, or stopping
+   std::condition_variable idle;  // a batch was destroyed
+   std::thread thread;
+};
+
+} // namespace custom
@@ -0,0 +1,413 @@
+/***********************************************************************
+ * Header:
+ *    SERIALIZE
+ * Summary:
+ *    Save our containers to a binary stream and load them back. Every
+ *    snapshot starts with a small header (what kind of container, how
+ *    the elements are stored, and how many there are) followed by the
+ *    elements in order:
+ *
+ *        "C232" | version | kind | encoding | size of T | count | elements
+ *
+ *    Trivially copyable elements are written as raw blocks of memory
+ *    in the machine's own byte order. Anything else goes through a
+ *    Serializer, which knows std::string and std::pair. Trees are
+ *    written in sorted order so they load in linear time with no
+ *    comparisons. Trees and lists pass through a fixed-size block
+ *    buffer, so saving or loading one takes bounded memory no matter
+ *    how big it is.
+ *
+ *    This will contain:
+ *        Serializer<T>    : How to write and read one element
+ *        save()           : Write a vector, BST, or Node list
+ *        load()           : Read one back, replacing what was there
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t
+#include <cstring>      // for memcmp and memcpy
+#include <functional>   // for std::ref
+#include <ios>          // for std::ios_base::failure
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>  // for std::is_trivially_copyable
+#include <utility>      // for std::pair
+#include "vector.h"
+#include "bst.h"
+#include "node.h"
+
+namespace custom
+{
+
+/*****************************************************************
+ * SERIALIZER
+ * How one element goes to and from a stream. Trivially copyable
+ * types are raw, and are moved in blocks rather than one at a time
+ *****************************************************************/
+template <typename T, typename = void>
+struct Serializer
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "specialize custom::Serializer to save this type");
+   static const bool raw = true;
+   static void write(std::ostream & out, const T & t) { out.write((const char *)&t, sizeof(T)); }
+   static bool read (std::istream & in,        T & t) { return (bool)in.read((char *)&t, sizeof(T)); }
+};
+
+template <>
+struct Serializer <std::string>
+{
+   static const bool raw = false;
+   static void write(std::ostream & out, const std::string & s)
+   {
+      uint64_t length = s.size();
+      out.write((const char *)&length, sizeof(length));
+      out.write(s.data(), (std::streamsize)length);
+   }
+   // a bad length must not size the string before the bytes are there,
+   // so it grows a chunk at a time as they arrive
+   static bool read(std::istream & in, std::string & s)
+   {
+      const uint64_t chunk = 1 << 16;
+      uint64_t length;
+      if (!in.read((char *)&length, sizeof(length)))
+         return false;
+      s.clear();
+      while (length > 0)
+      {
+         size_t num = (size_t)(length < chunk ? length : chunk);
+         size_t old = s.size();
+         s.resize(old + num);
+         if (!in.read(&s[old], (std::streamsize)num))
+            return false;
+         length -= num;
+      }
+      return true;
+   }
+};
+
+template <typename T1, typename T2>
+struct Serializer <std::pair<T1, T2>,
+                   typename std::enable_if<!std::is_trivially_copyable<std::pair<T1, T2> >::value>::type>
+{
+   static const bool raw = false;
+   static void write(std::ostream & out, const std::pair<T1, T2> & p)
+   {
+      Serializer<T1>::write(out, p.first);
+      Serializer<T2>::write(out, p.second);
+   }
+   static bool read(std::istream & in, std::pair<T1, T2> & p)
+   {
+      return Serializer<T1>::read(in, p.first) && Serializer<T2>::read(in, p.second);
+   }
+};
+
+namespace serial
+{
+   enum Kind : uint8_t { VECTOR = 1, TREE = 2, LIST = 3 };
+
+   const char    magic[4] = { 'C', '2', '3', '2' };
+   const uint8_t version = 1;
+   const size_t  blockBytes = 1 << 16;   // the most a tree or list buffers at once
+
+   /*************************************************
+    * HEADER
+    * The fixed part at the front of every snapshot
+    *************************************************/
+   struct Header
+   {
+      char     magic[4];
+      uint8_t  version;
+      uint8_t  kind;
+      uint8_t  raw;        // 1 when the elements are stored as raw memory
+      uint8_t  unused;
+      uint32_t sizeofT;    // sizeof(T) when raw, so a mismatch is caught
+      uint32_t reserved;   // keeps count aligned with no padding to write
+      uint64_t count;      // number of elements that follow
+   };
+
+   template <typename T>
+   inline bool writeHeader(std::ostream & out, Kind kind, size_t count)
+   {
+      Header header = { { magic[0], magic[1], magic[2], magic[3] }, version, kind,
+                        Serializer<T>::raw, 0, Serializer<T>::raw ? (uint32_t)sizeof(T) : 0,
+                        0, (uint64_t)count };
+      out.write((const char *)&header, sizeof(header));
+      return (bool)out;
+   }
+
+   /*************************************************
+    * BYTES LEFT
+    * Between the read position and the end of the
+    * stream, or SIZE_MAX when the stream cannot seek
+    *************************************************/
+   inline size_t bytesLeft(std::istream & in)
+   {
+      std::streampos pos = in.tellg();
+      if (pos == std::streampos(-1))
+         return SIZE_MAX;
+      in.seekg(0, std::ios_base::end);
+      std::streampos end = in.tellg();
+      in.seekg(pos);
+      if (!in || end == std::streampos(-1) || end < pos)
+         return SIZE_MAX;
+      return (size_t)(end - pos);
+   }
+
+   // every element takes at least a byte, a raw one sizeof(T)
+   template <typename T>
+   inline bool readHeader(std::istream & in, Kind kind, size_t & count)
+   {
+      Header header;
+      if (!in.read((char *)&header, sizeof(header)))
+         return false;
+      if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+          header.kind != kind || header.raw != (Serializer<T>::raw ? 1 : 0) ||
+          header.sizeofT != (Serializer<T>::raw ? sizeof(T) : 0))
+         return false;
+      count = (size_t)header.count;
+      return count <= bytesLeft(in) / (Serializer<T>::raw ? sizeof(T) : 1);
+   }
+
+   /*************************************************
+    * BLOCK WRITER
+    * Gather raw elements into one block and write the
+    * block when it fills. Other elements go straight
+    * to the stream, which does its own buffering
+    *************************************************/
+   template <typename T>
+   class BlockWriter
+   {
+   public:
+      BlockWriter(std::ostream & out) : out(out), num(0) {}
+      ~BlockWriter() { flush(); }
+      void write(const T & t)
+      {
+         if constexpr (!Serializer<T>::raw)
+            Serializer<T>::write(out, t);
+         else
+         {
+            memcpy(block + num * sizeof(T), &t, sizeof(T));
+            if (++num == capacity)
+               flush();
+         }
+      }
+      void flush()
+      {
+         out.write(block, (std::streamsize)(num * sizeof(T)));
+         num = 0;
+      }
+   private:
+      static const size_t capacity = Serializer<T>::raw ? (blockBytes / sizeof(T) ? blockBytes / sizeof(T) : 1) : 1;
+      std::ostream & out;
+      size_t num;
+      char block[Serializer<T>::raw ? capacity * sizeof(T) : 1];
+   };
+
+   /*************************************************
+    * BLOCK READER
+    * Hand out count elements one at a time, reading
+    * raw ones a block at a time. A short read throws,
+    * so whatever is being built stops right there
+    *************************************************/
+   template <typename T>
+   class BlockReader
+   {
+   public:
+      BlockReader(std::istream & in, size_t count) : in(in), numLeft(count), num(0), next(0) {}
+      T operator () ()
+      {
+         T t = T();
+         if constexpr (!Serializer<T>::raw)
+         {
+            if (!Serializer<T>::read(in, t))
+               throw std::ios_base::failure("custom::load: the stream ended early");
+         }
+         else
+         {
+            if (next == num)
+               fill();
+            memcpy(&t, block + next++ * sizeof(T), sizeof(T));
+         }
+         return t;
+      }
+   private:
+      void fill()
+      {
+         num = numLeft < capacity ? numLeft : capacity;
+         next = 0;
+         numLeft -= num;
+         if (num == 0 || !in.read(block, (std::streamsize)(num * sizeof(T))))
+            throw std::ios_base::failure("custom::load: the stream ended early");
+      }
+      static const size_t capacity = Serializer<T>::raw ? (blockBytes / sizeof(T) ? blockBytes / sizeof(T) : 1) : 1;
+      std::istream & in;
+      size_t numLeft;      // elements not yet read from the stream
+      size_t num;          // elements in the block
+      size_t next;         // the next one to hand out
+      char block[Serializer<T>::raw ? capacity * sizeof(T) : 1];
+   };
+} // namespace serial
+
+/*****************************************************
+ * SAVE and LOAD : VECTOR
+ * Raw elements go straight from and into the
+ * vector's own buffer: out in one block, back in
+ * blocks so a bad count cannot size the vector
+ *   OUTPUT : whether the stream took / gave it all.
+ *            A failed load leaves the vector empty
+ ****************************************************/
+template <typename T, typename A>
+bool save(std::ostream & out, const vector<T, A> & v)
+{
+   if (!serial::writeHeader<T>(out, serial::VECTOR, v.size()))
+      return false;
+   if constexpr (Serializer<T>::raw)
+   {
+      if (v.size())
+         out.write((const char *)&v[0], (std::streamsize)(v.size() * sizeof(T)));
+   }
+   else
+      for (size_t i = 0; i < v.size(); i++)
+         Serializer<T>::write(out, v[i]);
+   return (bool)out;
+}
+
+template <typename T, typename A>
+bool load(std::istream & in, vector<T, A> & v)
+{
+   v.clear();
+   size_t count;
+   if (!serial::readHeader<T>(in, serial::VECTOR, count))
+      return false;
+
+   // count is only bounded by the stream when it can seek, so the
+   // vector grows a block at a time as the elements actually arrive
+   bool fOK = true;
+   try
+   {
+      if constexpr (Serializer<T>::raw)
+      {
+         const size_t chunk = serial::blockBytes / sizeof(T) ? serial::blockBytes / sizeof(T) : 1;
+         for (size_t done = 0; fOK && done < count; )
+         {
+            size_t num = count - done < chunk ? count - done : chunk;
+            if (done + num > v.capacity())
+               v.reserve(done + num > 2 * v.capacity() ? done + num : 2 * v.capacity());
+            v.resize(done + num);
+            fOK = (bool)in.read((char *)&v[done], (std::streamsize)(num * sizeof(T)));
+            done += num;
+         }
+      }
+      else
+      {
+         T t;
+         for (size_t i = 0; fOK && i < count; i++)
+            if ((fOK = Serializer<T>::read(in, t)))
+               v.push_back(std::move(t));
+      }
+   }
+   catch (...)
+   {
+      fOK = false;
+   }
+   if (!fOK)
+      v.clear();
+   return fOK;
+}
+
+/*****************************************************
+ * SAVE and LOAD : BST
+ * The elements go out in order, so they come back
+ * through assign_sorted() with no comparisons
+ *   COST   : O(n) both ways
+ ****************************************************/
+template <typename T, typename C>
+bool save(std::ostream & out, const BST<T, C> & bst)
+{
+   if (!serial::writeHeader<T>(out, serial::TREE, bst.size()))
+      return false;
+   {
+      serial::BlockWriter<T> writer(out);
+      bst.for_each([&writer](const T & t) { writer.write(t); });
+   }
+   return (bool)out;
+}
+
+template <typename T, typename C>
+bool load(std::istream & in, BST<T, C> & bst)
+{
+   bst.clear();
+   size_t count;
+   if (!serial::readHeader<T>(in, serial::TREE, count))
+      return false;
+
+   // a short read or a failed allocation stops the build, which
+   // frees the nodes it made and leaves the tree empty
+   try
+   {
+      serial::BlockReader<T> reader(in, count);
+      bst.assign_sorted(count, std::ref(reader));
+   }
+   catch (...)
+   {
+      bst.clear();
+      return false;
+   }
+   return true;
+}
+
+/*****************************************************
+ * SAVE and LOAD : NODE LIST
+ * A list is saved from pHead to the end; loading
+ * replaces the list pHead points to
+ ****************************************************/
+template <typename T>
+bool save(std::ostream & out, const Node<T> * pHead)
+{
+   if (!serial::writeHeader<T>(out, serial::LIST, ::size(pHead)))
+      return false;
+   {
+      serial::BlockWriter<T> writer(out);
+      for (const Node<T> * p = pHead; p; p = p->pNext)
+         writer.write(p->data);
+   }
+   return (bool)out;
+}
+
+template <typename T>
+bool load(std::istream & in, Node<T> * & pHead)
+{
+   ::clear(pHead);
+   size_t count;
+   if (!serial::readHeader<T>(in, serial::LIST, count))
+      return false;
+
+   try
+   {
+      serial::BlockReader<T> reader(in, count);
+      Node<T> * pTail = nullptr;
+      for (size_t i = 0; i < count; i++)
+      {
+         Node<T> * pNode = new Node<T>(reader());
+         pNode->pPrev = pTail;
+         if (pTail)
+            pTail->pNext = pNode;
+         else
+            pHead = pNode;
+         pTail = pNode;
+      }
+   }
+   catch (...)
+   {
+      ::clear(pHead);
+      return false;
+   }
+   return true;
+}
+
+} // namespace custom
@@ -0,0 +1,853 @@
+/***********************************************************************
+ * Header:
+ *    SKIP LIST
+ * Summary:
+ *    A concurrent ordered index with the same insert, find, erase, and
+ *    iterator interface as BST. Where every insert into the red-black
+ *    tree may rotate nodes near the root, an insert or erase here only
+ *    locks the handful of nodes right before the one it changes, so
+ *    writers working on different keys do not get in each other's way.
+ *    find() and iteration take no locks at all.
+ *
+ *    This is the "lazy" skip list: a node is first marked as erased and
+ *    only then unlinked, and a node only counts as present once it is
+ *    linked at every level. Unlinked nodes are freed by epochs: every
+ *    operation and every iterator pins the epoch it started in, and a
+ *    node is freed once no pin is left from before it was unlinked.
+ *
+ *    This will contain the class definition of:
+ *        skip_list           : A concurrent ordered collection
+ *        skip_list::iterator : An iterator through skip_list
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include <cstdint>     // for uint64_t
+#include <initializer_list>
+#include <mutex>       // for std::mutex
+#include <new>         // for placement new
+#include <thread>      // for std::this_thread::yield
+#include <utility>     // for std::pair
+
+class TestSkipList; // forward declaration for unit tests
+
+namespace custom
+{
+
+/*****************************************************************
+ * SKIP LIST
+ * insert(), find(), erase(), and iteration may be called from any
+ * number of threads at once. Construction, assignment, swap, and
+ * clear() may not.
+ *
+ * Erased nodes are unlinked right away and freed two epochs later,
+ * once no reader can still be standing on one, so readers need neither
+ * locks nor hazard pointers. The epoch only moves on when nothing is
+ * pinned in the one before it: an iterator kept alive holds back every
+ * node erased after it was made, until it is destroyed or reaches end().
+ *****************************************************************/
+template <typename T>
+class skip_list
+{
+   friend class ::TestSkipList; // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+
+   skip_list();
+   skip_list(const skip_list &  rhs);
+   skip_list(      skip_list && rhs);
+   skip_list(const std::initializer_list<T>& il);
+   ~skip_list();
+
+   //
+   // Assign
+   //
+
+   skip_list & operator = (const skip_list &  rhs);
+   skip_list & operator = (      skip_list && rhs);
+   skip_list & operator = (const std::initializer_list<T>& il);
+   void swap(skip_list & rhs);
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   iterator   begin() const noexcept;
+   iterator   end()   const noexcept { return iterator(nullptr, pHead, Pin(this)); }
+
+   //
+   // Access
+   //
+
+   iterator find(const T& t) const;
+
+   //
+   // Insert
+   //
+
+   std::pair<iterator, bool> insert(const T&  t, bool keepUnique = false);
+   std::pair<iterator, bool> insert(      T&& t, bool keepUnique = false);
+
+   //
+   // Remove
+   //
+
+   iterator erase(iterator& it);
+   void   clear() noexcept;
+
+   //
+   // Status
+   //
+
+   bool   empty() const noexcept { return size() == 0; }
+   size_t size()  const noexcept { return numElements.load(std::memory_order_relaxed); }
+
+private:
+
+   static const int maxHeight = 16;  // 4^16 elements before searches slow down
+
+   class SNode;
+   class Pin;
+   template <class U>
+   std::pair<iterator, bool> insertNode(U && t, bool keepUnique);
+   int search(const T & t, bool after, SNode ** preds, SNode ** succs) const;
+   static int randomHeight();
+   static void unlock(SNode ** preds, int height);
+   void retire(SNode * pNode);
+   static void destroyAll(SNode * pNode);
+
+   SNode * pHead;                        // sentinel with no value, maxHeight tall
+   std::atomic<size_t> numElements;      // number of elements currently present
+
+   // epoch reclamation: pins counted by the parity of their epoch, and the
+   // nodes unlinked in each of the last three epochs
+   mutable std::atomic<size_t> epoch;
+   mutable std::atomic<size_t> numPinned[2];
+   std::mutex retireLock;                // guards pRetired and moving the epoch on
+   SNode * pRetired[3];
+};
+
+/*****************************************************************
+ * SKIP LIST NODE
+ * A value and a tower of next pointers, allocated together so
+ * short nodes stay short. The tower is next[0..height-1].
+ *****************************************************************/
+template <typename T>
+class skip_list <T> :: SNode
+{
+public:
+   static SNode * create(int height)
+   {
+      void * p = ::operator new(sizeof(SNode) + (height - 1) * sizeof(std::atomic<SNode *>));
+      return new (p) SNode(height);
+   }
+   template <class U>
+   static SNode * create(int height, U && t)
+   {
+      SNode * pNode = create(height);
+      new ((void *)pNode->buffer) T(std::forward<U>(t));
+      return pNode;
+   }
+   static void destroy(SNode * pNode, bool hasValue)
+   {
+      if (hasValue)
+         pNode->data().~T();
+      pNode->~SNode();
+      ::operator delete((void *)pNode);
+   }
+
+   T & data() { return *(T *)buffer; }
+
+   // a spin lock: held only while a few pointers are swapped
+   void lock()
+   {
+      while (locked.exchange(true, std::memory_order_acquire))
+         std::this_thread::yield();
+   }
+   void unlock() { locked.store(false, std::memory_order_release); }
+
+   std::atomic<bool> marked;        // erased, or about to be unlinked
+   std::atomic<bool> fullyLinked;   // linked at every level of its tower
+   std::atomic<bool> locked;
+   int height;                      // levels in the tower
+   SNode * pRetired;                // next in its epoch's retired list
+   alignas(T) unsigned char buffer[sizeof(T)];   // the value, if any
+   std::atomic<SNode *> next[1];    // really next[height]
+
+private:
+   SNode(int height) : marked(false), fullyLinked(false), locked(false),
+                       height(height), pRetired(nullptr)
+   {
+      for (int i = 0; i < height; i++)
+         new (&next[i]) std::atomic<SNode *>(nullptr);
+   }
+};
+
+/**********************************************************
+ * SKIP LIST PIN
+ * Holds the epoch it was made in, so no node unlinked since
+ * is freed while it lives. A copy shares the epoch of the
+ * original: it may be standing on a node that only the
+ * original's epoch protects.
+ *********************************************************/
+template <typename T>
+class skip_list <T> :: Pin
+{
+public:
+   // no list, or a list with nothing pinned in it
+   explicit Pin(const skip_list <T> * pList = nullptr) : pList(pList), epoch(0), pinned(false) {}
+
+   Pin(const Pin & rhs) : pList(rhs.pList), epoch(rhs.epoch), pinned(rhs.pinned)
+   {
+      if (pinned)
+         pList->numPinned[epoch & 1].fetch_add(1);
+   }
+   Pin(Pin && rhs) noexcept : pList(rhs.pList), epoch(rhs.epoch), pinned(rhs.pinned)
+   {
+      rhs.pinned = false;
+   }
+   Pin & operator = (Pin rhs) noexcept
+   {
+      std::swap(pList, rhs.pList);
+      std::swap(epoch, rhs.epoch);
+      std::swap(pinned, rhs.pinned);
+      return *this;
+   }
+  ~Pin() { release(); }
+
+   // count ourselves in the current epoch, unless it moved on meanwhile
+   static Pin enter(const skip_list <T> * pList)
+   {
+      Pin pin(pList);
+      while (true)
+      {
+         pin.epoch = pList->epoch.load();
+         pList->numPinned[pin.epoch & 1].fetch_add(1);
+         if (pList->epoch.load() == pin.epoch)
+            break;
+         pList->numPinned[pin.epoch & 1].fetch_sub(1);
+      }
+      pin.pinned = true;
+      return pin;
+   }
+
+   void release()
+   {
+      if (pinned)
+         pList->numPinned[epoch & 1].fetch_sub(1);
+      pinned = false;
+   }
+
+   // behind the list's epoch, and so holding it back
+   bool isStale() const { return pinned && pList->epoch.load() != epoch; }
+
+   const skip_list <T> * pList;
+   size_t epoch;
+   bool pinned;
+};
+
+/**********************************************************
+ * SKIP LIST ITERATOR
+ * Forward and reverse iterator through a skip_list. Moving
+ * forward follows the bottom level; moving back searches
+ * from the top for the predecessor.
+ *********************************************************/
+template <typename T>
+class skip_list <T> :: iterator
+{
+   friend class ::TestSkipList; // give unit tests access to the privates
+   friend class skip_list <T>;
+public:
+   // constructors and assignment
+   iterator() : pNode(nullptr), pHead(nullptr) {}
+   iterator(SNode * p, SNode * pHead, const Pin & pin) : pNode(p), pHead(pHead), pin(pin) {}
+   iterator(const iterator & rhs) = default;
+   iterator(iterator && rhs) = default;
+   iterator & operator = (const iterator & rhs) = default;
+   iterator & operator = (iterator && rhs) = default;
+
+   // compare
+   bool operator == (const iterator & rhs) const { return pNode == rhs.pNode; }
+   bool operator != (const iterator & rhs) const { return pNode != rhs.pNode; }
+
+   // de-reference. Cannot change because it will invalidate the skip_list
+   const T & operator * () const { return pNode->data(); }
+
+   // increment and decrement
+   iterator & operator ++ ();
+   iterator   operator ++ (int postfix)
+   {
+      iterator temp = *this;
+      ++*this;
+      return temp;
+   }
+   iterator & operator -- ();
+   iterator   operator -- (int postfix)
+   {
+      iterator temp = *this;
+      --*this;
+      return temp;
+   }
+
+private:
+   void repin();
+
+   SNode * pNode;   // the node, NULL for end()
+   SNode * pHead;   // the sentinel, for searching backwards
+   Pin pin;         // keeps pNode from being freed
+};
+
+
+/*********************************************
+ *********************************************
+ *********************************************
+ ***************** SKIP LIST *****************
+ *********************************************
+ *********************************************
+ *********************************************/
+
+
+/*********************************************
+ * SKIP LIST :: DEFAULT CONSTRUCTOR
+ ********************************************/
+template <typename T>
+skip_list <T> :: skip_list() : numElements(0), epoch(0), pRetired{ nullptr, nullptr, nullptr }
+{
+   numPinned[0].store(0);
+   numPinned[1].store(0);
+   pHead = SNode::create(maxHeight);
+   pHead->fullyLinked.store(true);
+}
+
+/*********************************************
+ * SKIP LIST :: COPY CONSTRUCTOR
+ * Copy one list to another
+ ********************************************/
+template <typename T>
+skip_list <T> :: skip_list(const skip_list <T> & rhs) : skip_list()
+{
+   *this = rhs;
+}
+
+/*********************************************
+ * SKIP LIST :: MOVE CONSTRUCTOR
+ * Take the nodes of rhs, leaving it empty
+ ********************************************/
+template <typename T>
+skip_list <T> :: skip_list(skip_list <T> && rhs) : skip_list()
+{
+   swap(rhs);
+}
+
+/*********************************************
+ * SKIP LIST :: INITIALIZER LIST CONSTRUCTOR
+ ********************************************/
+template <typename T>
+skip_list <T> :: skip_list(const std::initializer_list<T>& il) : skip_list()
+{
+   *this = il;
+}
+
+/*********************************************
+ * SKIP LIST :: DESTRUCTOR
+ ********************************************/
+template <typename T>
+skip_list <T> :: ~skip_list()
+{
+   clear();
+   SNode::destroy(pHead, false /*hasValue*/);
+}
+
+/*********************************************
+ * SKIP LIST :: ASSIGNMENT OPERATOR
+ * Copy the elements of rhs in order. rhs is
+ * already sorted, so every element goes at the end
+ *   COST   : O(n)
+ ********************************************/
+template <typename T>
+skip_list <T> & skip_list <T> :: operator = (const skip_list <T> & rhs)
+{
+   if (this == &rhs)
+      return *this;
+   clear();
+
+   // the last node at each level, where the next node is linked
+   SNode * tails[maxHeight];
+   for (int level = 0; level < maxHeight; level++)
+      tails[level] = pHead;
+
+   size_t num = 0;
+   for (iterator it = rhs.begin(); it != rhs.end(); ++it, ++num)
+   {
+      SNode * pNew = SNode::create(randomHeight(), *it);
+      for (int level = 0; level < pNew->height; level++)
+      {
+         tails[level]->next[level].store(pNew, std::memory_order_relaxed);
+         tails[level] = pNew;
+      }
+      pNew->fullyLinked.store(true, std::memory_order_relaxed);
+   }
+   numElements.store(num);
+   return *this;
+}
+
+/*********************************************
+ * SKIP LIST :: ASSIGN-MOVE OPERATOR
+ ********************************************/
+template <typename T>
+skip_list <T> & skip_list <T> :: operator = (skip_list <T> && rhs)
+{
+   if (this == &rhs)
+      return *this;
+   clear();
+   swap(rhs);
+   return *this;
+}
+
+/*********************************************
+ * SKIP LIST :: ASSIGNMENT OPERATOR with INITIALIZATION LIST
+ ********************************************/
+template <typename T>
+skip_list <T> & skip_list <T> :: operator = (const std::initializer_list<T>& il)
+{
+   clear();
+   for (const T & value : il)
+      insert(value);
+   return *this;
+}
+
+/*********************************************
+ * SKIP LIST :: SWAP
+ * Swap two lists
+ ********************************************/
+template <typename T>
+void skip_list <T> :: swap(skip_list <T> & rhs)
+{
+   // the pins stay with each list: they count iterators made from it
+   std::swap(pHead, rhs.pHead);
+   for (int i = 0; i < 3; i++)
+      std::swap(pRetired[i], rhs.pRetired[i]);
+   numElements.store(rhs.numElements.exchange(numElements.load()));
+}
+
+/*********************************************
+ * SKIP LIST :: BEGIN
+ * The first element still present
+ ********************************************/
+template <typename T>
+typename skip_list <T> :: iterator skip_list <T> :: begin() const noexcept
+{
+   iterator it(pHead, pHead, Pin::enter(this));
+   return ++it;
+}
+
+/*****************************************************
+ * SKIP LIST :: SEARCH
+ * Find where t goes on every level. preds[level] is the
+ * last node before t and succs[level] the node after it.
+ * With after set, nodes equal to t count as before it,
+ * so a duplicate lands behind its equals.
+ *   OUTPUT : the highest level holding a node equal to t,
+ *            or -1 if there is none
+ *   COST   : O(log n), no locks
+ ****************************************************/
+template <typename T>
+int skip_list <T> :: search(const T & t, bool after, SNode ** preds, SNode ** succs) const
+{
+   int found = -1;
+   SNode * pPred = pHead;
+   SNode * pLimit = nullptr;   // already known to come after t
+   for (int level = maxHeight - 1; level >= 0; level--)
+   {
+      // the node that stopped us a level up often stops us here too,
+      // and comparing it again would cost another cache miss
+      SNode * pCurr = pPred->next[level].load(std::memory_order_acquire);
+      while (pCurr != nullptr && pCurr != pLimit &&
+             (after ? !(t < pCurr->data()) : pCurr->data() < t))
+      {
+         pPred = pCurr;
+         pCurr = pPred->next[level].load(std::memory_order_acquire);
+      }
+      pLimit = pCurr;
+
+      if (found == -1)
+      {
+         if (!after && pCurr != nullptr && !(t < pCurr->data()))
+            found = level;
+         else if (after && pPred != pHead && !(pPred->data() < t))
+            found = level;
+      }
+      preds[level] = pPred;
+      succs[level] = pCurr;
+   }
+   return found;
+}
+
+/*****************************************************
+ * SKIP LIST :: FIND
+ * Find the first element equal to t
+ *   COST   : O(log n), no locks
+ ****************************************************/
+template <typename T>
+typename skip_list <T> :: iterator skip_list <T> :: find(const T & t) const
+{
+   Pin pin = Pin::enter(this);
+   SNode * preds[maxHeight];
+   SNode * succs[maxHeight];
+   search(t, false /*after*/, preds, succs);
+
+   // skip over equal nodes that are half inserted or being erased
+   for (SNode * p = succs[0]; p != nullptr && !(t < p->data());
+        p = p->next[0].load(std::memory_order_acquire))
+      if (p->fullyLinked.load(std::memory_order_acquire) &&
+          !p->marked.load(std::memory_order_acquire))
+         return iterator(p, pHead, pin);
+   return end();
+}
+
+/*****************************************************
+ * SKIP LIST :: INSERT
+ * Insert t. If keepUnique is set and t is already
+ * present, nothing is inserted and the existing
+ * element is returned.
+ *   COST   : O(log n), locks at most height nodes
+ ****************************************************/
+template <typename T>
+std::pair<typename skip_list <T> :: iterator, bool> skip_list <T> :: insert(const T & t, bool keepUnique)
+{
+   return insertNode(t, keepUnique);
+}
+
+template <typename T>
+std::pair<typename skip_list <T> :: iterator, bool> skip_list <T> :: insert(T && t, bool keepUnique)
+{
+   return insertNode(std::move(t), keepUnique);
+}
+
+template <typename T>
+template <class U>
+std::pair<typename skip_list <T> :: iterator, bool> skip_list <T> :: insertNode(U && t, bool keepUnique)
+{
+   Pin pin = Pin::enter(this);
+   int height = randomHeight();
+   SNode * preds[maxHeight];
+   SNode * succs[maxHeight];
+
+   while (true)
+   {
+      int found = search(t, !keepUnique /*after*/, preds, succs);
+      if (keepUnique && found != -1)
+      {
+         SNode * pFound = succs[found];
+         if (!pFound->marked.load(std::memory_order_acquire))
+         {
+            // someone else is inserting it: wait until they are done
+            while (!pFound->fullyLinked.load(std::memory_order_acquire))
+               std::this_thread::yield();
+            return std::make_pair(iterator(pFound, pHead, pin), false);
+         }
+         // it is being erased: try again once it is gone
+         std::this_thread::yield();
+         continue;
+      }
+
+      // lock the predecessors bottom up and check nothing moved
+      int numLocked = 0;
+      bool valid = true;
+      for (int level = 0; valid && level < height; level++)
+      {
+         SNode * pPred = preds[level];
+         SNode * pSucc = succs[level];
+         if (level == 0 || pPred != preds[level - 1])
+            pPred->lock();
+         numLocked = level + 1;
+         valid = !pPred->marked.load(std::memory_order_acquire) &&
+                 (pSucc == nullptr || !pSucc->marked.load(std::memory_order_acquire)) &&
+                 pPred->next[level].load(std::memory_order_acquire) == pSucc;
+      }
+
+      if (!valid)
+      {
+         unlock(preds, numLocked);
+         continue;
+      }
+
+      // link from the bottom up so it is in the list as soon as it is in level 0
+      SNode * pNew = SNode::create(height, std::forward<U>(t));
+      for (int level = 0; level < height; level++)
+         pNew->next[level].store(succs[level], std::memory_order_relaxed);
+      for (int level = 0; level < height; level++)
+         preds[level]->next[level].store(pNew, std::memory_order_release);
+      pNew->fullyLinked.store(true, std::memory_order_release);
+      unlock(preds, height);
+
+      numElements.fetch_add(1, std::memory_order_relaxed);
+      return std::make_pair(iterator(pNew, pHead, pin), true);
+   }
+}
+
+/*************************************************
+ * SKIP LIST :: ERASE
+ * Remove the element the iterator refers to. If another
+ * thread erased it first, nothing happens.
+ *   OUTPUT : the element that followed it
+ *   COST   : O(log n), locks at most height + 1 nodes
+ ************************************************/
+template <typename T>
+typename skip_list <T> :: iterator skip_list <T> :: erase(iterator & it)
+{
+   SNode * pVictim = it.pNode;
+   if (pVictim == nullptr)
+      return end();
+   iterator itNext = it;
+   ++itNext;
+
+   // claim the node by marking it. Only the thread that marks it unlinks it
+   pVictim->lock();
+   if (pVictim->marked.load(std::memory_order_acquire) ||
+       !pVictim->fullyLinked.load(std::memory_order_acquire))
+   {
+      pVictim->unlock();
+      return itNext;
+   }
+   pVictim->marked.store(true, std::memory_order_release);
+
+   SNode * preds[maxHeight];
+   SNode * succs[maxHeight];
+   int height = pVictim->height;
+   while (true)
+   {
+      // with duplicates, the victim may be behind other equal nodes
+      search(pVictim->data(), false /*after*/, preds, succs);
+      for (int level = 0; level < height; level++)
+      {
+         SNode * pPred = preds[level];
+         SNode * pCurr = pPred->next[level].load(std::memory_order_acquire);
+         while (pCurr != nullptr && pCurr != pVictim && !(pVictim->data() < pCurr->data()))
+         {
+            pPred = pCurr;
+            pCurr = pPred->next[level].load(std::memory_order_acquire);
+         }
+         preds[level] = pPred;
+      }
+
+      int numLocked = 0;
+      bool valid = true;
+      for (int level = 0; valid && level < height; level++)
+      {
+         SNode * pPred = preds[level];
+         if (level == 0 || pPred != preds[level - 1])
+            pPred->lock();
+         numLocked = level + 1;
+         valid = !pPred->marked.load(std::memory_order_acquire) &&
+                 pPred->next[level].load(std::memory_order_acquire) == pVictim;
+      }
+
+      if (valid)
+         break;
+      unlock(preds, numLocked);
+      std::this_thread::yield();
+   }
+
+   // unlink from the top down. Readers standing on the victim can still
+   // follow its next pointers, so it is only retired, not freed yet
+   for (int level = height - 1; level >= 0; level--)
+      preds[level]->next[level].store(pVictim->next[level].load(std::memory_order_acquire),
+                                      std::memory_order_release);
+   pVictim->unlock();
+   unlock(preds, height);
+
+   numElements.fetch_sub(1, std::memory_order_relaxed);
+   retire(pVictim);
+
+   // itNext shares the pin of it, which may be what holds the epoch back
+   itNext.repin();
+   return itNext;
+}
+
+/*****************************************************
+ * SKIP LIST :: CLEAR
+ * Free every node, including the ones erased earlier
+ *   COST   : O(n)
+ ****************************************************/
+template <typename T>
+void skip_list <T> :: clear() noexcept
+{
+   SNode * p = pHead->next[0].load();
+   while (p != nullptr)
+   {
+      SNode * pNext = p->next[0].load();
+      SNode::destroy(p, true /*hasValue*/);
+      p = pNext;
+   }
+   for (int level = 0; level < maxHeight; level++)
+      pHead->next[level].store(nullptr);
+
+   for (int i = 0; i < 3; i++)
+   {
+      destroyAll(pRetired[i]);
+      pRetired[i] = nullptr;
+   }
+   numElements.store(0);
+}
+
+/*****************************************************
+ * SKIP LIST :: RETIRE
+ * Put an unlinked node on the list of the current epoch.
+ * If nothing is pinned in the epoch before, move on to the
+ * next one and free what was unlinked two epochs back: every
+ * pin that could have reached those nodes is gone
+ *   COST   : O(1), amortized over the nodes freed
+ ****************************************************/
+template <typename T>
+void skip_list <T> :: retire(SNode * pNode)
+{
+   std::lock_guard<std::mutex> guard(retireLock);
+   size_t e = epoch.load();
+   pNode->pRetired = pRetired[e % 3];
+   pRetired[e % 3] = pNode;
+
+   if (numPinned[(e + 1) & 1].load() == 0)
+   {
+      epoch.store(e + 1);
+      destroyAll(pRetired[(e + 2) % 3]);
+      pRetired[(e + 2) % 3] = nullptr;
+   }
+}
+
+/*****************************************************
+ * SKIP LIST :: DESTROY ALL
+ * Free a retired list
+ ****************************************************/
+template <typename T>
+void skip_list <T> :: destroyAll(SNode * pNode)
+{
+   while (pNode != nullptr)
+   {
+      SNode * pNext = pNode->pRetired;
+      SNode::destroy(pNode, true /*hasValue*/);
+      pNode = pNext;
+   }
+}
+
+/*****************************************************
+ * SKIP LIST :: RANDOM HEIGHT
+ * 1 with probability 3/4, 2 with 3/16, and so on.
+ * Each thread has its own generator.
+ ****************************************************/
+template <typename T>
+int skip_list <T> :: randomHeight()
+{
+   thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^
+      (uint64_t)(size_t)&state;
+   state ^= state << 13;
+   state ^= state >> 7;
+   state ^= state << 17;
+
+   int height = 1;
+   for (uint64_t bits = state; height < maxHeight && (bits & 3) == 0; bits >>= 2)
+      height++;
+   return height;
+}
+
+/*****************************************************
+ * SKIP LIST :: UNLOCK
+ * Release the locks on preds[0..height-1], each once
+ ****************************************************/
+template <typename T>
+void skip_list <T> :: unlock(SNode ** preds, int height)
+{
+   for (int level = 0; level < height; level++)
+      if (level == 0 || preds[level] != preds[level - 1])
+         preds[level]->unlock();
+}
+
+
+/*********************************************
+ *********************************************
+ *********************************************
+ ***************** ITERATOR ******************
+ *********************************************
+ *********************************************
+ *********************************************/
+
+
+/**************************************************
+ * SKIP LIST ITERATOR :: INCREMENT PREFIX
+ * Advance to the next present node
+ *************************************************/
+template <typename T>
+typename skip_list <T> :: iterator & skip_list <T> :: iterator :: operator ++ ()
+{
+   if (pNode == nullptr)
+      return *this;
+   do
+      pNode = pNode->next[0].load(std::memory_order_acquire);
+   while (pNode != nullptr &&
+          (pNode->marked.load(std::memory_order_acquire) ||
+           !pNode->fullyLinked.load(std::memory_order_acquire)));
+   repin();
+   return *this;
+}
+
+/**************************************************
+ * SKIP LIST ITERATOR :: REPIN
+ * Move the pin up to the current epoch so a long walk
+ * does not hold back reclamation. That is only safe
+ * while our node is still linked: then it cannot be
+ * retired before the new pin. end() pins nothing
+ *************************************************/
+template <typename T>
+void skip_list <T> :: iterator :: repin()
+{
+   if (pNode == nullptr)
+      pin.release();
+   else if (pin.isStale())
+   {
+      Pin fresh = Pin::enter(pin.pList);
+      if (!pNode->marked.load())
+         pin = std::move(fresh);
+   }
+}
+
+/**************************************************
+ * SKIP LIST ITERATOR :: DECREMENT PREFIX
+ * Back up to the previous node. From end() this
+ * is the last element; from begin() it is end()
+ *************************************************/
+template <typename T>
+typename skip_list <T> :: iterator & skip_list <T> :: iterator :: operator -- ()
+{
+   if (!pin.pinned)
+      pin = Pin::enter(pin.pList);   // from end(), which pins nothing
+   SNode * pPred = pHead;
+   for (int level = maxHeight - 1; level >= 0; level--)
+   {
+      SNode * pCurr = pPred->next[level].load(std::memory_order_acquire);
+      while (pCurr != nullptr && pCurr != pNode &&
+             (pNode == nullptr || pCurr->data() < pNode->data()))
+      {
+         pPred = pCurr;
+         pCurr = pPred->next[level].load(std::memory_order_acquire);
+      }
+   }
+
+   // pPred is the last node smaller than ours. Walk past equal
+   // nodes on the bottom level, remembering the last one present
+   SNode * pLast = nullptr;
+   for (SNode * p = pPred; p != nullptr && p != pNode; p = p->next[0].load(std::memory_order_acquire))
+      if (p != pHead && !p->marked.load(std::memory_order_acquire))
+         pLast = p;
+   pNode = pLast;
+   repin();
+   return *this;
+}
+
+} // namespace custom
@@ -0,0 +1,427 @@
+/***********************************************************************
+ * Header:
+ *    UNROLLED NODE
+ * Summary:
+ *    One node in an unrolled linked list (and the functions to support
+ *    them). Each node holds a small array of elements instead of just
+ *    one, so walking the list follows one pointer per block rather than
+ *    one per element and long lists need far fewer allocations.
+ *
+ *    This will contain the class definition of:
+ *        UnrolledNode : A block of up to N elements in a linked list
+ *    Additionally, it will contain the same functions as node.h
+ *    (copy, assign, insert, remove, size, clear, and display)
+ *    working on UnrolledNode
+ * Author
+ *    Spencer Lamoreaux, Ashlee Hart
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // for ASSERT
+#include <iostream>    // for std::ostream
+#include <new>         // for placement new
+#include <utility>     // for std::move
+
+/*************************************************
+ * UNROLLED BLOCK SIZE
+ * Pick the number of elements per block so that one
+ * block fills about four cache lines, but never
+ * fewer than four elements.
+ *************************************************/
+template <class T>
+constexpr size_t unrolledBlockSize()
+{
+   return (256 - 3 * sizeof(void*)) / sizeof(T) < 4 ?
+      4 : (256 - 3 * sizeof(void*)) / sizeof(T);
+}
+
+/*************************************************
+ * UNROLLED NODE
+ * A node holding between 1 and N elements. Only the
+ * first numElements slots are constructed. Like Node,
+ * the members are public because only the functions
+ * below can make validation decisions.
+ *************************************************/
+template <class T, size_t N = unrolledBlockSize<T>()>
+class UnrolledNode
+{
+public:
+   static_assert(N >= 2, "a block must hold at least two elements to split");
+
+   //
+   // Construct
+   //
+   UnrolledNode() : numElements(0), pNext(nullptr), pPrev(nullptr) {}
+   UnrolledNode(const UnrolledNode &) = delete;
+   UnrolledNode & operator = (const UnrolledNode &) = delete;
+   ~UnrolledNode()
+   {
+      for (size_t i = 0; i < numElements; i++)
+         at(i).~T();
+   }
+
+   //
+   // Access
+   //
+         T & at(size_t i)       { assert(i < numElements); return ((T *)buffer)[i]; }
+   const T & at(size_t i) const { assert(i < numElements); return ((const T *)buffer)[i]; }
+   bool full() const { return numElements == N; }
+
+   //
+   // Insert and remove within the block
+   //
+   void insertAt(size_t index, const T & t);
+   void insertAt(size_t index, T && t);
+   void removeAt(size_t index);
+   void moveTail(size_t from, UnrolledNode * pDestination);
+
+   //
+   // Member variables
+   //
+   alignas(T) unsigned char buffer[N * sizeof(T)]; // raw storage for the elements
+   size_t numElements;                   // slots [0, numElements) are constructed
+   UnrolledNode <T, N> * pNext;          // pointer to next block
+   UnrolledNode <T, N> * pPrev;          // pointer to previous block
+};
+
+/***********************************************
+ * UNROLLED NODE :: INSERT AT
+ * Insert t at position index of this block, shifting
+ * the elements after it up by one. The block must not be full.
+ *   COST   : O(N)
+ **********************************************/
+template <class T, size_t N>
+void UnrolledNode <T, N> :: insertAt(size_t index, T && t)
+{
+   assert(numElements < N && index <= numElements);
+   T * p = (T *)buffer;
+   if (index == numElements)
+   {
+      new ((void *)(p + numElements)) T(std::move(t));
+   }
+   else
+   {
+      new ((void *)(p + numElements)) T(std::move(p[numElements - 1]));
+      for (size_t i = numElements - 1; i > index; i--)
+         p[i] = std::move(p[i - 1]);
+      p[index] = std::move(t);
+   }
+   numElements++;
+}
+
+template <class T, size_t N>
+void UnrolledNode <T, N> :: insertAt(size_t index, const T & t)
+{
+   insertAt(index, T(t));
+}
+
+/***********************************************
+ * UNROLLED NODE :: REMOVE AT
+ * Remove the element at index, shifting the elements
+ * after it down by one
+ *   COST   : O(N)
+ **********************************************/
+template <class T, size_t N>
+void UnrolledNode <T, N> :: removeAt(size_t index)
+{
+   assert(index < numElements);
+   T * p = (T *)buffer;
+   for (size_t i = index; i + 1 < numElements; i++)
+      p[i] = std::move(p[i + 1]);
+   p[--numElements].~T();
+}
+
+/***********************************************
+ * UNROLLED NODE :: MOVE TAIL
+ * Append elements [from, numElements) of this block
+ * to the end of pDestination, then drop them from here
+ *   COST   : O(N)
+ **********************************************/
+template <class T, size_t N>
+void UnrolledNode <T, N> :: moveTail(size_t from, UnrolledNode * pDestination)
+{
+   assert(from <= numElements);
+   assert(pDestination->numElements + (numElements - from) <= N);
+   T * pSrc = (T *)buffer;
+   T * pDes = (T *)pDestination->buffer;
+   for (size_t i = from; i < numElements; i++)
+   {
+      new ((void *)(pDes + pDestination->numElements++)) T(std::move(pSrc[i]));
+      pSrc[i].~T();
+   }
+   numElements = from;
+}
+
+/***********************************************
+ * COPY
+ * Copy the list from the pSource and return
+ * the new list. Every block of the copy is packed
+ * full, so the copy may use fewer blocks than the source.
+ *   INPUT  : the list to be copied
+ *   OUTPUT : return the new list
+ *   COST   : O(n)
+ **********************************************/
+template <class T, size_t N>
+inline UnrolledNode<T, N>* copy(const UnrolledNode<T, N>* pSource)
+{
+   UnrolledNode<T, N>* pHead = nullptr;
+   UnrolledNode<T, N>* pTail = nullptr;
+
+   for (auto pSrc = pSource; pSrc; pSrc = pSrc->pNext)
+      for (size_t i = 0; i < pSrc->numElements; i++)
+      {
+         if (pTail == nullptr || pTail->full())
+         {
+            auto pNew = new UnrolledNode<T, N>;
+            pNew->pPrev = pTail;
+            if (pTail)
+               pTail->pNext = pNew;
+            else
+               pHead = pNew;
+            pTail = pNew;
+         }
+         new ((void *)((T *)pTail->buffer + pTail->numElements)) T(pSrc->at(i));
+         pTail->numElements++;
+      }
+
+   return pHead;
+}
+
+/***********************************************
+ * ASSIGN
+ * Copy the values from pSource into pDestination
+ * reusing the blocks already created in pDestination if
+ * possible. Reused blocks are refilled to capacity and
+ * any blocks left over at the end are freed.
+ *   INPUT  : the list to be copied
+ *   OUTPUT : pDestination holds the same values as pSource
+ *   COST   : O(n)
+ **********************************************/
+template <class T, size_t N>
+inline void assign(UnrolledNode<T, N>* & pDestination, const UnrolledNode<T, N>* pSource)
+{
+   // If the source is null, clear the destination list
+   if (pSource == nullptr)
+   {
+      clear(pDestination);
+      return;
+   }
+
+   UnrolledNode<T, N>* pDes = pDestination;      // block being filled
+   UnrolledNode<T, N>* pDesPrevious = nullptr;   // last block filled
+   size_t iDes = 0;                              // next slot in pDes
+
+   for (auto pSrc = pSource; pSrc; pSrc = pSrc->pNext)
+      for (size_t i = 0; i < pSrc->numElements; i++)
+      {
+         // move on to the next destination block, making one if we ran out
+         if (pDes == nullptr || iDes == N)
+         {
+            if (pDes)
+            {
+               pDesPrevious = pDes;
+               pDes = pDes->pNext;
+            }
+            if (pDes == nullptr)
+            {
+               pDes = new UnrolledNode<T, N>;
+               pDes->pPrev = pDesPrevious;
+               if (pDesPrevious)
+                  pDesPrevious->pNext = pDes;
+               else
+                  pDestination = pDes;
+            }
+            iDes = 0;
+         }
+
+         // overwrite a live slot or construct a new one
+         if (iDes < pDes->numElements)
+            pDes->at(iDes) = pSrc->at(i);
+         else
+         {
+            new ((void *)((T *)pDes->buffer + iDes)) T(pSrc->at(i));
+            pDes->numElements++;
+         }
+         iDes++;
+      }
+
+   // drop any surplus slots in the last block and any surplus blocks
+   while (pDes->numElements > iDes)
+      pDes->removeAt(pDes->numElements - 1);
+   UnrolledNode<T, N>* pSurplus = pDes->pNext;
+   pDes->pNext = nullptr;
+   clear(pSurplus);
+}
+
+/***********************************************
+ * SWAP
+ * Swap the list from LHS to RHS
+ *   COST   : O(1)
+ **********************************************/
+template <class T, size_t N>
+inline void swap(UnrolledNode<T, N>* & pLHS, UnrolledNode<T, N>* & pRHS)
+{
+   std::swap(pLHS, pRHS);
+}
+
+/**********************************************
+ * INSERT
+ * Insert t at position index of the block pCurrent.
+ * If the block is full it is split in half first, except
+ * when appending to the end of the block: then the new
+ * element simply starts a new block, so building a list
+ * front to back leaves every block full.
+ *   INPUT   : pCurrent - the block to insert into (NULL for a new list)
+ *             index - the position within the block, 0..numElements
+ *             t - the value to be inserted
+ *   OUTPUT  : the block now holding t
+ *   COST    : O(N)
+ **********************************************/
+template <class T, size_t N>
+inline UnrolledNode<T, N>* insert(UnrolledNode<T, N>* pCurrent,
+                                  size_t index,
+                                  const T & t)
+{
+   if (pCurrent == nullptr)
+   {
+      pCurrent = new UnrolledNode<T, N>;
+      pCurrent->insertAt(0, t);
+      return pCurrent;
+   }
+
+   assert(index <= pCurrent->numElements);
+   if (!pCurrent->full())
+   {
+      pCurrent->insertAt(index, t);
+      return pCurrent;
+   }
+
+   // full: link a new block after this one
+   auto pNew = new UnrolledNode<T, N>;
+   pNew->pPrev = pCurrent;
+   pNew->pNext = pCurrent->pNext;
+   if (pCurrent->pNext)
+      pCurrent->pNext->pPrev = pNew;
+   pCurrent->pNext = pNew;
+
+   if (index == N)
+   {
+      pNew->insertAt(0, t);
+      return pNew;
+   }
+
+   // split: the upper half moves to the new block
+   pCurrent->moveTail(N / 2, pNew);
+   if (index <= N / 2)
+   {
+      pCurrent->insertAt(index, t);
+      return pCurrent;
+   }
+   pNew->insertAt(index - N / 2, t);
+   return pNew;
+}
+
+/***********************************************
+ * REMOVE
+ * Remove the element at position index of pRemove.
+ * A block that drops below half full is merged with its
+ * successor when the two fit in one block, and a block
+ * that empties is freed.
+ *   INPUT  : the block and the position within it
+ *   OUTPUT : a block still in the list (pRemove if it survived,
+ *            otherwise a neighbor), or NULL if the list is empty
+ *   COST   : O(N)
+ **********************************************/
+template <class T, size_t N>
+inline UnrolledNode<T, N>* remove(UnrolledNode<T, N>* pRemove, size_t index)
+{
+   if (pRemove == nullptr)
+      return nullptr;
+
+   pRemove->removeAt(index);
+
+   // merge with the next block if both are small enough
+   UnrolledNode<T, N>* pNext = pRemove->pNext;
+   if (pRemove->numElements < N / 2 && pNext &&
+       pRemove->numElements + pNext->numElements <= N)
+   {
+      pNext->moveTail(0, pRemove);
+      pRemove->pNext = pNext->pNext;
+      if (pNext->pNext)
+         pNext->pNext->pPrev = pRemove;
+      delete pNext;
+   }
+
+   if (pRemove->numElements > 0)
+      return pRemove;
+
+   // the block is empty: unlink and free it
+   UnrolledNode<T, N>* pReturn = pRemove->pNext ? pRemove->pNext : pRemove->pPrev;
+   if (pRemove->pNext)
+      pRemove->pNext->pPrev = pRemove->pPrev;
+   if (pRemove->pPrev)
+      pRemove->pPrev->pNext = pRemove->pNext;
+   delete pRemove;
+   return pReturn;
+}
+
+/******************************************************
+ * SIZE
+ * Count the elements in an unrolled linked list
+ *  INPUT   : a pointer to the head of the linked list
+ *  OUTPUT  : number of elements
+ *  COST    : O(n / N)
+ ********************************************************/
+template <class T, size_t N>
+inline size_t size(const UnrolledNode<T, N>* pHead)
+{
+   size_t size = 0;
+   for (auto p = pHead; p; p = p->pNext)
+      size += p->numElements;
+   return size;
+}
+
+/***********************************************
+ * DISPLAY
+ * Display all the items in the linked list from here on back
+ *    INPUT  : the output stream
+ *             pointer to the linked list
+ *    OUTPUT : the data from the linked list on the screen
+ *    COST   : O(n)
+ **********************************************/
+template <class T, size_t N>
+inline std::ostream & operator << (std::ostream & out, const UnrolledNode<T, N>* pHead)
+{
+   bool first = true;
+   out << "[";
+   for (auto p = pHead; p; p = p->pNext)
+      for (size_t i = 0; i < p->numElements; i++)
+      {
+         if (!first)
+            out << ", ";
+         out << p->at(i);
+         first = false;
+      }
+   out << "]";
+   return out;
+}
+
+/*****************************************************
+ * FREE DATA
+ * Free all the blocks currently in the linked list
+ *   INPUT   : pointer to the head of the linked list
+ *   OUTPUT  : pHead set to NULL
+ *   COST    : O(n)
+ ****************************************************/
+template <class T, size_t N>
+inline void clear(UnrolledNode<T, N>* & pHead)
+{
+   UnrolledNode<T, N>* pDelete;
+   while (pHead != nullptr)
+   {
+      pDelete = pHead;
+      pHead = pHead->pNext;
+      delete pDelete;
+   }
+}
@@ -320,13 +320,13 @@ template <typename T, typename A>
 vector <T, A> :: vector (vector && rhs)
 {
    data = rhs.data;
-   rhs.data = NULL;
+   rhs.data = nullptr;
 
    numElements = rhs.numElements;
-   rhs.numElements = NULL;
+   rhs.numElements = 0;
 
    numCapacity = rhs.numCapacity;
-   rhs.numCapacity = NULL;
+   rhs.numCapacity = 0;
 }
 
 /*****************************************